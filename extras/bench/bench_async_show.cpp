@@ -0,0 +1,77 @@
+//
+//  bench_async_show.cpp - Frame rate with a synchronous versus an asynchronous (FFXAsyncPixelController) show
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Runs a sketch style loop in real time - update() followed by workMicros of other work (a stand in for drawing, network
+ *  handling, etc.) - against a pixel controller that takes the strip's wire time to show each frame, the way
+ *  FastLED.show() does for WS2812 LEDs (FFX_WIRE_MICROS_PER_LED per pixel).  The output is used directly (sync) and
+ *  wrapped in an FFXAsyncPixelController (async), where the frame is sent while the loop carries on.
+ *
+ *    bench_async_show [numLeds] [workMicros] [seconds]
+ *
+ *  Prints frames shown per second, the average time update() took and how often show() had to wait for the last frame.
+ */
+#include <stdio.h>
+#include <chrono>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXNullPixelController.h"
+#include "FFXAsyncPixelController.h"
+
+/*! Takes the wire time of the strip to show a frame */
+class WirePixelController : public FFXNullPixelController {
+  public:
+    WirePixelController( CRGB *initLeds, uint16_t numLeds ) : FFXNullPixelController( initLeds, numLeds ) { }
+    virtual unsigned long getWireMicros() override { return (unsigned long)getNumLeds() * FFX_WIRE_MICROS_PER_LED + FFX_WIRE_LATCH_MICROS; }
+    virtual void show() override { delayMicroseconds( getWireMicros() ); FFXNullPixelController::show(); }
+    virtual void showChanged( uint16_t firstChanged, uint16_t lastChanged ) override {
+      delayMicroseconds( getWireMicros() );
+      FFXNullPixelController::showChanged( firstChanged, lastChanged );
+    }
+};
+
+static void run( const char *name, uint16_t numLeds, unsigned long workMicros, unsigned long seconds, bool async ) {
+  CRGB *leds = new CRGB[numLeds]();
+  WirePixelController *wire = new WirePixelController( leds, numLeds );
+  FFXAsyncPixelController *asyncPC = async ? new FFXAsyncPixelController( wire ) : nullptr;
+  FFXController *ctrlr = new FFXController();
+  ctrlr->initialize( async ? (FFXPixelController *)asyncPC : wire );
+  FFXBase *fx = new RainbowFX( numLeds );
+  fx->setInterval( 1 );
+  ctrlr->getPrimarySegment()->setFX( fx );
+  ctrlr->getPrimarySegment()->setBrightness( 255 );
+  ctrlr->getStripController()->waitForShow();    // the output's counters belong to the sending thread until it is done
+  unsigned long startShows = wire->getShowCount();
+  unsigned long updates = 0;
+  double updateMicros = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + std::chrono::seconds( seconds );
+  while (std::chrono::steady_clock::now() < end) {
+    auto updateStart = std::chrono::steady_clock::now();
+    ctrlr->update();
+    updateMicros += std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - updateStart ).count();
+    updates++;
+    if (workMicros) { delayMicroseconds( workMicros ); }
+  }
+  ctrlr->getStripController()->waitForShow();
+  double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+  unsigned long shows = wire->getShowCount() - startShows;
+  printf( "%-6s %10.1f %12.1f %10lu %10lu\n", name, shows / elapsed, updateMicros / updates, updates,
+          asyncPC ? asyncPC->getWaitCount() : 0 );
+  delete ctrlr;
+  delete[] leds;
+}
+
+int main( int argc, char **argv ) {
+  uint16_t numLeds = (argc > 1) ? atoi(argv[1]) : 300;
+  unsigned long workMicros = (argc > 2) ? atol(argv[2]) : 5000;
+  unsigned long seconds = (argc > 3) ? atol(argv[3]) : 3;
+  printf( "leds=%u wire_us=%lu work_us=%lu\n", numLeds, (unsigned long)numLeds * FFX_WIRE_MICROS_PER_LED + FFX_WIRE_LATCH_MICROS, workMicros );
+  printf( "%-6s %10s %12s %10s %10s\n", "show", "frames/s", "update_us", "updates", "waits" );
+  run( "sync", numLeds, workMicros, seconds, false );
+  run( "async", numLeds, workMicros, seconds, true );
+  return 0;
+}
@@ -0,0 +1,86 @@
+//
+//  bench_blend.cpp - Measures crossfade blend throughput of each FFXBlend kernel
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Blends two frames of random pixels with every kernel this machine supports, for each fade type, at 100, 1000 and 10000 
+ *  pixels, and reports millions of pixels blended per second.  Before timing, each kernel's output is checked against 
+ *  FFXBase::alphaBlend( CRGB&, CRGB&, ... ) per pixel for every blend amount - the run fails (exit code 1) on any difference.
+ *
+ *    bench_blend [pixelsPerSize]
+ *
+ *  pixelsPerSize is the total number of pixels blended for each measurement (default 50000000).
+ */
+#include <stdio.h>
+#include <chrono>
+#include "FastFX.h"
+#include "FFXBlend.h"
+
+static const uint16_t sizes[] = { 100, 1000, 10000 };
+static const FFXBase::FadeType fadeTypes[] = { FFXBase::FadeType::LINEAR, FFXBase::FadeType::GAMMA, FFXBase::FadeType::CUBIC };
+static const FFXBlend::Kernel kernels[] = { FFXBlend::SCALAR, FFXBlend::SSE2, FFXBlend::AVX2, FFXBlend::NEON };
+
+static void fillRandom( CRGB *leds, uint16_t num ) {
+  for (uint16_t i = 0; i < num; i++) {
+    // mix in some equal pixels so the "neither is brighter" case of the fade types is covered
+    leds[i] = (random8() < 16) ? CRGB(100, 100, 100) : CRGB( random8(), random8(), random8() );
+  }
+}
+
+static bool verify( CRGB *a, CRGB *b, CRGB *dest, uint16_t num ) {
+  for (FFXBase::FadeType fadeUp : fadeTypes) {
+    for (FFXBase::FadeType fadeDown : fadeTypes) {
+      for (uint16_t alpha = 0; alpha < 256; alpha++) {
+        FFXBlend::blend( a, b, dest, num, alpha, fadeUp, fadeDown );
+        for (uint16_t i = 0; i < num; i++) {
+          if (dest[i] != FFXBase::alphaBlend( a[i], b[i], alpha, fadeUp, fadeDown )) {
+            printf( "MISMATCH %s: pixel %u alpha %u fade %s/%s\n", FFXBlend::kernelName(FFXBlend::getKernel()), i, alpha, 
+                    FFXBase::fadeMethodStr(fadeUp).c_str(), FFXBase::fadeMethodStr(fadeDown).c_str() );
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+int main( int argc, char **argv ) {
+  unsigned long long pixelsPerSize = (argc > 1) ? atoll(argv[1]) : 50000000ULL;
+  bool ok = true;
+  FFXBlend::Kernel defaultKernel = FFXBlend::getKernel();
+  CRGB *a = new CRGB[10000];
+  CRGB *b = new CRGB[10000];
+  CRGB *dest = new CRGB[10000];
+  fillRandom( a, 10000 );
+  fillRandom( b, 10000 );
+
+  printf( "default kernel: %s\n", FFXBlend::kernelName(defaultKernel) );
+  printf( "%-8s %-8s %8s %12s\n", "kernel", "fade", "pixels", "Mpx/s" );
+  for (FFXBlend::Kernel kernel : kernels) {
+    if (!FFXBlend::setKernel( kernel )) { continue; }
+    // odd length so every kernel's tail handling is checked too
+    if (!verify( a, b, dest, 1001 )) { ok = false; continue; }
+    for (FFXBase::FadeType fade : fadeTypes) {
+      for (uint16_t size : sizes) {
+        unsigned long reps = (unsigned long)(pixelsPerSize / size);
+        uint8_t alpha = 1;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long r = 0; r < reps; r++) {
+          FFXBlend::blend( a, b, dest, size, alpha, fade, fade );
+          alpha = (alpha == 254) ? 1 : alpha+1;
+        }
+        double secs = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        printf( "%-8s %-8s %8u %12.1f\n", FFXBlend::kernelName(kernel), FFXBase::fadeMethodStr(fade).c_str(), size, 
+                (double)reps*size / secs / 1e6 );
+      }
+    }
+  }
+  FFXBlend::setKernel( defaultKernel );
+  delete[] a;
+  delete[] b;
+  delete[] dest;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,352 @@
+//
+//  bench_check.cpp - Benchmark regression check against a stored baseline
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Runs a fixed set of controller scenarios under a virtual clock and compares the median time per update() with a
+ *  baseline file (extras/bench/baseline.json).  Any scenario slower than its baseline by more than the tolerance fails the
+ *  check - so the performance cost of a change (or of taking an upstream change) shows up as a failing build step:
+ *
+ *    cmake --build build --target check_benchmarks          (see FFX_BENCH_TOLERANCE in CMakeLists.txt)
+ *    cmake --build build --target update_bench_baseline     (after a deliberate change, or on a new machine)
+ *
+ *    bench_check [--baseline file] [--update] [--tolerance pct] [--reps n] [--warmup n] [--filter text]
+ *
+ *  Each scenario is set up once, run for --warmup untimed repetitions (so buffers are allocated, fades have finished and
+ *  caches are warm) and then timed for --reps repetitions of a fixed number of updates, taken round robin across the
+ *  scenarios.  The median, 10th and 90th percentile of ns per update over the repetitions are reported - the median is
+ *  what is compared, so a few repetitions disturbed by other work on a noisy machine don't fail the check.
+ *
+ *  Scenarios:
+ *
+ *    calibrate           - fixed integer and memory work, no FastFX code.  Baselines are scaled by how much slower or
+ *                          faster this runs than when the baseline was recorded, so a baseline from another machine is
+ *                          still a reasonable guide (recording a local baseline is better).
+ *    fx_*                - single core effects through FFXController::update()
+ *    provider_crossfade  - FFXFrameProvider blending every update (slow effect, crossfade on)
+ *    provider_direct     - FFXFrameProvider in direct mode (crossfade off, rotating effect)
+ *    segments_64         - 64 side by side segments, alternately opaque and translucent
+ *    segments_256_overlap- 256 overlapping segments
+ *    overlay_storm       - 32 segments that start a new overlay as soon as their last one completes, plus a primary
+ *                          overlay restarted every 50 updates
+ *    speed_sweep         - 16 segments sweeping their effect speed back and forth across the crossfade threshold, so
+ *                          crossfade is turned on and off (buffers allocated and released) over and over
+ *
+ *  Exits with 1 if any scenario regressed, 2 if the baseline couldn't be read or written.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXTestEffects.h"
+#include "FFXNullPixelController.h"
+
+struct Scenario {
+  const char *name;
+  uint16_t numLeds;
+  uint16_t numSegments;               // buffer pool is sized for these
+  unsigned long updates;              // per repetition - a whole cycle of any changes tick() makes, so each repetition does the same work
+  void (*setup)( FFXController *ctrlr );
+  void (*tick)( FFXController *ctrlr, unsigned long count );   // called before each update (may be null)
+};
+
+struct ScenarioResult {
+  String name;
+  double median = 0;
+  double p10 = 0;
+  double p90 = 0;
+  double baseline = 0;                // 0 - not in the baseline
+};
+
+static void addZones( FFXController *ctrlr, uint16_t numSegments, bool overlap ) {
+  uint16_t numLeds = ctrlr->getStripController()->getNumLeds();
+  uint16_t zone = numLeds / numSegments;
+  for (uint16_t i = 0; i < numSegments; i++) {
+    uint16_t first = i*zone;
+    uint16_t last = overlap ? minimum<uint16_t>( first+2*zone-1, numLeds-1 ) : first+zone-1;
+    FFXSegment *seg = ctrlr->addSegment( String("zone") + String(i), first, last );
+    seg->setFX( createFX( i, seg->getLength() ) );
+    seg->setOpacity( (i % 2) ? 255 : 160 );
+  }
+}
+
+static void setupRainbow( FFXController *ctrlr ) { ctrlr->getPrimarySegment()->setFX( new RainbowFX( ctrlr->getPrimarySegment()->getLength() ) ); }
+static void setupPacifica( FFXController *ctrlr ) { ctrlr->getPrimarySegment()->setFX( new PacificaFX( ctrlr->getPrimarySegment()->getLength() ) ); }
+static void setupFire( FFXController *ctrlr ) { ctrlr->getPrimarySegment()->setFX( new FireFX( ctrlr->getPrimarySegment()->getLength() ) ); }
+static void setupTwinkle( FFXController *ctrlr ) { ctrlr->getPrimarySegment()->setFX( new TwinkleFX( ctrlr->getPrimarySegment()->getLength() ) ); }
+
+static void setupCrossFade( FFXController *ctrlr ) {
+  FFXSegment *primary = ctrlr->getPrimarySegment();
+  FFXBase *fx = new CylonFX( primary->getLength() );
+  fx->setInterval( 100 );
+  primary->setFX( fx );
+  primary->getFrameProvider()->setCrossFadePref( true );
+}
+
+static void setupDirect( FFXController *ctrlr ) {
+  FFXSegment *primary = ctrlr->getPrimarySegment();
+  primary->setFX( new ChaseFX( primary->getLength() ) );
+  primary->getFrameProvider()->setCrossFadePref( false );
+}
+
+static void setupSegments64( FFXController *ctrlr ) {
+  ctrlr->getPrimarySegment()->setFX( new RainbowFX( ctrlr->getPrimarySegment()->getLength() ) );
+  addZones( ctrlr, 64, false );
+}
+
+static void setupSegments256( FFXController *ctrlr ) {
+  ctrlr->getPrimarySegment()->setFX( new RainbowFX( ctrlr->getPrimarySegment()->getLength() ) );
+  addZones( ctrlr, 256, true );
+}
+
+static void setupOverlayStorm( FFXController *ctrlr ) {
+  ctrlr->getPrimarySegment()->setFX( new PaletteFX( ctrlr->getPrimarySegment()->getLength() ) );
+  addZones( ctrlr, 32, false );
+}
+
+static void tickOverlayStorm( FFXController *ctrlr, unsigned long count ) {
+  for (uint16_t i = 1; i < ctrlr->getSegmentCount(); i++) {
+    FFXSegment *seg = ctrlr->getSegment( i );
+    if (!seg->getOverlay()) { seg->setOverlay( createOverlay( i+count, seg->getLength(), 240, 1 ) ); }
+  }
+  if (count % 50 == 0) { ctrlr->setOverlayFX( createOverlay( count/50, ctrlr->getPrimarySegment()->getLength(), 240, 1 ) ); }
+}
+
+static void setupSpeedSweep( FFXController *ctrlr ) {
+  ctrlr->getPrimarySegment()->setFX( new RainbowFX( ctrlr->getPrimarySegment()->getLength() ) );
+  addZones( ctrlr, 16, false );
+  for (uint16_t i = 1; i < ctrlr->getSegmentCount(); i++) {
+    ctrlr->getSegment( i )->getFrameProvider()->setCrossFadePref( true );
+  }
+}
+
+static void tickSpeedSweep( FFXController *ctrlr, unsigned long count ) {
+  if (count % 10 == 0) {
+    for (uint16_t i = 1; i < ctrlr->getSegmentCount(); i++) {
+      // triangle wave over the whole speed range (2560 updates per sweep) - the interval crosses the crossfade threshold
+      // twice per sweep
+      uint8_t phase = (count/10 + i*16) & 0xFF;
+      ctrlr->getSegment( i )->getFX()->setSpeed( (phase < 128) ? phase*2 : (255-phase)*2 );
+    }
+  }
+}
+
+static const Scenario scenarios[] = {
+  { "fx_rainbow_300",       300,   0,   5000, setupRainbow,      nullptr },
+  { "fx_pacifica_1000",     1000,  0,   200,  setupPacifica,     nullptr },
+  { "fx_fire_300",          300,   0,   3000, setupFire,         nullptr },
+  { "fx_twinkle_1000",      1000,  0,   3000,  setupTwinkle,      nullptr },
+  { "provider_crossfade",   1000,  0,   5000, setupCrossFade,    nullptr },
+  { "provider_direct",      1000,  0,   5000, setupDirect,       nullptr },
+  { "segments_64",          4096,  64,  200,  setupSegments64,   nullptr },
+  { "segments_256_overlap", 4096,  256, 100,  setupSegments256,  nullptr },
+  { "overlay_storm",        1000,  32,  2000, setupOverlayStorm, tickOverlayStorm },
+  { "speed_sweep",          1000,  16,  2560, setupSpeedSweep,   tickSpeedSweep },
+};
+
+static double percentile( std::vector<double> sorted, double pct ) {
+  if (sorted.empty()) { return 0; }
+  double pos = pct/100.0 * (sorted.size()-1);
+  size_t i = (size_t)pos;
+  if (i+1 >= sorted.size()) { return sorted.back(); }
+  return sorted[i] + (sorted[i+1]-sorted[i]) * (pos-i);
+}
+
+static ScenarioResult summarize( const char *name, std::vector<double> &samples ) {
+  std::sort( samples.begin(), samples.end() );
+  ScenarioResult result;
+  result.name = name;
+  result.median = percentile( samples, 50 );
+  result.p10 = percentile( samples, 10 );
+  result.p90 = percentile( samples, 90 );
+  return result;
+}
+
+static double elapsedNanos( std::chrono::steady_clock::time_point start ) {
+  return std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+}
+
+static volatile uint32_t calibrateSink = 0;
+
+/*! One scenario's controller, set up once and then timed a repetition at a time */
+class ScenarioRun {
+  public:
+    ScenarioRun( const Scenario *initScenario ) : scenario(initScenario) {
+      FlexClock::setClock( &vclock );
+      random16_set_seed( 1337 );
+      leds = new CRGB[scenario->numLeds]();
+      ctrlr = new FFXController();
+      ctrlr->initialize( new FFXNullPixelController( leds, scenario->numLeds ), 2*scenario->numSegments+FFX_BUFFER_POOL_FRAMES );
+      ctrlr->setBrightness( 255 );
+      scenario->setup( ctrlr );
+      // let opacity and brightness fades finish before the warm-up repetitions
+      for (int t = 0; t < 1000; t++) { ctrlr->update(); vclock.advance( 1 ); }
+      FlexClock::setClock( nullptr );
+    }
+    ~ScenarioRun() {
+      delete ctrlr;
+      delete[] leds;
+    }
+    /*! Time one repetition - ns per update */
+    double run() {
+      FlexClock::setClock( &vclock );
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned long t = 0; t < scenario->updates; t++) {
+        if (scenario->tick) { scenario->tick( ctrlr, count ); }
+        count++;
+        ctrlr->update();
+        vclock.advance( 1 );
+      }
+      double ns = elapsedNanos( start ) / scenario->updates;
+      FlexClock::setClock( nullptr );
+      return ns;
+    }
+    const Scenario *scenario;
+    std::vector<double> samples;
+
+  private:
+    VirtualClock vclock;
+    CRGB *leds = nullptr;
+    FFXController *ctrlr = nullptr;
+    unsigned long count = 0;
+};
+
+/*! Fixed integer and memory work - ns per pass */
+static double runCalibrate() {
+  static uint8_t a[16384], b[16384];
+  auto start = std::chrono::steady_clock::now();
+  uint32_t x = calibrateSink+1;
+  for (int n = 0; n < 50; n++) {
+    for (size_t i = 0; i < sizeof(a); i++) { x = x*1664525UL + 1013904223UL; a[i] = (uint8_t)(x >> 24) ^ b[(i*7) & (sizeof(b)-1)]; }
+    memcpy( b, a, sizeof(a) );
+  }
+  calibrateSink = calibrateSink + x + b[x & 255];
+  return elapsedNanos( start ) / 50;
+}
+
+static bool loadBaseline( const char *path, std::vector<ScenarioResult> &baseline ) {
+  FILE *in = fopen( path, "r" );
+  if (!in) { return false; }
+  char line[512];
+  while (fgets( line, sizeof(line), in )) {
+    // one scenario per line: { "scenario": "name", "median_ns": 123.4, ... }
+    char *name = strstr( line, "\"scenario\"" );
+    char *median = strstr( line, "\"median_ns\"" );
+    if (!name || !median) { continue; }
+    name = strchr( name + strlen("\"scenario\""), '"' );
+    char *nameEnd = name ? strchr( name+1, '"' ) : nullptr;
+    median = strchr( median, ':' );
+    if (!nameEnd || !median) { continue; }
+    ScenarioResult entry;
+    entry.name = String( std::string( name+1, nameEnd-name-1 ) );
+    entry.median = strtod( median+1, nullptr );
+    baseline.push_back( entry );
+  }
+  fclose( in );
+  return !baseline.empty();
+}
+
+static bool saveBaseline( const char *path, const std::vector<ScenarioResult> &results ) {
+  FILE *out = fopen( path, "w" );
+  if (!out) { return false; }
+  fprintf( out, "{\n  \"benchmark\": \"bench_check\",\n  \"compiler\": \"%s\",\n  \"scenarios\": [\n", __VERSION__ );
+  for (size_t i = 0; i < results.size(); i++) {
+    const ScenarioResult &r = results[i];
+    fprintf( out, "    { \"scenario\": \"%s\", \"median_ns\": %.1f, \"p10_ns\": %.1f, \"p90_ns\": %.1f }%s\n",
+             r.name.c_str(), r.median, r.p10, r.p90, (i+1 < results.size()) ? "," : "" );
+  }
+  fprintf( out, "  ]\n}\n" );
+  return fclose( out ) == 0;
+}
+
+int main( int argc, char **argv ) {
+  const char *baselinePath = "baseline.json";
+  bool update = false;
+  double tolerance = 20;
+  unsigned int reps = 21;
+  unsigned int warmup = 5;
+  const char *filter = nullptr;
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    bool hasValue = (i+1 < argc);
+    if (arg=="--baseline" && hasValue)       { baselinePath = argv[++i]; }
+    else if (arg=="--update")                { update = true; }
+    else if (arg=="--tolerance" && hasValue) { tolerance = atof( argv[++i] ); }
+    else if (arg=="--reps" && hasValue)      { reps = atoi( argv[++i] ); }
+    else if (arg=="--warmup" && hasValue)    { warmup = atoi( argv[++i] ); }
+    else if (arg=="--filter" && hasValue)    { filter = argv[++i]; }
+    else {
+      fprintf( stderr, "usage: bench_check [--baseline file] [--update] [--tolerance pct] [--reps n] [--warmup n] [--filter text]\n" );
+      return 2;
+    }
+  }
+
+  if (reps == 0) { reps = 1; }
+  if (update && filter) {
+    fprintf( stderr, "--update records every scenario - it can't be combined with --filter\n" );
+    return 2;
+  }
+  std::vector<ScenarioResult> baseline;
+  if (!update && !loadBaseline( baselinePath, baseline )) {
+    fprintf( stderr, "Can't read baseline %s - run with --update to record one\n", baselinePath );
+    return 2;
+  }
+  auto findBaseline = [&]( const String &name ) -> double {
+    for (const ScenarioResult &entry : baseline) { if (entry.name == name) { return entry.median; } }
+    return 0;
+  };
+
+  // Every scenario is set up first and the repetitions are taken round robin (with a calibrate pass in each round), so a
+  // stretch of time when the machine is busy with something else slows all of them a little rather than one a lot.
+  std::vector<ScenarioRun *> runs;
+  for (const Scenario &scenario : scenarios) {
+    if (!filter || strstr( scenario.name, filter )) { runs.push_back( new ScenarioRun( &scenario ) ); }
+  }
+  std::vector<double> calibrateSamples;
+  for (unsigned int r = 0; r < warmup+reps; r++) {
+    double calibrate = runCalibrate();
+    if (r >= warmup) { calibrateSamples.push_back( calibrate ); }
+    for (ScenarioRun *run : runs) {
+      double ns = run->run();
+      if (r >= warmup) { run->samples.push_back( ns ); }
+    }
+  }
+
+  std::vector<ScenarioResult> results;
+  results.push_back( summarize( "calibrate", calibrateSamples ) );
+  double scale = 1.0;
+  double baseCalibrate = findBaseline( "calibrate" );
+  if (baseCalibrate > 0) { scale = results[0].median / baseCalibrate; }
+
+  printf( "reps=%u warmup=%u tolerance=%.0f%% machine_scale=%.2f\n", reps, warmup, tolerance, scale );
+  printf( "%-22s %12s %12s %12s %12s %8s\n", "scenario", "median_ns", "p10_ns", "p90_ns", "baseline_ns", "change" );
+  int regressions = 0;
+  for (ScenarioRun *run : runs) {
+    ScenarioResult result = summarize( run->scenario->name, run->samples );
+    delete run;
+    result.baseline = findBaseline( result.name ) * scale;
+    char change[16] = "new";
+    const char *status = "";
+    if (result.baseline > 0) {
+      double pct = (result.median / result.baseline - 1.0) * 100.0;
+      snprintf( change, sizeof(change), "%+.1f%%", pct );
+      if (pct > tolerance) { status = "  REGRESSED"; regressions++; }
+      else if (pct < -tolerance) { status = "  faster - consider --update"; }
+    }
+    printf( "%-22s %12.1f %12.1f %12.1f %12.1f %8s%s\n", result.name.c_str(), result.median, result.p10, result.p90,
+            result.baseline, change, status );
+    results.push_back( result );
+  }
+
+  if (update) {
+    if (!saveBaseline( baselinePath, results )) { fprintf( stderr, "Can't write %s\n", baselinePath ); return 2; }
+    printf( "baseline written to %s\n", baselinePath );
+    return 0;
+  }
+  printf( "%d scenario%s regressed by more than %.0f%%\n", regressions, (regressions == 1) ? "" : "s", tolerance );
+  return regressions ? 1 : 0;
+}
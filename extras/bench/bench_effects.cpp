@@ -0,0 +1,147 @@
+//
+//  bench_effects.cpp - Per-effect cost of the core effects and overlays
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Times every effect in FFXCoreEffects.h (and the wave, pulse and zip overlays) at 60, 300, 1000 and 10000 pixels, three
+ *  ways:
+ *
+ *    effect      - the effect on its own - FFXBase::update() into a frame buffer, i.e. writeNextFrame() plus the phase
+ *                  and cycle bookkeeping around it
+ *    crossfade   - a full FFXController::update() with the effect on the primary segment, crossfade on
+ *    direct      - the same with crossfade off (the segment draws straight into the LED buffer)
+ *
+ *  The overlays run over a SolidFX primary segment in the update cases.  Under a virtual clock, each update advances the clock
+ *  by the effect's interval, so every update draws one new frame.
+ *
+ *    bench_effects [json_file] [scale]
+ *
+ *  Prints ns per frame and ns per pixel for each effect, size and mode, and writes the same results as JSON to json_file
+ *  ("-" for stdout only) so runs from different commits can be compared.  scale multiplies the number of frames timed
+ *  (default 1.0 - about 3 million pixels for each measurement).
+ */
+#include <stdio.h>
+#include <chrono>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXTestEffects.h"
+#include "FFXNullPixelController.h"
+
+static const char *effectNames[] = { "solid", "palette", "chase", "motion", "rainbow", "juggle", "cylon", "cycle", "twinkle", "dim",
+                                     "pacifica", "fire", "wave", "pulse", "zip" };
+static const uint16_t sizes[] = { 60, 300, 1000, 10000 };
+static const char *modeNames[] = { "effect", "crossfade", "direct" };
+
+struct EffectResult {
+  const char *effect;
+  uint16_t numLeds;
+  const char *mode;
+  unsigned long frames;
+  double nsPerFrame;
+  double nsPerPixel;
+};
+
+// overlays repeat (nearly) for good, so they don't complete part way through a measurement
+static FFXBase *createBenchFX( const String &name, uint16_t size ) {
+  return isOverlay( name ) ? (FFXBase *)createOverlay( name, size, 220, 255 ) : createFX( name, size );
+}
+
+static void advanceInterval( VirtualClock &vclock, FFXBase *fx ) {
+  unsigned long us = fx->getIntervalTicks() * (1000UL / FLEX_TICKS_PER_MS);
+  vclock.advanceMicros( us ? us : 1 );
+}
+
+static double elapsedNanos( std::chrono::steady_clock::time_point start ) {
+  return std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+}
+
+static EffectResult timeEffect( const char *name, uint16_t numLeds, unsigned long frames, VirtualClock &vclock ) {
+  CRGB *buffer = new CRGB[numLeds]();
+  FFXBase *fx = createBenchFX( name, numLeds );
+  fx->start();
+  for (unsigned long i = 0; i < frames/10+1; i++) { fx->update( buffer ); advanceInterval( vclock, fx ); }
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < frames; i++) { fx->update( buffer ); advanceInterval( vclock, fx ); }
+  double ns = elapsedNanos( start );
+  delete fx;
+  delete[] buffer;
+  return { name, numLeds, modeNames[0], frames, ns/frames, ns/frames/numLeds };
+}
+
+static EffectResult timeUpdate( const char *name, uint16_t numLeds, unsigned long frames, bool crossFade, VirtualClock &vclock ) {
+  CRGB *leds = new CRGB[numLeds]();
+  FFXController *ctrlr = new FFXController();
+  ctrlr->initialize( new FFXNullPixelController( leds, numLeds ) );
+  FFXSegment *primary = ctrlr->getPrimarySegment();
+  FFXBase *fx = createBenchFX( name, numLeds );
+  if (isOverlay( name )) {
+    primary->setFX( new SolidFX( numLeds ) );
+    primary->setOverlay( (FFXOverlay *)fx );
+  }
+  else {
+    primary->setFX( fx );
+  }
+  primary->getFrameProvider()->setCrossFadePref( crossFade );
+  ctrlr->setBrightness( 255 );
+  // let the effect start and the dimmer reach full brightness before timing
+  for (int i = 0; i < 1000; i++) { ctrlr->update(); vclock.advance( 1 ); }
+  for (unsigned long i = 0; i < frames/10+1; i++) { ctrlr->update(); advanceInterval( vclock, fx ); }
+  unsigned long startSteps = fx->getSteps();
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < frames; i++) { ctrlr->update(); advanceInterval( vclock, fx ); }
+  double ns = elapsedNanos( start );
+  unsigned long drawn = fx->getSteps() - startSteps;
+  if (drawn == 0) { drawn = 1; }
+  delete ctrlr;
+  delete[] leds;
+  return { name, numLeds, modeNames[crossFade ? 1 : 2], drawn, ns/drawn, ns/drawn/numLeds };
+}
+
+static void writeJSON( FILE *out, const std::vector<EffectResult> &results ) {
+  fprintf( out, "{\n  \"benchmark\": \"bench_effects\",\n  \"compiler\": \"%s\",\n  \"results\": [\n", __VERSION__ );
+  for (size_t i = 0; i < results.size(); i++) {
+    const EffectResult &r = results[i];
+    fprintf( out, "    { \"effect\": \"%s\", \"leds\": %u, \"mode\": \"%s\", \"frames\": %lu, \"ns_per_frame\": %.1f, \"ns_per_pixel\": %.3f }%s\n",
+             r.effect, r.numLeds, r.mode, r.frames, r.nsPerFrame, r.nsPerPixel, (i+1 < results.size()) ? "," : "" );
+  }
+  fprintf( out, "  ]\n}\n" );
+}
+
+int main( int argc, char **argv ) {
+  const char *jsonPath = (argc > 1) ? argv[1] : "-";
+  double scale = (argc > 2) ? atof(argv[2]) : 1.0;
+  bool jsonOnly = String(jsonPath) == "-";
+
+  VirtualClock vclock;
+  FlexClock::setClock( &vclock );
+  std::vector<EffectResult> results;
+  if (!jsonOnly) { printf( "%-10s %6s %-10s %8s %14s %12s\n", "effect", "leds", "mode", "frames", "ns/frame", "ns/pixel" ); }
+  for (const char *name : effectNames) {
+    for (uint16_t numLeds : sizes) {
+      unsigned long frames = (unsigned long)(scale * 3000000.0 / numLeds);
+      if (frames < 20) { frames = 20; }
+      results.push_back( timeEffect( name, numLeds, frames, vclock ) );
+      results.push_back( timeUpdate( name, numLeds, frames, true, vclock ) );
+      results.push_back( timeUpdate( name, numLeds, frames, false, vclock ) );
+      if (!jsonOnly) {
+        for (size_t i = results.size()-3; i < results.size(); i++) {
+          const EffectResult &r = results[i];
+          printf( "%-10s %6u %-10s %8lu %14.1f %12.3f\n", r.effect, r.numLeds, r.mode, r.frames, r.nsPerFrame, r.nsPerPixel );
+        }
+      }
+    }
+  }
+  FlexClock::setClock( nullptr );
+  if (jsonOnly) {
+    writeJSON( stdout, results );
+  }
+  else {
+    FILE *out = fopen( jsonPath, "w" );
+    if (!out) { fprintf( stderr, "Can't write %s\n", jsonPath ); return 1; }
+    writeJSON( out, results );
+    fclose( out );
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+//
+//  bench_frame_copy.cpp - Measures pixel data moved per frame by the frame provider
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Runs each core effect on a single segment (crossfade on by default) under a virtual clock and reports the bytes moved through 
+ *  memmove8/memcpy8 per controller tick and per effect frame.  The host shim counts every call, so this covers the
+ *  frame provider, the copy into the live LED buffer and anything the effects move themselves.
+ *
+ *    bench_frame_copy [numLeds] [ms] [direct]
+ *
+ *  Passing "direct" turns crossfade off so the segment renders straight into the LED buffer (FFXFrameProvider direct mode).
+ */
+#include <stdio.h>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXTestEffects.h"
+#include "FFXNullPixelController.h"
+
+static const char *effectNames[] = { "solid", "palette", "chase", "motion", "rainbow", "juggle", "cylon", "cycle", "twinkle", "dim", "pacifica", "fire" };
+
+int main( int argc, char **argv ) {
+  uint16_t numLeds = (argc > 1) ? atoi(argv[1]) : 2000;
+  unsigned long runMs = (argc > 2) ? atol(argv[2]) : 10000;
+  bool direct = (argc > 3) && (String(argv[3]) == "direct");
+
+  VirtualClock vclock;
+  FlexClock::setClock( &vclock );
+
+  printf( "%-10s %8s %8s %12s %12s %7s\n", "effect", "ticks", "frames", "bytes/tick", "bytes/frame", "direct" );
+  for (const char *name : effectNames) {
+    CRGB *leds = new CRGB[numLeds];
+    FFXController ctrlr = FFXController();
+    ctrlr.initialize( new FFXNullPixelController( leds, numLeds ) );
+    FFXBase *fx = createFX( name, numLeds );
+    ctrlr.getPrimarySegment()->setFX( fx );
+    ctrlr.setBrightness( 255 );
+    if (direct) { ctrlr.getPrimarySegment()->getFrameProvider()->setCrossFadePref( false ); }
+    // let the effect start and the dimmer reach full brightness before measuring
+    for (int i = 0; i < 1000; i++) { ctrlr.update(); vclock.advance( 1 ); }
+
+    unsigned long startFrames = fx->getSteps();
+    unsigned long long startBytes = ffxHostBytesMoved;
+    for (unsigned long t = 0; t < runMs; t++) {
+      ctrlr.update();
+      vclock.advance( 1 );
+    }
+    unsigned long frames = fx->getSteps() - startFrames;
+    unsigned long long bytes = ffxHostBytesMoved - startBytes;
+    printf( "%-10s %8lu %8lu %12llu %12llu %7s\n", name, runMs, frames, bytes/runMs, (frames ? bytes/frames : 0),
+            (ctrlr.getPrimarySegment()->getFrameProvider()->isDirect() ? "yes" : "no") );
+    delete[] leds;
+  }
+  FlexClock::setClock( nullptr );
+  return 0;
+}
@@ -0,0 +1,80 @@
+//
+//  bench_multi_output.cpp - Frame rate of one controller driving several outputs (FFXMultiPixelController)
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Splits a strip over numOutputs outputs that each take their wire time to show a frame (FFX_WIRE_MICROS_PER_LED per
+ *  pixel, like WS2812 strips), with segments that span the boundaries between outputs, and runs update() in real time with
+ *  the outputs sent one after another (serial) and all at once (parallel - each from its own FFXAsyncPixelController).
+ *
+ *    bench_multi_output [numOutputs] [ledsPerOutput] [seconds]
+ *
+ *  Prints frames per second for each, and checks that every output ends up showing its part of the controller's pixels.
+ */
+#include <stdio.h>
+#include <chrono>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXNullPixelController.h"
+#include "FFXMultiPixelController.h"
+
+/*! Takes the wire time of the strip to show a frame */
+class WirePixelController : public FFXNullPixelController {
+  public:
+    WirePixelController( CRGB *initLeds, uint16_t numLeds ) : FFXNullPixelController( initLeds, numLeds ) { }
+    virtual unsigned long getWireMicros() override { return (unsigned long)getNumLeds() * FFX_WIRE_MICROS_PER_LED + FFX_WIRE_LATCH_MICROS; }
+    virtual void show() override { delayMicroseconds( getWireMicros() ); FFXNullPixelController::show(); }
+    virtual void showChanged( uint16_t firstChanged, uint16_t lastChanged ) override {
+      delayMicroseconds( getWireMicros() );
+      FFXNullPixelController::showChanged( firstChanged, lastChanged );
+    }
+};
+
+static void run( const char *name, uint8_t numOutputs, uint16_t ledsPerOutput, unsigned long seconds, bool parallel ) {
+  uint16_t numLeds = numOutputs * ledsPerOutput;
+  FFXMultiPixelController *multi = new FFXMultiPixelController( nullptr, numLeds );
+  std::vector<CRGB *> outputLeds;
+  for (uint8_t i = 0; i < numOutputs; i++) {
+    outputLeds.push_back( new CRGB[ledsPerOutput]() );
+    multi->addOutput( new WirePixelController( outputLeds.back(), ledsPerOutput ), i*ledsPerOutput, parallel );
+  }
+  FFXController *ctrlr = new FFXController();
+  ctrlr->initialize( multi );
+  ctrlr->getPrimarySegment()->setFX( new RainbowFX( numLeds ) );
+  ctrlr->getPrimarySegment()->setBrightness( 255 );
+  // segments straddling each boundary between outputs
+  for (uint8_t i = 1; i < numOutputs; i++) {
+    FFXSegment *seg = ctrlr->addSegment( String("span") + String(i), i*ledsPerOutput - ledsPerOutput/4, i*ledsPerOutput + ledsPerOutput/4 - 1 );
+    seg->setFX( new CylonFX( seg->getLength() ) );
+    seg->setOpacity( 255 );
+  }
+  multi->waitForShow();           // the outputs' counters belong to their sending threads until they are done
+  unsigned long startShows = ((WirePixelController *)multi->getOutput( 0 ))->getShowCount();
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + std::chrono::seconds( seconds );
+  while (std::chrono::steady_clock::now() < end) { ctrlr->update(); }
+  multi->show();
+  multi->waitForShow();
+  double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+  unsigned long shows = ((WirePixelController *)multi->getOutput( 0 ))->getShowCount() - startShows;
+  bool match = true;
+  for (uint8_t i = 0; i < numOutputs; i++) {
+    match = match && (memcmp( (void *)outputLeds[i], (void *)&(multi->getLeds()[i*ledsPerOutput]), ledsPerOutput*sizeof(CRGB) ) == 0);
+  }
+  printf( "%-9s %10.1f %10lu %8s\n", name, shows / elapsed, multi->getWireMicros(), match ? "yes" : "NO" );
+  delete ctrlr;
+  for (CRGB *leds : outputLeds) { delete[] leds; }
+}
+
+int main( int argc, char **argv ) {
+  uint8_t numOutputs = (argc > 1) ? atoi(argv[1]) : 8;
+  uint16_t ledsPerOutput = (argc > 2) ? atoi(argv[2]) : 300;
+  unsigned long seconds = (argc > 3) ? atol(argv[3]) : 3;
+  printf( "outputs=%u leds_per_output=%u\n", numOutputs, ledsPerOutput );
+  printf( "%-9s %10s %10s %8s\n", "outputs", "frames/s", "wire_us", "match" );
+  run( "serial", numOutputs, ledsPerOutput, seconds, false );
+  run( "parallel", numOutputs, ledsPerOutput, seconds, true );
+  return 0;
+}
@@ -0,0 +1,73 @@
+//
+//  bench_pool_soak.cpp - Long running allocation churn against the controller's buffer pool
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Runs a controller with a few segments for a number of (virtual) days, and once a minute does the things that allocate
+ *  pixel buffers: toggles crossfade, changes effect speed (which can toggle crossfade), fades opacity in and out, starts
+ *  overlays and swaps effects.  Once every simulated hour it prints the buffer pool statistics (see FFXBufferPool).
+ *
+ *    bench_pool_soak [days] [numLeds] [poolFrames] [stepMs]
+ *
+ *  Exits with code 1 if the pool's heap high water mark grew after the first hour - i.e. heap use is not flat.
+ */
+#include <stdio.h>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXTestEffects.h"
+#include "FFXNullPixelController.h"
+
+int main( int argc, char **argv ) {
+  unsigned long days = (argc > 1) ? atol(argv[1]) : 3;
+  uint16_t numLeds = (argc > 2) ? atoi(argv[2]) : 60;
+  uint16_t poolFrames = (argc > 3) ? atoi(argv[3]) : FFX_BUFFER_POOL_FRAMES+3;
+  unsigned long stepMs = (argc > 4) ? atol(argv[4]) : 20;
+
+  VirtualClock vclock;
+  FlexClock::setClock( &vclock );
+  CRGB *leds = new CRGB[numLeds];
+  FFXController ctrlr = FFXController();
+  ctrlr.initialize( new FFXNullPixelController( leds, numLeds ), poolFrames );
+  ctrlr.getPrimarySegment()->setFX( new PaletteFX( numLeds ) );
+  ctrlr.setBrightness( 200 );
+  FFXSegment *left = ctrlr.addSegment( "left", 0, numLeds/3 );
+  FFXSegment *right = ctrlr.addSegment( "right", numLeds-numLeds/3, numLeds-1 );
+  left->setFX( new CylonFX( left->getLength() ) );
+  right->setFX( new JuggleFX( right->getLength() ) );
+  FFXBufferPool *pool = ctrlr.getBufferPool();
+
+  printf( "arena %lu bytes\n", (unsigned long)pool->getArenaSize() );
+  printf( "%6s %10s %10s %10s %12s %10s\n", "hour", "in_use", "high_water", "heap", "heap_high", "heap_allocs" );
+  size_t firstHourHeapHigh = 0;
+  unsigned long minute = 0;
+  unsigned long long endMs = days*24ULL*3600000ULL;
+  for (unsigned long long t = 0; t < endMs; t += stepMs) {
+    ctrlr.update();
+    vclock.advance( stepMs );
+    if (t / 60000 != minute) {
+      minute = t / 60000;
+      FFXSegment *seg = (minute % 2) ? left : right;
+      switch (minute % 6) {
+        case 0 : { seg->getFrameProvider()->setCrossFadePref( !seg->getFrameProvider()->getCrossFadePref() ); break; }
+        case 1 : { seg->getFX()->setSpeed( random8() ); break; }
+        case 2 : { seg->setOpacity( seg->getOpacity() ? 0 : 255 ); break; }
+        case 3 : { ctrlr.setOverlayFX( new PulseOverlayFX( numLeds, 200, 1, NamedPalettes::getInstance()["blue"] ) ); break; }
+        case 4 : { seg->setOverlay( new ZipOverlayFX( seg->getLength(), 200, 1, NamedPalettes::getInstance()["red"] ) ); break; }
+        default : { seg->setFX( createFX( random8(), seg->getLength() ) ); }
+      }
+      if (minute % 60 == 0) {
+        unsigned long hour = minute / 60;
+        if (hour == 1) { firstHourHeapHigh = pool->getHeapHighWater(); }
+        printf( "%6lu %10lu %10lu %10lu %12lu %10lu\n", hour, (unsigned long)pool->getBytesInUse(), (unsigned long)pool->getHighWater(),
+                (unsigned long)pool->getHeapBytes(), (unsigned long)pool->getHeapHighWater(), pool->getHeapAllocs() );
+      }
+    }
+  }
+  bool flat = (pool->getHeapHighWater() <= firstHourHeapHigh);
+  printf( "heap high water %s after the first hour\n", flat ? "flat" : "GREW" );
+  FlexClock::setClock( nullptr );
+  delete[] leds;
+  return flat ? 0 : 1;
+}
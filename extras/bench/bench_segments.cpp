@@ -0,0 +1,65 @@
+//
+//  bench_segments.cpp - FFXController::update() cost versus number of segments
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Splits the strip into 1..512 secondary segments over a running primary segment and times update() (virtual clock,
+ *  1ms per update) with two layouts:
+ *
+ *    zones   - segments side by side (like per-window zones on a building), alternately opaque and translucent
+ *    overlap - each segment twice as long, so it overlaps half of the next one
+ *
+ *    bench_segments [numLeds] [updates]
+ *
+ *  Prints microseconds per update for each layout and the number of intervals in the coverage map (see FFXCoverageMap).
+ */
+#include <stdio.h>
+#include <chrono>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXNullPixelController.h"
+
+static double timeUpdates( uint16_t numLeds, uint16_t numSegments, bool overlap, unsigned long updates, uint16_t &intervals ) {
+  VirtualClock vclock;
+  FlexClock::setClock( &vclock );
+  CRGB *leds = new CRGB[numLeds];
+  FFXController *ctrlr = new FFXController();
+  ctrlr->initialize( new FFXNullPixelController( leds, numLeds ), 2*numSegments+FFX_BUFFER_POOL_FRAMES );
+  ctrlr->getPrimarySegment()->setFX( new RainbowFX( numLeds ) );
+  ctrlr->setBrightness( 200 );
+  uint16_t zone = numLeds / numSegments;
+  for (uint16_t i = 0; i < numSegments; i++) {
+    uint16_t first = i*zone;
+    uint16_t last = overlap ? minimum<uint16_t>( first+2*zone-1, numLeds-1 ) : first+zone-1;
+    FFXSegment *seg = ctrlr->addSegment( String("zone") + String(i), first, last );
+    seg->setFX( (i % 2) ? (FFXBase *)new ChaseFX( seg->getLength() ) : (FFXBase *)new CylonFX( seg->getLength() ) );
+    seg->setOpacity( (i % 2) ? 255 : 160 );
+  }
+  // let the opacity fades finish before timing
+  for (unsigned long t = 0; t < 1000; t++) { ctrlr->update(); vclock.advance( 1 ); }
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long t = 0; t < updates; t++) { ctrlr->update(); vclock.advance( 1 ); }
+  double elapsed = std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - start ).count();
+  intervals = ctrlr->getCoverageMap()->getIntervalCount();
+  delete ctrlr;
+  delete[] leds;
+  FlexClock::setClock( nullptr );
+  return elapsed / updates;
+}
+
+int main( int argc, char **argv ) {
+  uint16_t numLeds = (argc > 1) ? atoi(argv[1]) : 4096;
+  unsigned long updates = (argc > 2) ? atol(argv[2]) : 5000;
+  printf( "leds=%u updates=%lu\n", numLeds, updates );
+  printf( "%8s %14s %14s %10s\n", "segments", "zones_us", "overlap_us", "intervals" );
+  for (uint16_t numSegments = 1; numSegments <= 512 && numSegments <= numLeds; numSegments *= 2) {
+    uint16_t zoneIntervals = 0;
+    uint16_t overlapIntervals = 0;
+    double zones = timeUpdates( numLeds, numSegments, false, updates, zoneIntervals );
+    double overlap = timeUpdates( numLeds, numSegments, true, updates, overlapIntervals );
+    printf( "%8u %14.2f %14.2f %10u\n", numSegments, zones, overlap, overlapIntervals );
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+//
+//  bench_trace.cpp - Cost of recording FFXTrace events
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Times FFXTraceScope (what FFX_TRACE_SCOPE() expands to when built with FFX_TRACE) and FFXTrace::record() on its own, 
+ *  with recording on and off, then writes the ring buffer out as Chrome trace JSON to check the export.
+ *
+ *    bench_trace [events] [traceFile]
+ *
+ *  Prints nanoseconds per event.
+ */
+#include <stdio.h>
+#include <chrono>
+#include "FFXTrace.h"
+
+static double nanosPerEvent( unsigned long events, bool scoped ) {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < events; i++) {
+    if (scoped) { FFXTraceScope scope( "bench", (uint16_t)(i & 0xFF) ); }
+    else { FFXTrace::record( "bench", i, 1, (uint16_t)(i & 0xFF) ); }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / events;
+}
+
+static double clockNanos( unsigned long calls ) {
+  auto start = std::chrono::steady_clock::now();
+  volatile uint64_t last = 0;
+  for (unsigned long i = 0; i < calls; i++) { last = FFXTrace::clock(); }
+  auto end = std::chrono::steady_clock::now();
+  (void)last;
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / calls;
+}
+
+int main( int argc, char **argv ) {
+  unsigned long events = (argc > 1) ? atol(argv[1]) : 10000000UL;
+  const char *traceFile = (argc > 2) ? argv[2] : nullptr;
+  if (events == 0) { events = 1; }
+
+  nanosPerEvent( events / 10, true );   // warm up
+  printf( "clock_ns=%.1f\n", clockNanos( events ) );
+  printf( "record_ns=%.1f scope_ns=%.1f\n", nanosPerEvent( events, false ), nanosPerEvent( events, true ) );
+  FFXTrace::setEnabled( false );
+  printf( "disabled_record_ns=%.1f disabled_scope_ns=%.1f\n", nanosPerEvent( events, false ), nanosPerEvent( events, true ) );
+
+  if (traceFile) {
+    FFXTrace::setEnabled( true );
+    FFXTrace::clear();
+    for (int i = 0; i < 100; i++) { FFXTraceScope scope( "outer", i ); FFXTraceScope inner( "inner" ); }
+    FFXTrace::record( "instant", FFXTrace::clock(), FFX_TRACE_INSTANT_EVENT );
+    FFXTrace::setEnabled( false );
+    printf( "%s: %s\n", traceFile, FFXTrace::saveChromeTrace( traceFile ) ? "written" : "failed" );
+  }
+  return 0;
+}
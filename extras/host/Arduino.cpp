@@ -0,0 +1,128 @@
+//
+//  Arduino.cpp - Host (Linux) stand-in for the Arduino core
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "Arduino.h"
+#include <chrono>
+#include <thread>
+#include <ctype.h>
+#include <stdio.h>
+
+// The host clock starts one second "after boot".  StepTimer uses a start time of 0 to mean stopped, and on a
+// real board millis() is never 0 by the time setup() has run.
+static const std::chrono::steady_clock::time_point hostStartTime = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - hostStartTime).count();
+}
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStartTime).count();
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() { }
+
+// Same generator on every run so host renders/benchmarks are repeatable - call randomSeed() to vary
+static unsigned long randomState = 1;
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) { randomState = seed; }
+}
+
+static unsigned long nextRandom() {
+  randomState = randomState * 1103515245UL + 12345UL;
+  return (randomState >> 16) & 0x7FFFFFFFUL;
+}
+
+long random(long howbig) {
+  if (howbig <= 0) { return 0; }
+  return (long)(nextRandom() % (unsigned long)howbig);
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) { return howsmall; }
+  return random(howbig - howsmall) + howsmall;
+}
+
+String::String(long value, unsigned char base) {
+  if (base == 10) {
+    buffer = std::to_string(value);
+  }
+  else {
+    bool neg = (value < 0);
+    buffer = String((unsigned long)(neg ? -value : value), base).buffer;
+    if (neg) { buffer.insert(buffer.begin(), '-'); }
+  }
+}
+
+String::String(unsigned long value, unsigned char base) {
+  if (base < 2 || base > 36) { base = 10; }
+  char digits[sizeof(unsigned long)*8+1];
+  int pos = sizeof(digits);
+  do {
+    unsigned long d = value % base;
+    digits[--pos] = (char)(d < 10 ? '0'+d : 'A'+d-10);
+    value /= base;
+  } while (value > 0);
+  buffer.assign(&digits[pos], sizeof(digits)-pos);
+}
+
+String::String(double value, unsigned char decimalPlaces) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+  buffer = buf;
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+  if (buffer.length() != s.buffer.length()) { return false; }
+  for (size_t i=0; i<buffer.length(); i++) {
+    if (tolower((unsigned char)buffer[i]) != tolower((unsigned char)s.buffer[i])) { return false; }
+  }
+  return true;
+}
+
+bool String::endsWith(const String &suffix) const {
+  return (buffer.length() >= suffix.buffer.length()) &&
+         (buffer.compare(buffer.length()-suffix.buffer.length(), suffix.buffer.length(), suffix.buffer) == 0);
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+  size_t pos = buffer.find(ch, fromIndex);
+  return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const {
+  size_t pos = buffer.find(str.buffer, fromIndex);
+  return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) { std::swap(beginIndex, endIndex); }
+  if (beginIndex >= buffer.length()) { return String(); }
+  if (endIndex > buffer.length()) { endIndex = buffer.length(); }
+  return String(buffer.substr(beginIndex, endIndex-beginIndex));
+}
+
+void String::trim() {
+  size_t first = buffer.find_first_not_of(" \t\r\n");
+  size_t last = buffer.find_last_not_of(" \t\r\n");
+  buffer = (first == std::string::npos) ? std::string() : buffer.substr(first, last-first+1);
+}
+
+void String::toLowerCase() {
+  for (auto &c : buffer) { c = (char)tolower((unsigned char)c); }
+}
+
+void String::toUpperCase() {
+  for (auto &c : buffer) { c = (char)toupper((unsigned char)c); }
+}
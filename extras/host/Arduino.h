@@ -0,0 +1,124 @@
+//
+//  Arduino.h - Host (Linux) stand-in for the Arduino core
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Minimal subset of the Arduino core API needed to compile the FastFX library natively.  This is NOT a general
+ *  purpose Arduino emulation - only the pieces referenced by the library (timing, random numbers, String and a few
+ *  typedefs/macros) are provided.  Used by the host CMake build so the library can be profiled and benchmarked
+ *  with native tools (perf, valgrind, etc.).
+ */
+#ifndef FFX_HOST_ARDUINO_H
+#define FFX_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#define FFX_HOST_BUILD 1
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+template<typename T, typename L>
+inline auto min(const T& a, const L& b) -> decltype(b < a ? b : a) { return (b < a) ? b : a; }
+
+template<typename T, typename L>
+inline auto max(const T& a, const L& b) -> decltype(b < a ? b : a) { return (a < b) ? b : a; }
+
+template<typename T, typename L, typename H>
+inline T constrain(const T& x, const L& lo, const H& hi) { return (x < lo) ? lo : ((x > hi) ? hi : x); }
+
+/*!
+ *  String - std::string backed implementation of the Arduino String class.  Only the members used by the
+ *  library and its examples are implemented.
+ */
+class String {
+  public:
+    String(const char *cstr = "") : buffer(cstr ? cstr : "") {}
+    String(const std::string &str) : buffer(str) {}
+    String(const String &str) = default;
+    String(String &&str) = default;
+    explicit String(char c) : buffer(1, c) {}
+    explicit String(unsigned char value, unsigned char base=10) : String((unsigned long)value, base) {}
+    explicit String(int value, unsigned char base=10) : String((long)value, base) {}
+    explicit String(unsigned int value, unsigned char base=10) : String((unsigned long)value, base) {}
+    explicit String(long value, unsigned char base=10);
+    explicit String(unsigned long value, unsigned char base=10);
+    explicit String(float value, unsigned char decimalPlaces=2) : String((double)value, decimalPlaces) {}
+    explicit String(double value, unsigned char decimalPlaces=2);
+
+    String &operator=(const String &rhs) = default;
+    String &operator=(String &&rhs) = default;
+    String &operator=(const char *cstr) { buffer = (cstr ? cstr : ""); return *this; }
+
+    unsigned int length() const { return buffer.length(); }
+    bool isEmpty() const { return buffer.empty(); }
+    const char *c_str() const { return buffer.c_str(); }
+    char charAt(unsigned int index) const { return index < buffer.length() ? buffer[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    bool concat(const String &str) { buffer += str.buffer; return true; }
+    bool concat(const char *cstr) { if (cstr) { buffer += cstr; } return true; }
+    bool concat(char c) { buffer += c; return true; }
+    String &operator+=(const String &rhs) { concat(rhs); return *this; }
+    String &operator+=(const char *cstr) { concat(cstr); return *this; }
+    String &operator+=(char c) { concat(c); return *this; }
+
+    bool equals(const String &s) const { return buffer == s.buffer; }
+    bool equals(const char *cstr) const { return buffer == (cstr ? cstr : ""); }
+    bool equalsIgnoreCase(const String &s) const;
+    bool startsWith(const String &prefix) const { return buffer.compare(0, prefix.buffer.length(), prefix.buffer) == 0; }
+    bool endsWith(const String &suffix) const;
+    int indexOf(char ch, unsigned int fromIndex=0) const;
+    int indexOf(const String &str, unsigned int fromIndex=0) const;
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, length()); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    long toInt() const { return strtol(buffer.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(buffer.c_str(), nullptr); }
+
+    bool operator==(const String &rhs) const { return equals(rhs); }
+    bool operator==(const char *cstr) const { return equals(cstr); }
+    bool operator!=(const String &rhs) const { return !equals(rhs); }
+    bool operator!=(const char *cstr) const { return !equals(cstr); }
+    bool operator<(const String &rhs) const { return buffer < rhs.buffer; }
+
+    friend String operator+(const String &lhs, const String &rhs) { String result(lhs); result += rhs; return result; }
+    friend String operator+(const String &lhs, const char *rhs) { String result(lhs); result += rhs; return result; }
+    friend String operator+(const char *lhs, const String &rhs) { String result(lhs); result += rhs; return result; }
+    friend String operator+(const String &lhs, char rhs) { String result(lhs); result += rhs; return result; }
+
+  private:
+    std::string buffer;
+};
+
+inline bool operator==(const char *lhs, const String &rhs) { return rhs.equals(lhs); }
+inline bool operator!=(const char *lhs, const String &rhs) { return !rhs.equals(lhs); }
+
+#endif
@@ -0,0 +1,66 @@
+//
+//  FFXTestEffects.h - Core effects by name, for the host tools, tests and benchmarks
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  The tools in extras each run the core effects by name (from the command line, a scene file or a fixed list of
+ *  cases), so the mapping from names to effects lives here instead of being repeated in each of them.
+ *
+ *    effects  - solid, palette, chase, motion, rainbow, juggle, cylon, cycle, twinkle, dim, pacifica, fire
+ *    overlays - wave, pulse, zip
+ */
+#ifndef FFX_TEST_EFFECTS_H
+#define FFX_TEST_EFFECTS_H
+
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+
+/*! The core effect called name, or nullptr if there isn't one (overlays aren't included - see createOverlay()) */
+static inline FFXBase *createFX( const String &name, uint16_t size ) {
+  if (name=="solid")    { return new SolidFX( size ); }
+  if (name=="palette")  { return new PaletteFX( size ); }
+  if (name=="chase")    { return new ChaseFX( size ); }
+  if (name=="motion")   { return new MotionFX( size ); }
+  if (name=="rainbow")  { return new RainbowFX( size ); }
+  if (name=="juggle")   { return new JuggleFX( size ); }
+  if (name=="cylon")    { return new CylonFX( size ); }
+  if (name=="cycle")    { return new CycleFX( size ); }
+  if (name=="twinkle")  { return new TwinkleFX( size ); }
+  if (name=="dim")      { return new DimUsingPaletteFX( size ); }
+  if (name=="pacifica") { return new PacificaFX( size ); }
+  if (name=="fire")     { return new FireFX( size ); }
+  return nullptr;
+}
+
+/*! One of four moving effects (cylon, juggle, rainbow, chase), picked by which - for cycling through effects */
+static inline FFXBase *createFX( uint8_t which, uint16_t size ) {
+  switch (which % 4) {
+    case 0 : { return new CylonFX( size ); }
+    case 1 : { return new JuggleFX( size ); }
+    case 2 : { return new RainbowFX( size ); }
+    default : { return new ChaseFX( size ); }
+  }
+}
+
+static inline bool isOverlay( const String &name ) { return name=="wave" || name=="pulse" || name=="zip"; }
+
+/*! The core overlay called name, running repeat cycles at speed, or nullptr if there isn't one */
+static inline FFXOverlay *createOverlay( const String &name, uint16_t size, uint8_t speed, uint8_t repeat ) {
+  if (name=="wave")  { return new WaveOverlayFX( size, speed, repeat ); }
+  if (name=="pulse") { return new PulseOverlayFX( size, speed, repeat ); }
+  if (name=="zip")   { return new ZipOverlayFX( size, speed, repeat ); }
+  return nullptr;
+}
+
+/*! One of the core overlays (pulse, wave, zip), picked by which */
+static inline FFXOverlay *createOverlay( uint8_t which, uint16_t size, uint8_t speed, uint8_t repeat ) {
+  switch (which % 3) {
+    case 0 : { return new PulseOverlayFX( size, speed, repeat ); }
+    case 1 : { return new WaveOverlayFX( size, speed, repeat ); }
+    default : { return new ZipOverlayFX( size, speed, repeat ); }
+  }
+}
+
+#endif
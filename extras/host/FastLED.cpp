@@ -0,0 +1,530 @@
+//
+//  FastLED.cpp - Host (Linux) stand-in for the FastLED library
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "FastLED.h"
+
+CFastLED FastLED;
+
+uint16_t rand16seed = 1337;
+
+unsigned long long ffxHostBytesMoved = 0;
+
+#define FIXFRAC8(N,D) (((N)*256)/(D))
+
+static uint8_t sqrt16( uint16_t x ) {
+    if( x <= 1 ) { return x; }
+    uint8_t low = 1;
+    uint8_t hi, mid;
+    if( x > 7904 ) { hi = 255; } else { hi = (x >> 5) + 8; }
+    do {
+        mid = (low + hi) >> 1;
+        if( (uint16_t)(mid * mid) > x ) {
+            hi = mid - 1;
+        } else {
+            if( mid == 255 ) { return 255; }
+            low = mid + 1;
+        }
+    } while( hi >= low );
+    return low - 1;
+}
+
+void hsv2rgb_rainbow( const CHSV& hsv, CRGB& rgb ) {
+    const uint8_t K255 = 255;
+    const uint8_t K171 = 171;
+    const uint8_t K170 = 170;
+    const uint8_t K85  = 85;
+
+    uint8_t hue = hsv.hue;
+    uint8_t sat = hsv.sat;
+    uint8_t val = hsv.val;
+
+    uint8_t offset = hue & 0x1F; // 0..31
+    uint8_t offset8 = offset << 3;
+    uint8_t third = scale8( offset8, (256 / 3) ); // max = 85
+
+    uint8_t r, g, b;
+    if( ! (hue & 0x80) ) {
+        if( ! (hue & 0x40) ) {
+            if( ! (hue & 0x20) ) {
+                // R -> O
+                r = K255 - third; g = third; b = 0;
+            } else {
+                // O -> Y
+                r = K171; g = K85 + third; b = 0;
+            }
+        } else {
+            if( ! (hue & 0x20) ) {
+                // Y -> G
+                uint8_t twothirds = scale8( offset8, ((256 * 2) / 3) ); // max=170
+                r = K171 - twothirds; g = K170 + third; b = 0;
+            } else {
+                // G -> A
+                r = 0; g = K255 - third; b = third;
+            }
+        }
+    } else {
+        if( ! (hue & 0x40) ) {
+            if( ! (hue & 0x20) ) {
+                // A -> B
+                uint8_t twothirds = scale8( offset8, ((256 * 2) / 3) ); // max=170
+                r = 0; g = K171 - twothirds; b = K85 + twothirds;
+            } else {
+                // B -> P
+                r = third; g = 0; b = K255 - third;
+            }
+        } else {
+            if( ! (hue & 0x20) ) {
+                // P -> K
+                r = K85 + third; g = 0; b = K171 - third;
+            } else {
+                // K -> R
+                r = K170 + third; g = 0; b = K85 - third;
+            }
+        }
+    }
+
+    if( sat != 255 ) {
+        if( sat == 0 ) {
+            r = 255; b = 255; g = 255;
+        } else {
+            uint8_t desat = 255 - sat;
+            desat = scale8_video( desat, desat );
+            uint8_t satscale = 255 - desat;
+            r = scale8( r, satscale );
+            g = scale8( g, satscale );
+            b = scale8( b, satscale );
+            uint8_t brightness_floor = desat;
+            r += brightness_floor;
+            g += brightness_floor;
+            b += brightness_floor;
+        }
+    }
+
+    if( val != 255 ) {
+        val = scale8_video( val, val );
+        if( val == 0 ) {
+            r = 0; g = 0; b = 0;
+        } else {
+            r = scale8( r, val );
+            g = scale8( g, val );
+            b = scale8( b, val );
+        }
+    }
+    rgb.r = r;
+    rgb.g = g;
+    rgb.b = b;
+}
+
+CHSV rgb2hsv_approximate( const CRGB& rgb ) {
+    uint8_t r = rgb.r;
+    uint8_t g = rgb.g;
+    uint8_t b = rgb.b;
+    uint8_t h, s, v;
+
+    // find desaturation, then remove it from all channels
+    uint8_t desat = 255;
+    if( r < desat ) desat = r;
+    if( g < desat ) desat = g;
+    if( b < desat ) desat = b;
+    r -= desat;
+    g -= desat;
+    b -= desat;
+
+    s = 255 - desat;
+    if( s != 255 ) {
+        s = 255 - sqrt16( (255-s) * 256 );
+    }
+
+    // shade of gray
+    if( (r + g + b) == 0 ) {
+        return CHSV( 0, 0, 255 - s );
+    }
+
+    // scale all channels up to compensate for desaturation
+    if( s < 255 ) {
+        if( s == 0 ) s = 1;
+        uint32_t scaleup = 65535 / (s);
+        r = ((uint32_t)(r) * scaleup) / 256;
+        g = ((uint32_t)(g) * scaleup) / 256;
+        b = ((uint32_t)(b) * scaleup) / 256;
+    }
+
+    uint16_t total = r + g + b;
+    // scale all channels up to compensate for low values
+    if( total < 255 ) {
+        if( total == 0 ) total = 1;
+        uint32_t scaleup = 65535 / (total);
+        r = ((uint32_t)(r) * scaleup) / 256;
+        g = ((uint32_t)(g) * scaleup) / 256;
+        b = ((uint32_t)(b) * scaleup) / 256;
+    }
+
+    if( total > 255 ) {
+        v = 255;
+    } else {
+        v = qadd8( desat, total );
+        if( v != 255 ) v = sqrt16( v * 256 );
+    }
+
+    uint8_t highest = r;
+    if( g > highest ) highest = g;
+    if( b > highest ) highest = b;
+
+    if( highest == r ) {
+        if( g == 0 ) {
+            h = (HUE_PURPLE + HUE_PINK) / 2;
+            h += scale8( qsub8(r, 128), FIXFRAC8(48,128) );
+        } else if( (r - g) > g ) {
+            h = HUE_RED;
+            h += scale8( g, FIXFRAC8(32,85) );
+        } else {
+            h = HUE_ORANGE;
+            h += scale8( qsub8((g - 85) + (171 - r), 4), FIXFRAC8(32,85) );
+        }
+    } else if( highest == g ) {
+        if( b == 0 ) {
+            h = HUE_YELLOW;
+            uint8_t radj = scale8( qsub8(171,r), 47 );
+            uint8_t gadj = scale8( qsub8(g,171), 96 );
+            uint8_t rgadj = radj + gadj;
+            uint8_t hueadv = rgadj / 2;
+            h += hueadv;
+        } else {
+            if( (g-b) > b ) {
+                h = HUE_GREEN;
+                h += scale8( b, FIXFRAC8(32,85) );
+            } else {
+                h = HUE_AQUA;
+                h += scale8( qsub8(b, 85), FIXFRAC8(8,42) );
+            }
+        }
+    } else {
+        if( r == 0 ) {
+            h = HUE_AQUA + ((HUE_BLUE - HUE_AQUA) / 4);
+            h += scale8( qsub8(b, 128), FIXFRAC8(24,128) );
+        } else if( (b-r) > r ) {
+            h = HUE_BLUE;
+            h += scale8( r, FIXFRAC8(32,85) );
+        } else {
+            h = HUE_PURPLE;
+            h += scale8( qsub8(r, 85), FIXFRAC8(32,85) );
+        }
+    }
+    h += 1;
+    return CHSV( h, s, v );
+}
+
+CRGB HeatColor( uint8_t temperature ) {
+    CRGB heatcolor;
+    // Scale 'heat' down from 0-255 to 0-191, which can then be easily divided into three equal 'thirds' of 64 units each.
+    uint8_t t192 = scale8_video( temperature, 191 );
+    uint8_t heatramp = t192 & 0x3F; // 0..63
+    heatramp <<= 2; // scale up to 0..252
+    if( t192 & 0x80 ) {
+        heatcolor.r = 255; heatcolor.g = 255; heatcolor.b = heatramp;
+    } else if( t192 & 0x40 ) {
+        heatcolor.r = 255; heatcolor.g = heatramp; heatcolor.b = 0;
+    } else {
+        heatcolor.r = heatramp; heatcolor.g = 0; heatcolor.b = 0;
+    }
+    return heatcolor;
+}
+
+void fill_solid( CRGB *leds, int numToFill, const CRGB& color ) {
+    for( int i = 0; i < numToFill; ++i ) { leds[i] = color; }
+}
+
+void fill_rainbow( CRGB *pFirstLED, int numToFill, uint8_t initialhue, uint8_t deltahue ) {
+    CHSV hsv;
+    hsv.hue = initialhue;
+    hsv.val = 255;
+    hsv.sat = 240;
+    for( int i = 0; i < numToFill; ++i ) {
+        pFirstLED[i] = hsv;
+        hsv.hue += deltahue;
+    }
+}
+
+void fill_gradient_RGB( CRGB *leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor ) {
+    // if the points are in the wrong order, straighten them
+    if( endpos < startpos ) {
+        uint16_t t = endpos;
+        CRGB tc = endcolor;
+        endcolor = startcolor;
+        endpos = startpos;
+        startpos = t;
+        startcolor = tc;
+    }
+    saccum87 rdistance87 = (endcolor.r - startcolor.r) << 7;
+    saccum87 gdistance87 = (endcolor.g - startcolor.g) << 7;
+    saccum87 bdistance87 = (endcolor.b - startcolor.b) << 7;
+    uint16_t pixeldistance = endpos - startpos;
+    int16_t divisor = pixeldistance ? pixeldistance : 1;
+    saccum87 rdelta87 = rdistance87 / divisor;
+    saccum87 gdelta87 = gdistance87 / divisor;
+    saccum87 bdelta87 = bdistance87 / divisor;
+    rdelta87 *= 2;
+    gdelta87 *= 2;
+    bdelta87 *= 2;
+    accum88 r88 = startcolor.r << 8;
+    accum88 g88 = startcolor.g << 8;
+    accum88 b88 = startcolor.b << 8;
+    for( uint16_t i = startpos; i <= endpos; ++i ) {
+        leds[i] = CRGB( r88 >> 8, g88 >> 8, b88 >> 8 );
+        r88 += rdelta87;
+        g88 += gdelta87;
+        b88 += bdelta87;
+    }
+}
+
+void nscale8( CRGB *leds, uint16_t num_leds, uint8_t scale ) {
+    for( uint16_t i = 0; i < num_leds; ++i ) { leds[i].nscale8( scale ); }
+}
+
+void fadeToBlackBy( CRGB *leds, uint16_t num_leds, uint8_t fadeBy ) {
+    nscale8( leds, num_leds, 255 - fadeBy );
+}
+
+void fadeLightBy( CRGB *leds, uint16_t num_leds, uint8_t fadeBy ) {
+    for( uint16_t i = 0; i < num_leds; ++i ) { leds[i].nscale8_video( 255 - fadeBy ); }
+}
+
+void blur1d( CRGB *leds, uint16_t numLeds, fract8 blur_amount ) {
+    uint8_t keep = 255 - blur_amount;
+    uint8_t seep = blur_amount >> 1;
+    CRGB carryover = CRGB::Black;
+    for( uint16_t i = 0; i < numLeds; ++i ) {
+        CRGB cur = leds[i];
+        CRGB part = cur;
+        part.nscale8( seep );
+        cur.nscale8( keep );
+        cur += carryover;
+        if( i ) leds[i-1] += part;
+        leds[i] = cur;
+        carryover = part;
+    }
+}
+
+CRGB& nblend( CRGB& existing, const CRGB& overlay, fract8 amountOfOverlay ) {
+    if( amountOfOverlay == 0 ) {
+        return existing;
+    }
+    if( amountOfOverlay == 255 ) {
+        existing = overlay;
+        return existing;
+    }
+    existing.red   = blend8( existing.red,   overlay.red,   amountOfOverlay );
+    existing.green = blend8( existing.green, overlay.green, amountOfOverlay );
+    existing.blue  = blend8( existing.blue,  overlay.blue,  amountOfOverlay );
+    return existing;
+}
+
+void nblend( CRGB *existing, CRGB *overlay, uint16_t count, fract8 amountOfOverlay ) {
+    for( uint16_t i = count; i; --i ) {
+        nblend( *existing, *overlay, amountOfOverlay );
+        ++existing;
+        ++overlay;
+    }
+}
+
+CRGB blend( const CRGB& p1, const CRGB& p2, fract8 amountOfP2 ) {
+    CRGB nu(p1);
+    nblend( nu, p2, amountOfP2 );
+    return nu;
+}
+
+CRGB *blend( const CRGB *src1, const CRGB *src2, CRGB *dest, uint16_t count, fract8 amountOfsrc2 ) {
+    for( uint16_t i = 0; i < count; ++i ) {
+        dest[i] = blend( src1[i], src2[i], amountOfsrc2 );
+    }
+    return dest;
+}
+
+typedef union {
+    struct {
+        uint8_t index;
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+    };
+    uint32_t dword;
+    uint8_t  bytes[4];
+} TRGBGradientPaletteEntryUnion;
+
+CRGBPalette16& CRGBPalette16::operator=( TProgmemRGBGradientPalette_bytes progpal ) {
+    const uint8_t *progent = progpal;
+    TRGBGradientPaletteEntryUnion u;
+
+    // Count entries
+    uint16_t count = 0;
+    do {
+        memcpy( u.bytes, progent + (count*4), 4 );
+        ++count;
+    } while( u.index != 255 );
+
+    int8_t lastSlotUsed = -1;
+
+    memcpy( u.bytes, progent, 4 );
+    CRGB rgbstart( u.r, u.g, u.b );
+
+    int indexstart = 0;
+    uint8_t istart8 = 0;
+    uint8_t iend8 = 0;
+    while( indexstart < 255 ) {
+        progent += 4;
+        memcpy( u.bytes, progent, 4 );
+        int indexend = u.index;
+        CRGB rgbend( u.r, u.g, u.b );
+        istart8 = indexstart / 16;
+        iend8   = indexend   / 16;
+        if( count < 16 ) {
+            if( (istart8 <= lastSlotUsed) && (lastSlotUsed < 15) ) {
+                istart8 = lastSlotUsed + 1;
+                if( iend8 < istart8 ) {
+                    iend8 = istart8;
+                }
+            }
+            lastSlotUsed = iend8;
+        }
+        fill_gradient_RGB( &(entries[0]), istart8, rgbstart, iend8, rgbend );
+        indexstart = indexend;
+        rgbstart = rgbend;
+    }
+    return *this;
+}
+
+CRGB ColorFromPalette( const CRGBPalette16& pal, uint8_t index, uint8_t brightness, TBlendType blendType ) {
+    uint8_t hi4 = lsrX4( index );
+    uint8_t lo4 = index & 0x0F;
+
+    const CRGB* entry = &(pal[0]) + hi4;
+    uint8_t blend = lo4 && (blendType != NOBLEND);
+
+    uint8_t red1   = entry->red;
+    uint8_t green1 = entry->green;
+    uint8_t blue1  = entry->blue;
+
+    if( blend ) {
+        if( hi4 == 15 ) {
+            entry = &(pal[0]);
+        } else {
+            ++entry;
+        }
+        uint8_t f2 = lo4 << 4;
+        uint8_t f1 = 255 - f2;
+
+        uint8_t red2   = entry->red;
+        red1   = scale8( red1,   f1 );
+        red2   = scale8( red2,   f2 );
+        red1   += red2;
+
+        uint8_t green2 = entry->green;
+        green1 = scale8( green1, f1 );
+        green2 = scale8( green2, f2 );
+        green1 += green2;
+
+        uint8_t blue2  = entry->blue;
+        blue1  = scale8( blue1,  f1 );
+        blue2  = scale8( blue2,  f2 );
+        blue1  += blue2;
+    }
+
+    if( brightness != 255 ) {
+        if( brightness ) {
+            ++brightness; // adjust for rounding
+            if( red1 )   { red1   = scale8( red1,   brightness ); }
+            if( green1 ) { green1 = scale8( green1, brightness ); }
+            if( blue1 )  { blue1  = scale8( blue1,  brightness ); }
+        } else {
+            red1 = 0;
+            green1 = 0;
+            blue1 = 0;
+        }
+    }
+    return CRGB( red1, green1, blue1 );
+}
+
+void fill_palette( CRGB *L, uint16_t N, uint8_t startIndex, uint8_t incIndex, const CRGBPalette16& pal, uint8_t brightness, TBlendType blendType ) {
+    uint8_t colorIndex = startIndex;
+    for( uint16_t i = 0; i < N; ++i ) {
+        L[i] = ColorFromPalette( pal, colorIndex, brightness, blendType );
+        colorIndex += incIndex;
+    }
+}
+
+void nblendPaletteTowardPalette( CRGBPalette16& current, CRGBPalette16& target, uint8_t maxChanges ) {
+    uint8_t* p1 = (uint8_t*)current.entries;
+    uint8_t* p2 = (uint8_t*)target.entries;
+    const uint8_t totalChannels = sizeof(CRGBPalette16);
+    uint8_t changes = 0;
+    for( uint8_t i = 0; i < totalChannels; ++i ) {
+        // if the values are equal, no changes are needed
+        if( p1[i] == p2[i] ) { continue; }
+        // if the current value is less than the target, increase it by one
+        if( p1[i] < p2[i] ) { ++p1[i]; ++changes; }
+        // if the current value is greater than the target, decrease it by one (or two if it's still greater)
+        if( p1[i] > p2[i] ) {
+            --p1[i]; ++changes;
+            if( p1[i] > p2[i] ) { --p1[i]; }
+        }
+        if( changes >= maxChanges ) { break; }
+    }
+}
+
+extern const TProgmemRGBPalette16 CloudColors_p = {
+    CRGB::Blue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue,
+    CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue,
+    CRGB::Blue, CRGB::DarkBlue, CRGB::SkyBlue, CRGB::SkyBlue,
+    CRGB::LightBlue, CRGB::White, CRGB::LightBlue, CRGB::SkyBlue
+};
+
+extern const TProgmemRGBPalette16 LavaColors_p = {
+    CRGB::Black, CRGB::Maroon, CRGB::Black, CRGB::Maroon,
+    CRGB::DarkRed, CRGB::DarkRed, CRGB::Maroon, CRGB::DarkRed,
+    CRGB::DarkRed, CRGB::DarkRed, CRGB::Red, CRGB::Orange,
+    CRGB::White, CRGB::Orange, CRGB::Red, CRGB::DarkRed
+};
+
+extern const TProgmemRGBPalette16 OceanColors_p = {
+    CRGB::MidnightBlue, CRGB::DarkBlue, CRGB::MidnightBlue, CRGB::Navy,
+    CRGB::DarkBlue, CRGB::MediumBlue, CRGB::SeaGreen, CRGB::Teal,
+    CRGB::CadetBlue, CRGB::Blue, CRGB::DarkCyan, CRGB::CornflowerBlue,
+    CRGB::Aquamarine, CRGB::SeaGreen, CRGB::Aqua, CRGB::LightSkyBlue
+};
+
+extern const TProgmemRGBPalette16 ForestColors_p = {
+    CRGB::DarkGreen, CRGB::DarkGreen, CRGB::DarkOliveGreen, CRGB::DarkGreen,
+    CRGB::Green, CRGB::ForestGreen, CRGB::OliveDrab, CRGB::Green,
+    CRGB::SeaGreen, CRGB::MediumAquamarine, CRGB::LimeGreen, CRGB::YellowGreen,
+    CRGB::LightGreen, CRGB::LawnGreen, CRGB::MediumAquamarine, CRGB::ForestGreen
+};
+
+extern const TProgmemRGBPalette16 RainbowColors_p = {
+    0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00,
+    0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+    0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5,
+    0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B
+};
+
+extern const TProgmemRGBPalette16 RainbowStripeColors_p = {
+    0xFF0000, 0x000000, 0xAB5500, 0x000000,
+    0xABAB00, 0x000000, 0x00FF00, 0x000000,
+    0x00AB55, 0x000000, 0x0000FF, 0x000000,
+    0x5500AB, 0x000000, 0xAB0055, 0x000000
+};
+
+extern const TProgmemRGBPalette16 PartyColors_p = {
+    0x5500AB, 0x84007C, 0xB5004B, 0xE5001B,
+    0xE81700, 0xB84700, 0xAB7700, 0xABAB00,
+    0xAB5500, 0xDD2200, 0xF2000E, 0xC2003E,
+    0x8F0071, 0x5F00A1, 0x2F00D0, 0x0007F9
+};
+
+extern const TProgmemRGBPalette16 HeatColors_p = {
+    0x000000, 0x330000, 0x660000, 0x990000, 0xCC0000, 0xFF0000,
+    0xFF3300, 0xFF6600, 0xFF9900, 0xFFCC00, 0xFFFF00,
+    0xFFFF33, 0xFFFF66, 0xFFFF99, 0xFFFFCC, 0xFFFFFF
+};
@@ -0,0 +1,519 @@
+//
+//  FastLED.h - Host (Linux) stand-in for the FastLED library
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Subset of the FastLED API used by the FastFX library: CRGB/CHSV, CRGBSet (CPixelView), CRGBPalette16 and gradient
+ *  palettes, lib8tion math (scale8, blend8, sin8/sin16, beatsin, easing and random functions) and the color utilities
+ *  (fill_solid, fill_rainbow, fill_palette, fadeToBlackBy, nblend, blur1d, ColorFromPalette, HeatColor, ...).  The
+ *  arithmetic follows FastLED 3.3 with FASTLED_SCALE8_FIXED=1 so frames rendered on the host match the device.
+ *
+ *  No LED hardware is driven - CFastLED::show() simply counts calls.  Use a FFXPixelController (for example
+ *  FFXNullPixelController) to run a FFXController off-device.
+ *
+ *  Like FastLED, the beat functions read time from GET_MILLIS, which maps to get_millisecond_timer() when
+ *  USE_GET_MILLISECOND_TIMER is defined and millis() otherwise.
+ */
+#ifndef FFX_HOST_FASTLED_H
+#define FFX_HOST_FASTLED_H
+
+#include "Arduino.h"
+
+#define FASTLED_VERSION 3003002
+#define FASTLED_SCALE8_FIXED 1
+
+#define LIB8STATIC inline
+#define LIB8STATIC_ALWAYS_INLINE inline __attribute__((always_inline))
+#define FL_PROGMEM
+#define FL_ALIGN_PROGMEM
+
+#if defined(USE_GET_MILLISECOND_TIMER)
+uint32_t get_millisecond_timer();
+#define GET_MILLIS get_millisecond_timer
+#else
+#define GET_MILLIS millis
+#endif
+
+typedef uint8_t fract8;
+typedef uint16_t fract16;
+typedef uint16_t accum88;
+typedef int16_t saccum87;
+
+// Host only - running total of bytes moved through memmove8/memcpy8, so benchmarks can measure data movement
+extern unsigned long long ffxHostBytesMoved;
+inline void *ffxHostMemmove8( void *dst, const void *src, size_t num ) { ffxHostBytesMoved += num; return memmove( dst, src, num ); }
+inline void *ffxHostMemcpy8( void *dst, const void *src, size_t num ) { ffxHostBytesMoved += num; return memcpy( dst, src, num ); }
+
+#define memmove8 ffxHostMemmove8
+#define memcpy8 ffxHostMemcpy8
+#define memset8 memset
+
+typedef enum { NOBLEND=0, LINEARBLEND=1 } TBlendType;
+
+typedef enum {
+    HUE_RED = 0,
+    HUE_ORANGE = 32,
+    HUE_YELLOW = 64,
+    HUE_GREEN = 96,
+    HUE_AQUA = 128,
+    HUE_BLUE = 160,
+    HUE_PURPLE = 192,
+    HUE_PINK = 224
+} HSVHue;
+
+/* ----------------------------------------------------------------------------------------------------------------
+ *   lib8tion - 8 and 16 bit fixed point math
+ * ---------------------------------------------------------------------------------------------------------------- */
+
+LIB8STATIC_ALWAYS_INLINE uint8_t scale8( uint8_t i, fract8 scale ) { return (((uint16_t)i) * (1+(uint16_t)(scale))) >> 8; }
+LIB8STATIC_ALWAYS_INLINE uint8_t scale8_LEAVING_R1_DIRTY( uint8_t i, fract8 scale ) { return scale8( i, scale ); }
+LIB8STATIC_ALWAYS_INLINE uint8_t scale8_video( uint8_t i, fract8 scale ) { return (((int)i * (int)scale) >> 8) + ((i && scale) ? 1 : 0); }
+LIB8STATIC_ALWAYS_INLINE uint8_t scale8_video_LEAVING_R1_DIRTY( uint8_t i, fract8 scale ) { return scale8_video( i, scale ); }
+LIB8STATIC_ALWAYS_INLINE uint16_t scale16( uint16_t i, fract16 scale ) { return ((uint32_t)(i) * (1+(uint32_t)(scale))) / 65536; }
+LIB8STATIC_ALWAYS_INLINE uint16_t scale16by8( uint16_t i, fract8 scale ) { return (i * (1+((uint16_t)scale))) >> 8; }
+LIB8STATIC_ALWAYS_INLINE void cleanup_R1() { }
+
+LIB8STATIC_ALWAYS_INLINE uint8_t qadd8( uint8_t i, uint8_t j ) { unsigned int t = i + j; return (t > 255) ? 255 : t; }
+LIB8STATIC_ALWAYS_INLINE uint8_t qsub8( uint8_t i, uint8_t j ) { int t = i - j; return (t < 0) ? 0 : t; }
+LIB8STATIC_ALWAYS_INLINE uint8_t add8( uint8_t i, uint8_t j ) { return i + j; }
+LIB8STATIC_ALWAYS_INLINE uint8_t sub8( uint8_t i, uint8_t j ) { return i - j; }
+LIB8STATIC_ALWAYS_INLINE uint8_t avg8( uint8_t i, uint8_t j ) { return (i + j) >> 1; }
+LIB8STATIC_ALWAYS_INLINE uint8_t mul8( uint8_t i, uint8_t j ) { return ((int)i * (int)(j)) & 0xFF; }
+LIB8STATIC_ALWAYS_INLINE uint8_t qmul8( uint8_t i, uint8_t j ) { unsigned p = (unsigned)i * (unsigned)j; return (p > 255) ? 255 : p; }
+LIB8STATIC_ALWAYS_INLINE uint8_t lsrX4( uint8_t dividend ) { return dividend >> 4; }
+
+LIB8STATIC uint8_t blend8( uint8_t a, uint8_t b, uint8_t amountOfB ) {
+    uint16_t partial = (a << 8) | b;
+    partial += (b * amountOfB);
+    partial -= (a * amountOfB);
+    return partial >> 8;
+}
+
+LIB8STATIC uint8_t dim8_raw( uint8_t x ) { return scale8( x, x ); }
+LIB8STATIC uint8_t brighten8_raw( uint8_t x ) { uint8_t ix = 255 - x; return 255 - scale8( ix, ix ); }
+
+LIB8STATIC int16_t sin16( uint16_t theta ) {
+    static const uint16_t base[] = { 0, 6393, 12539, 18204, 23170, 27245, 30273, 32137 };
+    static const uint8_t slope[] = { 49, 48, 44, 38, 31, 23, 14, 4 };
+    uint16_t offset = (theta & 0x3FFF) >> 3; // 0..2047
+    if( theta & 0x4000 ) offset = 2047 - offset;
+    uint8_t section = offset / 256; // 0..7
+    uint16_t b   = base[section];
+    uint8_t  m   = slope[section];
+    uint8_t secoffset8 = (uint8_t)(offset) / 2;
+    uint16_t mx = m * secoffset8;
+    int16_t  y  = mx + b;
+    if( theta & 0x8000 ) y = -y;
+    return y;
+}
+
+LIB8STATIC int16_t cos16( uint16_t theta ) { return sin16( theta + 16384 ); }
+
+LIB8STATIC uint8_t sin8( uint8_t theta ) {
+    static const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 };
+    uint8_t offset = theta;
+    if( theta & 0x40 ) { offset = (uint8_t)255 - offset; }
+    offset &= 0x3F; // 0..63
+    uint8_t secoffset  = offset & 0x0F; // 0..15
+    if( theta & 0x40) secoffset++;
+    uint8_t section = offset >> 4; // 0..3
+    uint8_t s2 = section * 2;
+    uint8_t b   = b_m16_interleave[s2];
+    uint8_t m16 = b_m16_interleave[s2+1];
+    uint8_t mx = (m16 * secoffset) >> 4;
+    int8_t y = mx + b;
+    if( theta & 0x80 ) y = -y;
+    y += 128;
+    return y;
+}
+
+LIB8STATIC uint8_t cos8( uint8_t theta ) { return sin8( theta + 64 ); }
+
+LIB8STATIC uint8_t ease8InOutQuad( uint8_t i ) {
+    uint8_t j = i;
+    if( j & 0x80 ) { j = 255 - j; }
+    uint8_t jj  = scale8(  j, j );
+    uint8_t jj2 = jj << 1;
+    if( i & 0x80 ) { jj2 = 255 - jj2; }
+    return jj2;
+}
+
+LIB8STATIC fract8 ease8InOutCubic( fract8 i ) {
+    uint8_t ii  = scale8(  i, i );
+    uint8_t iii = scale8( ii, i );
+    uint16_t r1 = (3 * (uint16_t)(ii)) - ( 2 * (uint16_t)(iii) );
+    uint8_t result = r1;
+    if( r1 & 0x100 ) { result = 255; }
+    return result;
+}
+
+LIB8STATIC fract8 ease8InOutApprox( fract8 i ) {
+    if( i < 64 ) {
+        i /= 2;
+    } else if( i > (255 - 64) ) {
+        i = 255 - i;
+        i /= 2;
+        i = 255 - i;
+    } else {
+        i -= 64;
+        i += ( i / 2 );
+        i += 32;
+    }
+    return i;
+}
+
+LIB8STATIC uint8_t triwave8( uint8_t in ) {
+    if( in & 0x80 ) { in = 255 - in; }
+    uint8_t out = in << 1;
+    return out;
+}
+
+LIB8STATIC uint8_t quadwave8( uint8_t in ) { return ease8InOutQuad( triwave8( in ) ); }
+LIB8STATIC uint8_t cubicwave8( uint8_t in ) { return ease8InOutCubic( triwave8( in ) ); }
+
+LIB8STATIC uint16_t beat88( accum88 beats_per_minute_88, uint32_t timebase = 0 ) {
+    return ((((uint32_t)GET_MILLIS()) - timebase) * beats_per_minute_88 * 280) >> 16;
+}
+
+LIB8STATIC uint16_t beat16( accum88 beats_per_minute, uint32_t timebase = 0 ) {
+    if( beats_per_minute < 256) beats_per_minute <<= 8;
+    return beat88(beats_per_minute, timebase);
+}
+
+LIB8STATIC uint8_t beat8( accum88 beats_per_minute, uint32_t timebase = 0 ) { return beat16( beats_per_minute, timebase ) >> 8; }
+
+LIB8STATIC uint16_t beatsin88( accum88 beats_per_minute_88, uint16_t lowest = 0, uint16_t highest = 65535, uint32_t timebase = 0, uint16_t phase_offset = 0 ) {
+    uint16_t beat = beat88( beats_per_minute_88, timebase );
+    uint16_t beatsin = (sin16( beat + phase_offset ) + 32768);
+    uint16_t rangewidth = highest - lowest;
+    uint16_t scaledbeat = scale16( beatsin, rangewidth );
+    return lowest + scaledbeat;
+}
+
+LIB8STATIC uint16_t beatsin16( accum88 beats_per_minute, uint16_t lowest = 0, uint16_t highest = 65535, uint32_t timebase = 0, uint16_t phase_offset = 0 ) {
+    uint16_t beat = beat16( beats_per_minute, timebase );
+    uint16_t beatsin = (sin16( beat + phase_offset ) + 32768);
+    uint16_t rangewidth = highest - lowest;
+    uint16_t scaledbeat = scale16( beatsin, rangewidth );
+    return lowest + scaledbeat;
+}
+
+LIB8STATIC uint8_t beatsin8( accum88 beats_per_minute, uint8_t lowest = 0, uint8_t highest = 255, uint32_t timebase = 0, uint8_t phase_offset = 0 ) {
+    uint8_t beat = beat8( beats_per_minute, timebase );
+    uint8_t beatsin = sin8( beat + phase_offset );
+    uint8_t rangewidth = highest - lowest;
+    uint8_t scaledbeat = scale8( beatsin, rangewidth );
+    return lowest + scaledbeat;
+}
+
+#define FASTLED_RAND16_2053  ((uint16_t)(2053))
+#define FASTLED_RAND16_13849 ((uint16_t)(13849))
+
+extern uint16_t rand16seed;
+
+LIB8STATIC uint8_t random8() {
+    rand16seed = (rand16seed * FASTLED_RAND16_2053) + FASTLED_RAND16_13849;
+    return (uint8_t)(((uint8_t)(rand16seed & 0xFF)) + ((uint8_t)(rand16seed >> 8)));
+}
+LIB8STATIC uint16_t random16() {
+    rand16seed = (rand16seed * FASTLED_RAND16_2053) + FASTLED_RAND16_13849;
+    return rand16seed;
+}
+LIB8STATIC uint8_t random8( uint8_t lim ) { uint8_t r = random8(); r = (r*lim) >> 8; return r; }
+LIB8STATIC uint8_t random8( uint8_t min, uint8_t lim ) { uint8_t delta = lim - min; uint8_t r = random8(delta) + min; return r; }
+LIB8STATIC uint16_t random16( uint16_t lim ) { uint16_t r = random16(); uint32_t p = (uint32_t)lim * (uint32_t)r; r = p >> 16; return r; }
+LIB8STATIC uint16_t random16( uint16_t min, uint16_t lim ) { uint16_t delta = lim - min; uint16_t r = random16( delta ) + min; return r; }
+LIB8STATIC void random16_set_seed( uint16_t seed ) { rand16seed = seed; }
+LIB8STATIC uint16_t random16_get_seed() { return rand16seed; }
+LIB8STATIC void random16_add_entropy( uint16_t entropy ) { rand16seed += entropy; }
+
+/* ----------------------------------------------------------------------------------------------------------------
+ *   Pixel types
+ * ---------------------------------------------------------------------------------------------------------------- */
+
+struct CHSV {
+    union {
+        struct {
+            union { uint8_t hue; uint8_t h; };
+            union { uint8_t saturation; uint8_t sat; uint8_t s; };
+            union { uint8_t value; uint8_t val; uint8_t v; };
+        };
+        uint8_t raw[3];
+    };
+    inline CHSV() __attribute__((always_inline)) = default;
+    inline CHSV( uint8_t ih, uint8_t is, uint8_t iv ) __attribute__((always_inline)) : h(ih), s(is), v(iv) { }
+    inline CHSV& setHSV( uint8_t ih, uint8_t is, uint8_t iv ) { h = ih; s = is; v = iv; return *this; }
+};
+
+struct CRGB;
+void hsv2rgb_rainbow( const CHSV& hsv, CRGB& rgb );
+
+struct CRGB {
+    union {
+        struct {
+            union { uint8_t r; uint8_t red; };
+            union { uint8_t g; uint8_t green; };
+            union { uint8_t b; uint8_t blue; };
+        };
+        uint8_t raw[3];
+    };
+
+    typedef enum {
+        AliceBlue=0xF0F8FF, Amethyst=0x9966CC, AntiqueWhite=0xFAEBD7, Aqua=0x00FFFF, Aquamarine=0x7FFFD4, Azure=0xF0FFFF,
+        Beige=0xF5F5DC, Bisque=0xFFE4C4, Black=0x000000, BlanchedAlmond=0xFFEBCD, Blue=0x0000FF, BlueViolet=0x8A2BE2,
+        Brown=0xA52A2A, BurlyWood=0xDEB887, CadetBlue=0x5F9EA0, Chartreuse=0x7FFF00, Chocolate=0xD2691E, Coral=0xFF7F50,
+        CornflowerBlue=0x6495ED, Cornsilk=0xFFF8DC, Crimson=0xDC143C, Cyan=0x00FFFF, DarkBlue=0x00008B, DarkCyan=0x008B8B,
+        DarkGoldenrod=0xB8860B, DarkGray=0xA9A9A9, DarkGreen=0x006400, DarkKhaki=0xBDB76B, DarkMagenta=0x8B008B,
+        DarkOliveGreen=0x556B2F, DarkOrange=0xFF8C00, DarkOrchid=0x9932CC, DarkRed=0x8B0000, DarkSalmon=0xE9967A,
+        DarkSeaGreen=0x8FBC8F, DarkSlateBlue=0x483D8B, DarkSlateGray=0x2F4F4F, DarkTurquoise=0x00CED1, DarkViolet=0x9400D3,
+        DeepPink=0xFF1493, DeepSkyBlue=0x00BFFF, DimGray=0x696969, DodgerBlue=0x1E90FF, FireBrick=0xB22222,
+        FloralWhite=0xFFFAF0, ForestGreen=0x228B22, Fuchsia=0xFF00FF, Gainsboro=0xDCDCDC, GhostWhite=0xF8F8FF,
+        Gold=0xFFD700, Goldenrod=0xDAA520, Gray=0x808080, Green=0x008000, GreenYellow=0xADFF2F, Honeydew=0xF0FFF0,
+        HotPink=0xFF69B4, IndianRed=0xCD5C5C, Indigo=0x4B0082, Ivory=0xFFFFF0, Khaki=0xF0E68C, Lavender=0xE6E6FA,
+        LavenderBlush=0xFFF0F5, LawnGreen=0x7CFC00, LemonChiffon=0xFFFACD, LightBlue=0xADD8E6, LightCoral=0xF08080,
+        LightCyan=0xE0FFFF, LightGoldenrodYellow=0xFAFAD2, LightGreen=0x90EE90, LightGrey=0xD3D3D3, LightPink=0xFFB6C1,
+        LightSalmon=0xFFA07A, LightSeaGreen=0x20B2AA, LightSkyBlue=0x87CEFA, LightSlateGray=0x778899,
+        LightSteelBlue=0xB0C4DE, LightYellow=0xFFFFE0, Lime=0x00FF00, LimeGreen=0x32CD32, Linen=0xFAF0E6,
+        Magenta=0xFF00FF, Maroon=0x800000, MediumAquamarine=0x66CDAA, MediumBlue=0x0000CD, MediumOrchid=0xBA55D3,
+        MediumPurple=0x9370DB, MediumSeaGreen=0x3CB371, MediumSlateBlue=0x7B68EE, MediumSpringGreen=0x00FA9A,
+        MediumTurquoise=0x48D1CC, MediumVioletRed=0xC71585, MidnightBlue=0x191970, MintCream=0xF5FFFA,
+        MistyRose=0xFFE4E1, Moccasin=0xFFE4B5, NavajoWhite=0xFFDEAD, Navy=0x000080, OldLace=0xFDF5E6, Olive=0x808000,
+        OliveDrab=0x6B8E23, Orange=0xFFA500, OrangeRed=0xFF4500, Orchid=0xDA70D6, PaleGoldenrod=0xEEE8AA,
+        PaleGreen=0x98FB98, PaleTurquoise=0xAFEEEE, PaleVioletRed=0xDB7093, PapayaWhip=0xFFEFD5, PeachPuff=0xFFDAB9,
+        Peru=0xCD853F, Pink=0xFFC0CB, Plaid=0xCC5533, Plum=0xDDA0DD, PowderBlue=0xB0E0E6, Purple=0x800080,
+        Red=0xFF0000, RosyBrown=0xBC8F8F, RoyalBlue=0x4169E1, SaddleBrown=0x8B4513, Salmon=0xFA8072,
+        SandyBrown=0xF4A460, SeaGreen=0x2E8B57, Seashell=0xFFF5EE, Sienna=0xA0522D, Silver=0xC0C0C0, SkyBlue=0x87CEEB,
+        SlateBlue=0x6A5ACD, SlateGray=0x708090, Snow=0xFFFAFA, SpringGreen=0x00FF7F, SteelBlue=0x4682B4, Tan=0xD2B48C,
+        Teal=0x008080, Thistle=0xD8BFD8, Tomato=0xFF6347, Turquoise=0x40E0D0, Violet=0xEE82EE, Wheat=0xF5DEB3,
+        White=0xFFFFFF, WhiteSmoke=0xF5F5F5, Yellow=0xFFFF00, YellowGreen=0x9ACD32,
+        FairyLight=0xFFE42D, FairyLightNCC=0xFF9D2A
+    } HTMLColorCode;
+
+    inline CRGB() __attribute__((always_inline)) = default;
+    constexpr CRGB( uint8_t ir, uint8_t ig, uint8_t ib ) __attribute__((always_inline)) : r(ir), g(ig), b(ib) { }
+    constexpr CRGB( uint32_t colorcode ) __attribute__((always_inline)) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b((colorcode >> 0) & 0xFF) { }
+    constexpr CRGB( HTMLColorCode colorcode ) __attribute__((always_inline)) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b((colorcode >> 0) & 0xFF) { }
+    inline CRGB( const CHSV& rhs ) __attribute__((always_inline)) { hsv2rgb_rainbow( rhs, *this ); }
+    inline CRGB( const CRGB& rhs ) __attribute__((always_inline)) = default;
+    inline CRGB& operator=( const CRGB& rhs ) __attribute__((always_inline)) = default;
+    inline CRGB& operator=( const uint32_t colorcode ) __attribute__((always_inline)) { r = (colorcode >> 16) & 0xFF; g = (colorcode >> 8) & 0xFF; b = (colorcode >> 0) & 0xFF; return *this; }
+    inline CRGB& operator=( const CHSV& rhs ) __attribute__((always_inline)) { hsv2rgb_rainbow( rhs, *this ); return *this; }
+
+    inline uint8_t& operator[]( uint8_t x ) __attribute__((always_inline)) { return raw[x]; }
+    inline const uint8_t& operator[]( uint8_t x ) const __attribute__((always_inline)) { return raw[x]; }
+
+    inline CRGB& setRGB( uint8_t nr, uint8_t ng, uint8_t nb ) __attribute__((always_inline)) { r = nr; g = ng; b = nb; return *this; }
+    inline CRGB& setHSV( uint8_t hue, uint8_t sat, uint8_t val ) __attribute__((always_inline)) { hsv2rgb_rainbow( CHSV(hue, sat, val), *this ); return *this; }
+
+    inline CRGB& operator+=( const CRGB& rhs ) { r = qadd8( r, rhs.r ); g = qadd8( g, rhs.g ); b = qadd8( b, rhs.b ); return *this; }
+    inline CRGB& addToRGB( uint8_t d ) { r = qadd8( r, d ); g = qadd8( g, d ); b = qadd8( b, d ); return *this; }
+    inline CRGB& operator-=( const CRGB& rhs ) { r = qsub8( r, rhs.r ); g = qsub8( g, rhs.g ); b = qsub8( b, rhs.b ); return *this; }
+    inline CRGB& subtractFromRGB( uint8_t d ) { r = qsub8( r, d ); g = qsub8( g, d ); b = qsub8( b, d ); return *this; }
+    inline CRGB& operator|=( const CRGB& rhs ) { if( rhs.r > r ) r = rhs.r; if( rhs.g > g ) g = rhs.g; if( rhs.b > b ) b = rhs.b; return *this; }
+    inline CRGB& operator|=( uint8_t d ) { if( d > r ) r = d; if( d > g ) g = d; if( d > b ) b = d; return *this; }
+    inline CRGB& operator&=( const CRGB& rhs ) { if( rhs.r < r ) r = rhs.r; if( rhs.g < g ) g = rhs.g; if( rhs.b < b ) b = rhs.b; return *this; }
+    inline CRGB& operator%=( uint8_t scaledown ) { nscale8_video( scaledown ); return *this; }
+
+    inline CRGB& nscale8( uint8_t scaledown ) {
+        uint16_t scale_fixed = scaledown + 1;
+        r = (((uint16_t)r) * scale_fixed) >> 8;
+        g = (((uint16_t)g) * scale_fixed) >> 8;
+        b = (((uint16_t)b) * scale_fixed) >> 8;
+        return *this;
+    }
+    inline CRGB& nscale8_video( uint8_t scaledown ) {
+        uint8_t nonzeroscale = (scaledown != 0) ? 1 : 0;
+        r = (r == 0) ? 0 : (((int)r * (int)(scaledown) ) >> 8) + nonzeroscale;
+        g = (g == 0) ? 0 : (((int)g * (int)(scaledown) ) >> 8) + nonzeroscale;
+        b = (b == 0) ? 0 : (((int)b * (int)(scaledown) ) >> 8) + nonzeroscale;
+        return *this;
+    }
+    inline CRGB& fadeToBlackBy( uint8_t fadefactor ) { return nscale8( 255 - fadefactor ); }
+    inline CRGB& fadeLightBy( uint8_t fadefactor ) { return nscale8_video( 255 - fadefactor ); }
+    inline CRGB scale8( uint8_t scaledown ) const { CRGB out = *this; out.nscale8( scaledown ); return out; }
+
+    inline uint8_t getLuma() const {
+        uint8_t luma = ::scale8( r, 54 ) + ::scale8( g, 183 ) + ::scale8( b, 18 );
+        return luma;
+    }
+    inline uint8_t getAverageLight() const {
+        const uint8_t eightyfive = 85;
+        uint8_t avg = ::scale8( r, eightyfive ) + ::scale8( g, eightyfive ) + ::scale8( b, eightyfive );
+        return avg;
+    }
+    inline explicit operator bool() const __attribute__((always_inline)) { return r || g || b; }
+};
+
+inline __attribute__((always_inline)) bool operator==( const CRGB& lhs, const CRGB& rhs ) { return (lhs.r == rhs.r) && (lhs.g == rhs.g) && (lhs.b == rhs.b); }
+inline __attribute__((always_inline)) bool operator!=( const CRGB& lhs, const CRGB& rhs ) { return !(lhs == rhs); }
+inline __attribute__((always_inline)) bool operator<( const CRGB& lhs, const CRGB& rhs ) { uint16_t sl = lhs.r + lhs.g + lhs.b; uint16_t sr = rhs.r + rhs.g + rhs.b; return sl < sr; }
+inline __attribute__((always_inline)) bool operator>( const CRGB& lhs, const CRGB& rhs ) { uint16_t sl = lhs.r + lhs.g + lhs.b; uint16_t sr = rhs.r + rhs.g + rhs.b; return sl > sr; }
+// Note: matches FastLED 3.3 - the channel sums are (deliberately) accumulated in 8 bits for >= and <=
+inline __attribute__((always_inline)) bool operator>=( const CRGB& lhs, const CRGB& rhs ) { uint8_t sl = lhs.r + lhs.g + lhs.b; uint8_t sr = rhs.r + rhs.g + rhs.b; return sl >= sr; }
+inline __attribute__((always_inline)) bool operator<=( const CRGB& lhs, const CRGB& rhs ) { uint8_t sl = lhs.r + lhs.g + lhs.b; uint8_t sr = rhs.r + rhs.g + rhs.b; return sl <= sr; }
+inline __attribute__((always_inline)) CRGB operator+( const CRGB& p1, const CRGB& p2 ) { return CRGB( qadd8( p1.r, p2.r ), qadd8( p1.g, p2.g ), qadd8( p1.b, p2.b ) ); }
+inline __attribute__((always_inline)) CRGB operator-( const CRGB& p1, const CRGB& p2 ) { return CRGB( qsub8( p1.r, p2.r ), qsub8( p1.g, p2.g ), qsub8( p1.b, p2.b ) ); }
+
+/* ----------------------------------------------------------------------------------------------------------------
+ *   Color utilities
+ * ---------------------------------------------------------------------------------------------------------------- */
+
+CHSV rgb2hsv_approximate( const CRGB& rgb );
+CRGB HeatColor( uint8_t temperature );
+
+void fill_solid( CRGB *leds, int numToFill, const CRGB& color );
+void fill_rainbow( CRGB *pFirstLED, int numToFill, uint8_t initialhue, uint8_t deltahue = 5 );
+void fill_gradient_RGB( CRGB *leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor );
+void nscale8( CRGB *leds, uint16_t num_leds, uint8_t scale );
+void fadeToBlackBy( CRGB *leds, uint16_t num_leds, uint8_t fadeBy );
+void fadeLightBy( CRGB *leds, uint16_t num_leds, uint8_t fadeBy );
+void blur1d( CRGB *leds, uint16_t numLeds, fract8 blur_amount );
+
+CRGB& nblend( CRGB& existing, const CRGB& overlay, fract8 amountOfOverlay );
+void nblend( CRGB *existing, CRGB *overlay, uint16_t count, fract8 amountOfOverlay );
+CRGB blend( const CRGB& p1, const CRGB& p2, fract8 amountOfP2 );
+CRGB *blend( const CRGB *src1, const CRGB *src2, CRGB *dest, uint16_t count, fract8 amountOfsrc2 );
+
+/*!
+ *  CPixelView - A view (start + length) into an existing array of pixels.  Used by the library as CRGBSet.
+ */
+template<class PIXEL_TYPE>
+class CPixelView {
+  public:
+    const int8_t dir;
+    const int len;
+    PIXEL_TYPE * const leds;
+    PIXEL_TYPE * const end_pos;
+
+    inline CPixelView( const CPixelView & other ) : dir(other.dir), len(other.len), leds(other.leds), end_pos(other.end_pos) {}
+    inline CPixelView( PIXEL_TYPE *_leds, int _len ) : dir(_len < 0 ? -1 : 1), len(_len), leds(_leds), end_pos(_leds + _len) {}
+    inline CPixelView( PIXEL_TYPE *_leds, int _start, int _end ) : dir(((_end-_start)<0) ? -1 : 1), len((_end - _start) + dir), leds(_leds + _start), end_pos(_leds + _start + len) {}
+
+    int size() { return abs(len); }
+    bool reversed() { return len < 0; }
+
+    inline PIXEL_TYPE & operator[]( int x ) const { if (dir & 0x80) { return leds[-x]; } else { return leds[x]; } }
+    inline CPixelView operator()( int start, int end ) { return CPixelView( leds, start, end ); }
+    inline operator PIXEL_TYPE* () const { return leds; }
+
+    inline CPixelView & operator=( const PIXEL_TYPE & color ) {
+      for (int i=0; i<size(); i++) { (*this)[i] = color; }
+      return *this;
+    }
+    inline CPixelView & operator=( const CPixelView & rhs ) {
+      int n = (size() < const_cast<CPixelView &>(rhs).size()) ? size() : const_cast<CPixelView &>(rhs).size();
+      for (int i=0; i<n; i++) { (*this)[i] = rhs[i]; }
+      return *this;
+    }
+
+    inline CPixelView & nscale8( uint8_t scaledown ) { for (int i=0; i<size(); i++) { (*this)[i].nscale8(scaledown); } return *this; }
+    inline CPixelView & fadeToBlackBy( uint8_t fadeBy ) { return nscale8( 255 - fadeBy ); }
+    inline CPixelView & fill_solid( const PIXEL_TYPE & color ) { *this = color; return *this; }
+    inline CPixelView & nblend( const PIXEL_TYPE & overlay, fract8 amountOfOverlay ) {
+      for (int i=0; i<size(); i++) { ::nblend( (*this)[i], overlay, amountOfOverlay ); }
+      return *this;
+    }
+    inline CPixelView & nblend( const CPixelView & rhs, fract8 amountOfOverlay ) {
+      int n = (size() < const_cast<CPixelView &>(rhs).size()) ? size() : const_cast<CPixelView &>(rhs).size();
+      for (int i=0; i<n; i++) { ::nblend( (*this)[i], rhs[i], amountOfOverlay ); }
+      return *this;
+    }
+};
+
+typedef CPixelView<CRGB> CRGBSet;
+
+/* ----------------------------------------------------------------------------------------------------------------
+ *   Palettes
+ * ---------------------------------------------------------------------------------------------------------------- */
+
+typedef uint32_t TProgmemRGBPalette16[16];
+typedef const uint8_t TProgmemRGBGradientPalette_byte;
+typedef const TProgmemRGBGradientPalette_byte *TProgmemRGBGradientPalette_bytes;
+typedef TProgmemRGBGradientPalette_bytes TProgmemRGBGradientPaletteRef;
+
+#define DEFINE_GRADIENT_PALETTE(X) FL_ALIGN_PROGMEM extern const TProgmemRGBGradientPalette_byte X[] FL_PROGMEM =
+#define DECLARE_GRADIENT_PALETTE(X) FL_ALIGN_PROGMEM extern const TProgmemRGBGradientPalette_byte X[] FL_PROGMEM
+
+class CRGBPalette16 {
+  public:
+    CRGB entries[16];
+
+    CRGBPalette16() { }
+    CRGBPalette16( const CRGB& c00, const CRGB& c01, const CRGB& c02, const CRGB& c03,
+                   const CRGB& c04, const CRGB& c05, const CRGB& c06, const CRGB& c07,
+                   const CRGB& c08, const CRGB& c09, const CRGB& c10, const CRGB& c11,
+                   const CRGB& c12, const CRGB& c13, const CRGB& c14, const CRGB& c15 ) {
+      entries[0]=c00; entries[1]=c01; entries[2]=c02; entries[3]=c03;
+      entries[4]=c04; entries[5]=c05; entries[6]=c06; entries[7]=c07;
+      entries[8]=c08; entries[9]=c09; entries[10]=c10; entries[11]=c11;
+      entries[12]=c12; entries[13]=c13; entries[14]=c14; entries[15]=c15;
+    }
+    CRGBPalette16( const CRGBPalette16& rhs ) { memmove( (void *)&(entries[0]), &(rhs.entries[0]), sizeof(entries) ); }
+    CRGBPalette16( const CRGB rhs[16] ) { memmove( (void *)&(entries[0]), &(rhs[0]), sizeof(entries) ); }
+    CRGBPalette16( const TProgmemRGBPalette16& rhs ) { for (uint8_t i=0; i<16; i++) { entries[i] = rhs[i]; } }
+    CRGBPalette16( TProgmemRGBGradientPalette_bytes progpal ) { *this = progpal; }
+    CRGBPalette16( const CRGB& c1 ) { fill_solid( &(entries[0]), 16, c1 ); }
+
+    CRGBPalette16& operator=( const CRGBPalette16& rhs ) { memmove( (void *)&(entries[0]), &(rhs.entries[0]), sizeof(entries) ); return *this; }
+    CRGBPalette16& operator=( const TProgmemRGBPalette16& rhs ) { for (uint8_t i=0; i<16; i++) { entries[i] = rhs[i]; } return *this; }
+    CRGBPalette16& operator=( TProgmemRGBGradientPalette_bytes progpal );
+
+    bool operator==( const CRGBPalette16 &rhs ) const { return memcmp( &(entries[0]), &(rhs.entries[0]), sizeof(entries) ) == 0; }
+    bool operator!=( const CRGBPalette16 &rhs ) const { return !( *this == rhs ); }
+
+    inline CRGB& operator[]( uint8_t x ) __attribute__((always_inline)) { return entries[x]; }
+    inline const CRGB& operator[]( uint8_t x ) const __attribute__((always_inline)) { return entries[x]; }
+    inline CRGB& operator[]( int x ) __attribute__((always_inline)) { return entries[(uint8_t)x]; }
+    inline const CRGB& operator[]( int x ) const __attribute__((always_inline)) { return entries[(uint8_t)x]; }
+    operator CRGB*() { return &(entries[0]); }
+};
+
+CRGB ColorFromPalette( const CRGBPalette16& pal, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND );
+void fill_palette( CRGB *L, uint16_t N, uint8_t startIndex, uint8_t incIndex, const CRGBPalette16& pal, uint8_t brightness, TBlendType blendType );
+void nblendPaletteTowardPalette( CRGBPalette16& currentPalette, CRGBPalette16& targetPalette, uint8_t maxChanges = 24 );
+
+extern const TProgmemRGBPalette16 CloudColors_p;
+extern const TProgmemRGBPalette16 LavaColors_p;
+extern const TProgmemRGBPalette16 OceanColors_p;
+extern const TProgmemRGBPalette16 ForestColors_p;
+extern const TProgmemRGBPalette16 RainbowColors_p;
+extern const TProgmemRGBPalette16 RainbowStripeColors_p;
+extern const TProgmemRGBPalette16 PartyColors_p;
+extern const TProgmemRGBPalette16 HeatColors_p;
+
+/*!
+ *  CLEDController - one strip added with FastLED.addLeds().  showLeds() sends only that strip - here it just counts calls.
+ */
+class CLEDController {
+  public:
+    virtual ~CLEDController() { }
+    void showLeds( uint8_t brightness = 255 ) { lastBrightness = brightness; showCount++; }
+    unsigned long getShowCount() { return showCount; }
+    uint8_t getLastBrightness() { return lastBrightness; }
+  private:
+    uint8_t lastBrightness = 255;
+    unsigned long showCount = 0;
+};
+
+/*!
+ *  CFastLED - the global FastLED object.  Tracks brightness and counts calls to show() - no output is driven.
+ */
+class CFastLED {
+  public:
+    void setBrightness( uint8_t scale ) { brightness = scale; }
+    uint8_t getBrightness() { return brightness; }
+    void show() { showCount++; }
+    void show( uint8_t scale ) { brightness = scale; show(); }
+    void clear( bool writeData = false ) { if (writeData) { show(); } }
+    void delay( unsigned long ms ) { ::delay( ms ); }
+    unsigned long getShowCount() { return showCount; }
+  private:
+    uint8_t brightness = 255;
+    unsigned long showCount = 0;
+};
+
+extern CFastLED FastLED;
+
+#endif
@@ -0,0 +1,130 @@
+//
+//  ffx_profile.cpp - Host driver for profiling FFXController::update()
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Runs the primary segment (plus optional secondary segments and overlays) through FFXController::update() for a
+ *  fixed wall clock duration using FFXNullPixelController, then prints the number of updates and frames shown (and the
+ *  total pixels reported changed across those frames).
+ *  Intended to be run under perf/valgrind/callgrind:
+ *
+ *    ffx_profile [effect] [numLeds] [seconds] [numSegments] [virtual|idle] [budgetMicros] [targetFPS] [traceFile]
+ *
+ *  With "virtual", the run uses a VirtualClock advanced 1 ms per update, so seconds is animation time rather than wall
+ *  time and the run takes only as long as the rendering work itself.  "idle" is the same, but the clock is moved on to the next
+ *  time update() has anything to do (see FFXController::timeToNextUpdate()) rather than 1 ms, as a sketch that sleeps 
+ *  between updates would.  budgetMicros sets the controller's frame budget (see
+ *  FFXController::setFrameBudget()) - the average and longest update() times and the crossfade steps dropped are printed.
+ *  targetFPS turns on the frame rate governor (see FFXController::setTargetFPS()) - its changes of level are printed as 
+ *  they happen.  Built with FFX_INSTRUMENT (cmake -DFFX_INSTRUMENT=ON), the controller's stats report (see FFXRenderStats)
+ *  is printed at the end.  Built with FFX_TRACE (cmake -DFFX_TRACE=ON), the last FFX_TRACE_EVENTS trace events are written 
+ *  to traceFile as Chrome trace JSON (see FFXTrace).
+ *
+ *  effect is one of: solid, palette, chase, motion, rainbow, juggle, cylon, cycle, twinkle, dim, pacifica, fire
+ */
+#include <stdio.h>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXTestEffects.h"
+#include "FFXNullPixelController.h"
+#include "FFXTrace.h"
+
+class ProfileController : public FFXController {
+  public:
+    unsigned long governorChanges = 0;
+    virtual void onEvent( FFXSegment *segment, FXEventType event, const char *name ) override {
+      if (event == FX_GOVERNOR) {
+        governorChanges++;
+        printf( "governor: %s load=%u%% frame_us=%lu\n", name, getGovernor()->getLoad(), getGovernor()->getFrameCost() );
+      }
+      FFXController::onEvent( segment, event, name );
+    }
+};
+
+int main( int argc, char **argv ) {
+  String fxName = (argc > 1) ? String(argv[1]) : String("rainbow");
+  uint16_t numLeds = (argc > 2) ? atoi(argv[2]) : 300;
+  unsigned long seconds = (argc > 3) ? atol(argv[3]) : 5;
+  uint16_t numSegments = (argc > 4) ? atoi(argv[4]) : 0;
+  bool useIdle = (argc > 5) && String(argv[5])=="idle";
+  bool useVirtual = useIdle || ((argc > 5) && String(argv[5])=="virtual");
+  unsigned long budget = (argc > 6) ? atol(argv[6]) : 0;
+  uint16_t targetFPS = (argc > 7) ? atoi(argv[7]) : 0;
+  const char *traceFile = (argc > 8) ? argv[8] : nullptr;
+  if (numLeds == 0) { numLeds = 1; }
+
+  VirtualClock vclock;
+  if (useVirtual) { FlexClock::setClock( &vclock ); }
+
+  CRGB *leds = new CRGB[numLeds];
+  FFXNullPixelController *pc = new FFXNullPixelController( leds, numLeds );
+  ProfileController ctrlr = ProfileController();
+  ctrlr.initialize( pc );
+  ctrlr.setFrameBudget( budget );
+  ctrlr.setStringEvents( false );
+  ctrlr.setTargetFPS( targetFPS );
+
+  FFXBase *fx = createFX( fxName, numLeds );
+  if (!fx) {
+    fprintf( stderr, "Unknown effect: %s\n", fxName.c_str() );
+    return 1;
+  }
+  ctrlr.getPrimarySegment()->setFX( fx );
+  ctrlr.getPrimarySegment()->setBrightness( 255 );
+
+  if (numSegments > 0) {
+    uint16_t segLen = numLeds / (numSegments * 2);
+    if (segLen < 1) { segLen = 1; }
+    for (uint16_t i = 0; i < numSegments && (i*2+1)*segLen <= numLeds; i++) {
+      uint16_t start = i*2*segLen;
+      FFXSegment *seg = ctrlr.addSegment( String("seg") + String(i), start, start+segLen-1 );
+      seg->setFX( createFX( fxName, seg->getLength() ) );
+      seg->setOpacity( 128 );
+    }
+  }
+
+  unsigned long long updates = 0;
+  unsigned long long totalUpdateMicros = 0;
+  unsigned long maxUpdateMicros = 0;
+  unsigned long wallStart = millis();
+  unsigned long endTime = GET_TIME_MILLIS + seconds*1000UL;
+  unsigned long nextOverlay = GET_TIME_MILLIS + 1000UL;
+  while (GET_TIME_MILLIS < endTime) {
+    ctrlr.update();
+    updates++;
+    totalUpdateMicros += ctrlr.getLastUpdateMicros();
+    if (ctrlr.getLastUpdateMicros() > maxUpdateMicros) { maxUpdateMicros = ctrlr.getLastUpdateMicros(); }
+    if (useVirtual) { vclock.advance( useIdle ? maximum<unsigned long>( ctrlr.timeToNextUpdate(), 1 ) : 1 ); }
+    if (GET_TIME_MILLIS >= nextOverlay) {
+      ctrlr.setOverlayFX( new PulseOverlayFX( numLeds, 220, 1, NamedPalettes::getInstance()["blue"] ) );
+      nextOverlay += 2000UL;
+    }
+  }
+
+  printf( "effect=%s leds=%u segments=%u seconds=%lu updates=%llu frames=%llu shown=%lu changed_px=%llu wall_ms=%lu\n",
+          fxName.c_str(), numLeds, numSegments, seconds, updates, ctrlr.showCount, pc->getShowCount(), pc->getChangedPixels(), millis()-wallStart );
+  printf( "budget_us=%lu avg_update_us=%.1f max_update_us=%lu base_update_us=%lu dropped_blends=%lu\n",
+          budget, updates ? (double)totalUpdateMicros/updates : 0.0, maxUpdateMicros, ctrlr.getBaseUpdateMicros(), ctrlr.getDroppedBlendSteps() );
+  if (targetFPS) {
+    printf( "target_fps=%u governor_level=%s governor_changes=%lu\n", targetFPS, FFXGovernor::getLevelName( ctrlr.getGovernor()->getLevel() ), ctrlr.governorChanges );
+  }
+#ifdef FFX_INSTRUMENT
+  char report[8192];
+  ctrlr.getStatsReport( report, sizeof(report) );
+  printf( "%s\n", report );
+#endif
+  if (traceFile) {
+#ifdef FFX_TRACE
+    FFXTrace::setEnabled( false );
+    if (!FFXTrace::saveChromeTrace( traceFile )) { fprintf( stderr, "Can't write %s\n", traceFile ); }
+    printf( "trace_events=%lu of %lu written to %s\n", (unsigned long)FFXTrace::getEventCount(), (unsigned long)FFXTrace::getTotalEvents(), traceFile );
+#else
+    fprintf( stderr, "Not built with FFX_TRACE - no trace written\n" );
+#endif
+  }
+  FlexClock::setClock( nullptr );
+  delete[] leds;
+  return 0;
+}
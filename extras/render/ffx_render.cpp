@@ -0,0 +1,243 @@
+//
+//  ffx_render.cpp - Offline renderer for FastFX scenes
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Builds an FFXController from a scene description, runs it under a VirtualClock and writes every frame shown to a file
+ *  with FFXFilePixelController - as fast as the CPU allows, rather than at LED wire speed.
+ *
+ *    ffx_render scene.txt out.ffx [raw|delta]
+ *    ffx_render --compare a.ffx b.ffx
+ *
+ *  --compare reads two frame files and reports the first frame (and how many frames) that differ - e.g. to check that a
+ *  change to the library doesn't change a show's output.  It exits with 1 if they differ.
+ *
+ *  Scene files have one command per line (# starts a comment).  Commands are run before the first update, or at the
+ *  given time (ms of virtual time) when prefixed with "at <ms>".  <seg> is a segment tag, or "primary".
+ *
+ *    leds <n>                              - strip length (must come before anything else, default 300)
+ *    seconds <n>                           - length of the show (default 10)
+ *    step <ms>                             - advance the clock by this much per update - 0 (the default) moves it on to the
+ *                                            next time update() has anything to do (see FFXController::timeToNextUpdate())
+ *    segment <seg> <first> <last>          - add a segment
+ *    fx <seg> <effect>                     - solid, palette, chase, motion, rainbow, juggle, cylon, cycle, twinkle, dim,
+ *                                            pacifica or fire
+ *    interval <seg> <ms>                   - effect interval
+ *    palette <seg> <name>                  - effect palette (see NamedPalettes)
+ *    color <seg> <rrggbb>                  - effect color
+ *    brightness <seg> <0-255>              - the primary segment starts at 0, so a scene will normally set this
+ *    opacity <seg> <0-255>
+ *    crossfade <seg> on|off
+ *    overlay <seg> <pulse|wave|zip> [speed] [palette]
+ *
+ *  For example:
+ *
+ *    leds 150
+ *    seconds 20
+ *    fx primary rainbow
+ *    brightness primary 200
+ *    segment Sign 40 79
+ *    fx Sign cylon
+ *    opacity Sign 255
+ *    at 5000 overlay primary pulse 220 blue
+ *    at 10000 brightness Sign 0
+ */
+#include <stdio.h>
+#include <chrono>
+#include <algorithm>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXTestEffects.h"
+#include "FFXFilePixelController.h"
+
+struct SceneCommand {
+  unsigned long at = 0;
+  int line = 0;
+  std::vector<String> words;
+};
+
+static std::vector<String> splitWords( const String &text ) {
+  std::vector<String> result;
+  const char *p = text.c_str();
+  while (*p) {
+    while (*p == ' ' || *p == '\t') { p++; }
+    const char *start = p;
+    while (*p && *p != ' ' && *p != '\t') { p++; }
+    if (p > start) { result.push_back( String( std::string( start, p-start ) ) ); }
+  }
+  return result;
+}
+
+static FFXSegment *sceneSegment( FFXController &ctrlr, const String &tag ) {
+  if (tag=="primary") { return ctrlr.getPrimarySegment(); }
+  return ctrlr.getSegment( ctrlr.getSegmentHandle( tag ) );
+}
+
+static bool runCommand( FFXController &ctrlr, const SceneCommand &cmd ) {
+  const std::vector<String> &w = cmd.words;
+  const String &op = w[0];
+  if (op=="leds" || op=="seconds" || op=="step") { return true; }
+  if (w.size() < 2) { return false; }
+  if (op=="segment") {
+    if (w.size() < 4) { return false; }
+    long first = w[2].toInt();
+    long last = w[3].toInt();
+    if (first < 0 || last < first || last >= ctrlr.getStripController()->getNumLeds()) { return false; }
+    return ctrlr.addSegment( w[1], first, last ) != nullptr;
+  }
+  FFXSegment *seg = sceneSegment( ctrlr, w[1] );
+  if (!seg) { return false; }
+  if (op=="fx" && w.size() > 2) {
+    FFXBase *fx = createFX( w[2], seg->getLength() );
+    if (fx) { seg->setFX( fx ); }
+    return fx != nullptr;
+  }
+  if (op=="interval" && w.size() > 2 && seg->getFX()) { seg->getFX()->setInterval( w[2].toInt() ); return true; }
+  if (op=="palette" && w.size() > 2 && seg->getFX()) {
+    seg->getFX()->getFXColor().setPalette( NamedPalettes::getInstance()[w[2]] );
+    return true;
+  }
+  if (op=="color" && w.size() > 2 && seg->getFX()) {
+    seg->getFX()->getFXColor().setColorMode( FFXColor::FFXColorMode::singleCRGB );
+    seg->getFX()->getFXColor().setCRGB( CRGB( strtoul( w[2].c_str(), nullptr, 16 ) ) );
+    return true;
+  }
+  if (op=="brightness" && w.size() > 2) { seg->setBrightness( w[2].toInt() ); return true; }
+  if (op=="opacity" && w.size() > 2) { seg->setOpacity( w[2].toInt() ); return true; }
+  if (op=="crossfade" && w.size() > 2) { seg->getFrameProvider()->setCrossFadePref( w[2]=="on" ); return true; }
+  if (op=="overlay" && w.size() > 2) {
+    FFXOverlay *ovl = createOverlay( w[2], seg->getLength(), (w.size() > 3) ? w[3].toInt() : 220, 1 );
+    if (!ovl) { return false; }
+    if (w.size() > 4) { ovl->getFXColor().setPalette( NamedPalettes::getInstance()[w[4]] ); }
+    seg->setOverlay( ovl );
+    return true;
+  }
+  return false;
+}
+
+static bool loadScene( const char *path, std::vector<SceneCommand> &commands ) {
+  FILE *in = fopen( path, "r" );
+  if (!in) { return false; }
+  char text[256];
+  int line = 0;
+  while (fgets( text, sizeof(text), in )) {
+    line++;
+    char *comment = strchr( text, '#' );
+    if (comment) { *comment = 0; }
+    text[strcspn( text, "\r\n" )] = 0;
+    SceneCommand cmd;
+    cmd.line = line;
+    cmd.words = splitWords( String( text ) );
+    if (cmd.words.size() >= 2 && cmd.words[0]=="at") {
+      cmd.at = cmd.words[1].toInt();
+      cmd.words.erase( cmd.words.begin(), cmd.words.begin()+2 );
+    }
+    if (!cmd.words.empty()) { commands.push_back( cmd ); }
+  }
+  fclose( in );
+  // timed commands in time order, otherwise as written
+  std::stable_sort( commands.begin(), commands.end(), []( const SceneCommand &a, const SceneCommand &b ) { return a.at < b.at; } );
+  return true;
+}
+
+static unsigned long sceneValue( const std::vector<SceneCommand> &commands, const char *name, unsigned long defaultValue ) {
+  for (const SceneCommand &cmd : commands) {
+    if (cmd.at == 0 && cmd.words[0]==name && cmd.words.size() > 1) { return cmd.words[1].toInt(); }
+  }
+  return defaultValue;
+}
+
+static int compareFiles( const char *pathA, const char *pathB ) {
+  FFXFrameFileReader a, b;
+  if (!a.open( pathA )) { fprintf( stderr, "Can't read %s\n", pathA ); return 2; }
+  if (!b.open( pathB )) { fprintf( stderr, "Can't read %s\n", pathB ); return 2; }
+  if (a.getNumLeds() != b.getNumLeds()) {
+    printf( "leds differ: %u vs %u\n", a.getNumLeds(), b.getNumLeds() );
+    return 1;
+  }
+  unsigned long frames = 0;
+  unsigned long differing = 0;
+  long firstDiff = -1;
+  uint8_t maxDelta = 0;
+  bool moreA, moreB;
+  while ((moreA = a.readFrame()) & (moreB = b.readFrame())) {
+    bool differs = (a.getMicros() != b.getMicros()) || (a.getBrightness() != b.getBrightness());
+    for (uint16_t i = 0; i < a.getNumLeds(); i++) {
+      for (uint8_t c = 0; c < 3; c++) {
+        uint8_t delta = abs( (int)a.getFrame()[i].raw[c] - (int)b.getFrame()[i].raw[c] );
+        if (delta) { differs = true; maxDelta = maximum( maxDelta, delta ); }
+      }
+    }
+    if (differs) {
+      if (firstDiff < 0) {
+        firstDiff = frames;
+        printf( "first difference: frame %lu (%.3fs / %.3fs)\n", frames, a.getMicros()/1e6, b.getMicros()/1e6 );
+      }
+      differing++;
+    }
+    frames++;
+  }
+  printf( "frames=%lu/%lu differing=%lu max_channel_delta=%u\n", a.getFrameCount(), b.getFrameCount(), differing, maxDelta );
+  return (differing || moreA != moreB) ? 1 : 0;
+}
+
+int main( int argc, char **argv ) {
+  if (argc > 3 && String(argv[1])=="--compare") { return compareFiles( argv[2], argv[3] ); }
+  if (argc < 3) {
+    fprintf( stderr, "usage: ffx_render scene.txt out.ffx [raw|delta]\n       ffx_render --compare a.ffx b.ffx\n" );
+    return 2;
+  }
+  std::vector<SceneCommand> commands;
+  if (!loadScene( argv[1], commands )) { fprintf( stderr, "Can't read %s\n", argv[1] ); return 2; }
+  FFXFilePixelController::Format format = (argc > 3 && String(argv[3])=="raw") ? FFXFilePixelController::RAW : FFXFilePixelController::DELTA;
+  uint16_t numLeds = sceneValue( commands, "leds", 300 );
+  unsigned long seconds = sceneValue( commands, "seconds", 10 );
+  unsigned long step = sceneValue( commands, "step", 0 );
+  if (numLeds == 0) { numLeds = 1; }
+
+  VirtualClock vclock;
+  FlexClock::setClock( &vclock );
+  CRGB *leds = new CRGB[numLeds]();
+  FFXFilePixelController *pc = new FFXFilePixelController( leds, numLeds, argv[2], format );
+  if (!pc->isOpen()) { fprintf( stderr, "Can't write %s\n", argv[2] ); return 2; }
+  FFXController ctrlr = FFXController();
+  ctrlr.initialize( pc );
+  ctrlr.setStringEvents( false );
+
+  auto wallStart = std::chrono::steady_clock::now();
+  unsigned long start = GET_TIME_MILLIS;
+  unsigned long endTime = start + seconds*1000UL;
+  unsigned long long updates = 0;
+  size_t next = 0;
+  int errors = 0;
+  while (GET_TIME_MILLIS < endTime) {
+    unsigned long now = GET_TIME_MILLIS - start;
+    for (; next < commands.size() && commands[next].at <= now; next++) {
+      if (!runCommand( ctrlr, commands[next] )) {
+        fprintf( stderr, "%s:%d: can't run \"%s\"\n", argv[1], commands[next].line, commands[next].words[0].c_str() );
+        errors++;
+      }
+    }
+    ctrlr.update();
+    updates++;
+    unsigned long advance = step ? step : maximum<unsigned long>( ctrlr.timeToNextUpdate(), 1 );
+    // stop for the next command and for the end of the show
+    if (next < commands.size()) { advance = minimum( advance, maximum<unsigned long>( commands[next].at - now, 1 ) ); }
+    advance = minimum( advance, endTime - GET_TIME_MILLIS );
+    vclock.advance( advance );
+  }
+  double wallMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - wallStart ).count();
+
+  unsigned long frames = pc->getFrameCount();
+  unsigned long long bytes = pc->getBytesWritten();
+  bool ok = pc->close();
+  FlexClock::setClock( nullptr );
+  printf( "leds=%u seconds=%lu updates=%llu frames=%lu bytes=%llu format=%s wall_ms=%.1f frames_per_sec=%.0f\n",
+          numLeds, seconds, updates, frames, bytes, (format==FFXFilePixelController::RAW) ? "raw" : "delta", wallMs,
+          wallMs > 0 ? frames*1000.0/wallMs : 0.0 );
+  if (!ok) { fprintf( stderr, "Error writing %s\n", argv[2] ); }
+  delete[] leds;
+  return (!ok || errors) ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+//
+//  test_culling.cpp - A segment that was skipped while hidden against one that was drawn all along
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Runs two controllers side by side under one virtual clock, each with an effect on the primary segment and a secondary
+ *  segment over part of it.  In the first, the secondary segment is hidden (opacity 0) for a while - so it is skipped, and
+ *  its effect caught up when it is shown again - in the second it is drawn all along.  Once the first has faded back in
+ *  (and a crossfade has had a step to settle), both must show exactly the same pixels, with the secondary effect in the
+ *  same phase.  Runs each effect with crossfade on and off, with an update every 1ms (steps are counted from the effect's
+ *  timer, so they line up exactly when there is an update every tick).
+ *
+ *    test_culling
+ *
+ *  Exits with 1 if any case differs.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXTestEffects.h"
+#include "FFXNullPixelController.h"
+
+static const uint16_t NUM_LEDS = 100;
+static const unsigned long HIDE_MS = 2750;
+static const unsigned long SHOW_MS = 4000;
+static const unsigned long COMPARE_MS = 4500;
+static const unsigned long END_MS = 9000;
+
+struct Run {
+  CRGB *leds;
+  FFXController *ctrlr;
+  FFXSegment *top;
+};
+
+static Run setup( const char *name, bool crossFade ) {
+  Run run;
+  run.leds = new CRGB[NUM_LEDS]();
+  run.ctrlr = new FFXController();
+  run.ctrlr->initialize( new FFXNullPixelController( run.leds, NUM_LEDS ) );
+  run.ctrlr->getPrimarySegment()->setFX( new PaletteFX( NUM_LEDS ) );
+  run.top = run.ctrlr->addSegment( "Top", 20, 79 );
+  run.top->setFX( createFX( name, run.top->getLength() ) );
+  run.top->setOpacityInterval( 100 );
+  run.top->setOpacity( 255 );
+  for (uint8_t i = 0; i < run.ctrlr->getSegmentCount(); i++) { run.ctrlr->getSegment( i )->getFrameProvider()->setCrossFadePref( crossFade ); }
+  run.ctrlr->setBrightness( 255 );
+  return run;
+}
+
+static bool compare( const char *name, bool crossFade ) {
+  const unsigned long stepMs = 1;
+  VirtualClock vclock;
+  FlexClock::setClock( &vclock );
+  Run culled = setup( name, crossFade );
+  Run drawn = setup( name, crossFade );
+  unsigned long differing = 0;
+  unsigned long firstDiffering = 0;
+  for (unsigned long ms = 0; ms < END_MS; ms += stepMs) {
+    if (ms == HIDE_MS) { culled.top->setOpacity( 0 ); }
+    if (ms == SHOW_MS) { culled.top->setOpacity( 255 ); }
+    culled.ctrlr->update();
+    drawn.ctrlr->update();
+    if (ms >= COMPARE_MS && memcmp( (void *)culled.leds, (void *)drawn.leds, NUM_LEDS*sizeof(CRGB) ) != 0) {
+      if (!differing) { firstDiffering = ms; }
+      differing++;
+    }
+    vclock.advance( stepMs );
+  }
+  FFXBase *culledFX = culled.top->getFX();
+  FFXBase *drawnFX = drawn.top->getFX();
+  bool ok = (differing == 0 && culledFX->getCurrCycle() == drawnFX->getCurrCycle() && culledFX->getCurrPhase() == drawnFX->getCurrPhase());
+  printf( "%-8s %-9s  phase %lu/%u vs %lu/%u  differing=%lu", name, crossFade ? "crossfade" : "direct",
+          culledFX->getCurrCycle(), culledFX->getCurrPhase(), drawnFX->getCurrCycle(), drawnFX->getCurrPhase(), differing );
+  if (differing) { printf( " (from %lums)", firstDiffering ); }
+  printf( "  %s\n", ok ? "ok" : "FAILED" );
+  FlexClock::setClock( nullptr );
+  delete culled.ctrlr;
+  delete drawn.ctrlr;
+  delete[] culled.leds;
+  delete[] drawn.leds;
+  return ok;
+}
+
+int main( int argc, char **argv ) {
+  int failed = 0;
+  for (const char *name : { "rainbow", "chase", "cylon" }) {
+    for (bool crossFade : { false, true }) {
+      if (!compare( name, crossFade )) { failed++; }
+    }
+  }
+  printf( "%s - %d cases differ\n", failed ? "FAILED" : "passed", failed );
+  return failed ? 1 : 0;
+}
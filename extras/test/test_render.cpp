@@ -0,0 +1,198 @@
+//
+//  test_render.cpp - Rendered output of the core effects and a multi-segment scene against stored hashes
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+/*
+ *  Runs each core effect (and the wave, pulse and zip overlays) on the primary segment with crossfade on and off, plus a
+ *  scene with overlapping translucent and opaque segments, brightness and opacity fades, a hidden segment and overlays,
+ *  under a virtual clock.  Every frame shown - pixels and brightness - is folded into a hash, which is compared with
+ *  extras/test/render_hashes.txt (render_hashes_micros.txt with FFX_TIMER_MICROS, where effects step at slightly different 
+ *  times).  Any change to what is shown, or when, changes the hash - so optimizations that are meant to leave the output 
+ *  alone can be checked by running ctest:
+ *
+ *    test_render [--hashes file] [--update] [--filter text]
+ *
+ *  --update writes the hashes of this build to the file (after a deliberate change to the output).  Exits with 1 if a
+ *  hash differs or is missing, 2 if the file couldn't be read or written.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "FastFX.h"
+#include "FFXCoreEffects.h"
+#include "FFXTestEffects.h"
+#include "FFXNullPixelController.h"
+
+/*! Folds every frame shown into an FNV-1a hash */
+class HashPixelController : public FFXNullPixelController {
+  public:
+    HashPixelController( CRGB *initLeds, uint16_t numLeds ) : FFXNullPixelController( initLeds, numLeds ) { }
+    virtual void show() override { addFrame(); FFXNullPixelController::show(); }
+    virtual void showChanged( uint16_t firstChanged, uint16_t lastChanged ) override {
+      addFrame();
+      FFXNullPixelController::showChanged( firstChanged, lastChanged );
+    }
+    uint64_t getHash() { return hash; }
+
+  private:
+    uint64_t hash = 14695981039346656037ULL;
+    void add( uint8_t value ) { hash = (hash ^ value) * 1099511628211ULL; }
+    void addFrame() {
+      add( getBrightness() );
+      for (uint16_t i = 0; i < getNumLeds(); i++) { add( getLeds()[i].r ); add( getLeds()[i].g ); add( getLeds()[i].b ); }
+    }
+};
+
+struct Scenario {
+  String name;
+  uint64_t hash;
+  unsigned long frames;
+};
+
+static const char *effectNames[] = { "solid", "palette", "chase", "motion", "rainbow", "juggle", "cylon", "cycle", "twinkle", "dim",
+                                     "pacifica", "fire", "wave", "pulse", "zip" };
+static const uint16_t NUM_LEDS = 60;
+static const unsigned long STEP_MS = 5;          // virtual time per update()
+static const unsigned long RUN_MS = 10000;
+
+/*! Runs ctrlr for RUN_MS of virtual time, calling tick (if given) with the elapsed time before each update */
+static void run( FFXController *ctrlr, VirtualClock &vclock, void (*tick)( FFXController *ctrlr, unsigned long ms ) ) {
+  for (unsigned long ms = 0; ms < RUN_MS; ms += STEP_MS) {
+    if (tick) { tick( ctrlr, ms ); }
+    ctrlr->update();
+    vclock.advance( STEP_MS );
+  }
+}
+
+static Scenario runEffect( const char *name, bool crossFade ) {
+  VirtualClock vclock;
+  FlexClock::setClock( &vclock );
+  random16_set_seed( 1337 );
+  CRGB *leds = new CRGB[NUM_LEDS]();
+  HashPixelController *pc = new HashPixelController( leds, NUM_LEDS );
+  FFXController *ctrlr = new FFXController();
+  ctrlr->initialize( pc );
+  FFXSegment *primary = ctrlr->getPrimarySegment();
+  FFXBase *fx = isOverlay( name ) ? (FFXBase *)createOverlay( name, NUM_LEDS, 220, 3 ) : createFX( name, NUM_LEDS );
+  if (isOverlay( name )) {
+    primary->setFX( new SolidFX( NUM_LEDS ) );
+    primary->setOverlay( (FFXOverlay *)fx );
+  }
+  else {
+    primary->setFX( fx );
+  }
+  primary->getFrameProvider()->setCrossFadePref( crossFade );
+  ctrlr->setBrightness( 255 );
+  run( ctrlr, vclock, nullptr );
+  Scenario result = { String(name) + (crossFade ? "_crossfade" : "_direct"), pc->getHash(), pc->getShowCount() };
+  FlexClock::setClock( nullptr );
+  delete ctrlr;
+  delete[] leds;
+  return result;
+}
+
+static void tickScene( FFXController *ctrlr, unsigned long ms ) {
+  switch (ms) {
+    case 1000 : { ctrlr->findSegment( "Left" )->setOpacity( 0 ); break; }
+    case 2000 : { ctrlr->findSegment( "Middle" )->setBrightness( 40 ); break; }
+    case 3000 : { ctrlr->setOverlayFX( new PulseOverlayFX( NUM_LEDS, 220, 1 ) ); break; }
+    case 4000 : { ctrlr->findSegment( "Left" )->setOpacity( 255 ); break; }
+    case 5000 : { ctrlr->findSegment( "Right" )->getFX()->setSpeed( 200 ); break; }
+    case 6000 : { ctrlr->findSegment( "Right" )->setOverlay( new ZipOverlayFX( 20, 220, 1 ) ); break; }
+    case 7000 : { ctrlr->setBrightness( 80 ); break; }
+    case 8000 : { ctrlr->findSegment( "Middle" )->setBrightness( 0 ); break; }
+    case 9000 : { ctrlr->findSegment( "Middle" )->setBrightness( 255 ); break; }
+  }
+}
+
+static Scenario runScene( bool crossFade ) {
+  VirtualClock vclock;
+  FlexClock::setClock( &vclock );
+  random16_set_seed( 1337 );
+  CRGB *leds = new CRGB[NUM_LEDS]();
+  HashPixelController *pc = new HashPixelController( leds, NUM_LEDS );
+  FFXController *ctrlr = new FFXController();
+  ctrlr->initialize( pc );
+  FFXSegment *primary = ctrlr->getPrimarySegment();
+  primary->setFX( new RainbowFX( NUM_LEDS ) );
+  FFXSegment *left = ctrlr->addSegment( "Left", 0, 24 );
+  left->setFX( new CylonFX( left->getLength() ) );
+  left->setOpacity( 255 );
+  FFXSegment *middle = ctrlr->addSegment( "Middle", 15, 44 );
+  middle->setFX( new JuggleFX( middle->getLength() ) );
+  middle->setOpacity( 160 );
+  FFXSegment *right = ctrlr->addSegment( "Right", 40, 59 );
+  right->setFX( new ChaseFX( right->getLength() ) );
+  right->setOpacity( 255 );
+  for (uint8_t i = 0; i < ctrlr->getSegmentCount(); i++) { ctrlr->getSegment( i )->getFrameProvider()->setCrossFadePref( crossFade ); }
+  ctrlr->setBrightness( 255 );
+  run( ctrlr, vclock, tickScene );
+  Scenario result = { String("scene") + (crossFade ? "_crossfade" : "_direct"), pc->getHash(), pc->getShowCount() };
+  FlexClock::setClock( nullptr );
+  delete ctrlr;
+  delete[] leds;
+  return result;
+}
+
+static bool readHashes( const char *fileName, std::vector<Scenario> &hashes ) {
+  FILE *in = fopen( fileName, "r" );
+  if (!in) { return false; }
+  char name[64];
+  unsigned long long hash;
+  unsigned long frames;
+  while (fscanf( in, "%63s %llx %lu", name, &hash, &frames ) == 3) { hashes.push_back( { String(name), hash, frames } ); }
+  fclose( in );
+  return true;
+}
+
+static bool writeHashes( const char *fileName, const std::vector<Scenario> &results ) {
+  FILE *out = fopen( fileName, "w" );
+  if (!out) { return false; }
+  for (const Scenario &result : results) {
+    fprintf( out, "%-20s %016llx %lu\n", result.name.c_str(), (unsigned long long)result.hash, result.frames );
+  }
+  return fclose( out ) == 0;
+}
+
+int main( int argc, char **argv ) {
+  const char *hashFile = "render_hashes.txt";
+  bool update = false;
+  String filter = "";
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp( argv[i], "--hashes" ) && i+1 < argc) { hashFile = argv[++i]; }
+    else if (!strcmp( argv[i], "--update" )) { update = true; }
+    else if (!strcmp( argv[i], "--filter" ) && i+1 < argc) { filter = argv[++i]; }
+    else {
+      fprintf( stderr, "usage: test_render [--hashes file] [--update] [--filter text]\n" );
+      return 2;
+    }
+  }
+
+  std::vector<Scenario> results;
+  for (const char *name : effectNames) {
+    for (bool crossFade : { true, false }) { results.push_back( runEffect( name, crossFade ) ); }
+  }
+  results.push_back( runScene( true ) );
+  results.push_back( runScene( false ) );
+
+  if (update) {
+    if (!writeHashes( hashFile, results )) { fprintf( stderr, "Can't write %s\n", hashFile ); return 2; }
+    printf( "Wrote %u hashes to %s\n", (unsigned)results.size(), hashFile );
+    return 0;
+  }
+  std::vector<Scenario> expected;
+  if (!readHashes( hashFile, expected )) { fprintf( stderr, "Can't read %s\n", hashFile ); return 2; }
+  int failed = 0;
+  for (const Scenario &result : results) {
+    if (filter.length() > 0 && result.name.indexOf( filter ) < 0) { continue; }
+    const Scenario *match = nullptr;
+    for (const Scenario &exp : expected) { if (exp.name == result.name) { match = &exp; } }
+    bool ok = match && match->hash == result.hash && match->frames == result.frames;
+    if (!ok) { failed++; }
+    printf( "%-20s %016llx %6lu  %s\n", result.name.c_str(), (unsigned long long)result.hash, result.frames,
+            ok ? "ok" : (match ? "DIFFERS" : "MISSING") );
+  }
+  printf( "%s - %d of %u differ\n", failed ? "FAILED" : "passed", failed, (unsigned)results.size() );
+  return failed ? 1 : 0;
+}
@@ -1,11 +1,10 @@
 #include "FFXAFXFader.h"
 
 void FFXAFXFader::onUpdate( CRGBSet &pixels ) {
-  if (getValue() < 255)  {
+  if (getValue() < 255 && background)  {
     pixels = pixels.nblend( CRGBSet(background, size), 255-getValue() );
   }
   if (getValue()==255 && !isFading() ) {
     freeBackgroundBuffer();
   }
 }
-
@@ -10,21 +10,24 @@
 #include "FFXAutoFader.h"
 
 /*!
- *  FFXAFXfader - Autofader for Opacity, must use a background buffer to facilitate 
- *  fading.  Buffer is automatically allocated as needed.  May be deallocated by calling
- *  freeBackgroundBuffer().  Override for onUpdate() draws fame blended with background
- *  contained in the buffer.
+ *  FFXAFXfader - Autofader for Opacity.  A segment's frame is blended with the primary segment's
+ *  frame by FFXCompositor, using the fader's value, so segments no longer call onUpdate() or use the 
+ *  background buffer.  Both are kept (deprecated) for code that blends with a buffer of its own - the 
+ *  buffer is allocated by getBackgroundBuffer() and may be deallocated by calling freeBackgroundBuffer().
  */
 class FFXAFXFader: public FFXAutoFader {
   public:
     FFXAFXFader(uint16_t pixels) : FFXAutoFader() { size = pixels; }
     virtual ~FFXAFXFader() { if (background) { free( background); } }
+    /*! Deprecated - blends pixels with the background buffer */
     virtual void onUpdate( CRGBSet &pixels ) override; 
+    /*! Deprecated - nothing in the library fills this buffer any more */
     CRGB *getBackgroundBuffer() { if (!background) { background = (CRGB *)malloc(sizeof(CRGB)*size); } return background; } 
+    /*! Deprecated */
     void freeBackgroundBuffer() { if (background) { free( background ); background = nullptr; } }
     private:
       uint16_t size;
       CRGB* background = nullptr;   
 };
 
-#endif
\ No newline at end of file
+#endif
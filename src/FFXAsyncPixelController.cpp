@@ -0,0 +1,114 @@
+//
+//  FFXAsyncPixelController.cpp
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "FFXAsyncPixelController.h"
+#include "FlexTimer.h"
+
+FFXAsyncPixelController::FFXAsyncPixelController( FFXPixelController *initOutput ) :
+  FFXPixelController( nullptr, initOutput->getNumLeds() ) {
+  output = initOutput;
+  CRGB *back = (CRGB *)malloc( getNumLeds()*sizeof(CRGB) );
+  if (back && output->getLeds()) { memmove8( back, output->getLeds(), getNumLeds()*sizeof(CRGB) ); }
+  setLeds( back );
+#if FFX_ASYNC_THREADS
+  sender = std::thread( &FFXAsyncPixelController::run, this );
+#endif
+}
+
+FFXAsyncPixelController::~FFXAsyncPixelController() {
+#if FFX_ASYNC_THREADS
+  {
+    std::lock_guard<std::mutex> guard( lock );
+    stopping = true;
+  }
+  signal.notify_all();
+  sender.join();
+#endif
+  delete output;
+  free( getLeds() );
+}
+
+void FFXAsyncPixelController::send( uint16_t firstChanged, uint16_t lastChanged, uint8_t brightness ) {
+  if (brightness != output->getBrightness()) {
+    // setBrightness() shows the output's frame - which is already the new one
+    output->setBrightness( brightness );
+  }
+  else {
+    output->showChanged( firstChanged, lastChanged );
+  }
+}
+
+void FFXAsyncPixelController::showChanged( uint16_t firstChanged, uint16_t lastChanged ) {
+  if (!getLeds() || !output->getLeds()) { return; }
+#if FFX_ASYNC_THREADS
+  if (busy) {
+    waitCount++;
+    waitForShow();
+  }
+#endif
+  // The whole frame is copied - pixels outside the changed span may still differ if the frame was rotated (center offset)
+  memmove8( output->getLeds(), getLeds(), getNumLeds()*sizeof(CRGB) );
+  showCount++;
+  sendStart = micros();
+#if FFX_ASYNC_THREADS
+  {
+    std::lock_guard<std::mutex> guard( lock );
+    // changes in a frame the output put off go out with this one
+    FFXSpan span = FFXSpan( firstChanged, lastChanged );
+    if (deferred) { span.add( deferredSpan ); }
+    sendFirst = span.first;
+    sendLast = span.last;
+    sendBrightness = getBrightness();
+    busy = true;
+  }
+  signal.notify_all();
+#else
+  send( firstChanged, lastChanged, getBrightness() );
+#endif
+}
+
+unsigned long FFXAsyncPixelController::timeToShowTicks() {
+  if (!isShowComplete()) {
+    unsigned long since = micros() - sendStart;
+    unsigned long wire = output->getWireMicros();
+    unsigned long remaining = (since < wire) ? wire - since : 0;
+    unsigned long ticks = (FLEX_TICKS_PER_MS == 1) ? (remaining+999)/1000 : remaining;
+    return (ticks > 0) ? ticks : 1;
+  }
+#if FFX_ASYNC_THREADS
+  std::lock_guard<std::mutex> guard( lock );
+  if (!deferred) { return ULONG_MAX; }
+#endif
+  return output->timeToShowTicks();
+}
+
+#if FFX_ASYNC_THREADS
+void FFXAsyncPixelController::waitForShow() {
+  std::unique_lock<std::mutex> guard( lock );
+  signal.wait( guard, [this]{ return !busy; } );
+}
+
+void FFXAsyncPixelController::run() {
+  std::unique_lock<std::mutex> guard( lock );
+  while (true) {
+    signal.wait( guard, [this]{ return busy || stopping; } );
+    if (stopping && !busy) { break; }
+    uint16_t first = sendFirst;
+    uint16_t last = sendLast;
+    uint8_t brightness = sendBrightness;
+    guard.unlock();
+    // a brightness change shows the whole frame
+    FFXSpan span = (brightness != output->getBrightness()) ? FFXSpan( 0, getNumLeds()-1 ) : FFXSpan( first, last );
+    send( first, last, brightness );
+    bool putOff = (output->isShowComplete() && output->timeToShowTicks() != ULONG_MAX);
+    guard.lock();
+    deferred = putOff;
+    deferredSpan = putOff ? span : FFXSpan();
+    busy = false;
+    signal.notify_all();
+  }
+}
+#endif
@@ -0,0 +1,96 @@
+//
+//  FFXAsyncPixelController.h
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#ifndef FFX_ASYNC_PIXEL_CONTROLLER_H
+#define FFX_ASYNC_PIXEL_CONTROLLER_H
+
+#include "FFXBase.h"
+#include "FFXPixelController.h"
+
+// Send frames from a background thread - where std::thread is available (host builds and ESP32, where it runs as a
+// FreeRTOS task).  Elsewhere show() sends the frame before it returns, as other pixel controllers do.
+#ifndef FFX_ASYNC_THREADS
+  #if defined(FFX_HOST_BUILD) || defined(ESP32)
+    #define FFX_ASYNC_THREADS 1
+  #else
+    #define FFX_ASYNC_THREADS 0
+  #endif
+#endif
+
+#if FFX_ASYNC_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#endif
+
+/*!
+ *  FFXAsyncPixelController - Double buffered pixel controller that sends frames in the background, so the next frame can be
+ *  drawn while the last one is still going out to the LEDs (about 30us per pixel for WS2812 - 9ms for 300 pixels).
+ *
+ *  It wraps another pixel controller (the output), which it owns.  The FFXController draws into a back buffer that belongs
+ *  to this controller, show() copies the back buffer into the output's LED array (the front buffer - e.g. the array given
+ *  to FastLED.addLeds()) and returns, and a background thread calls the output's showChanged() with the copy.  If the
+ *  previous frame is still being sent, show() waits for it first.  The output's brightness is set from the thread, just
+ *  before the frame it applies to.
+ *
+ *  FFXController::update() checks isShowComplete() and leaves the show pending (carrying on drawing) until the previous
+ *  frame has gone, so it never waits in show().  If the output puts a frame off (e.g. FFXFastLEDPixelController's maximum
+ *  refresh rate), the thread notes it - timeToShowTicks() then gives the output's deadline, and the changes that didn't go
+ *  out are sent again with the next frame.
+ *
+ *  ```
+ *  CRGB leds[NUM_LEDS];
+ *  FastLED.addLeds<WS2812B, DATA_PIN, GRB>( leds, NUM_LEDS );
+ *  FXController.initialize( new FFXAsyncPixelController( new FFXFastLEDPixelController( leds, NUM_LEDS ) ) );
+ *  ```
+ *
+ *  The thread is only used where FFX_ASYNC_THREADS is set (host builds and ESP32) - otherwise show() sends the frame itself
+ *  and isShowComplete() is always true.
+ */
+class FFXAsyncPixelController : public FFXPixelController {
+  public:
+    FFXAsyncPixelController( FFXPixelController *initOutput );
+    virtual ~FFXAsyncPixelController();
+
+    virtual void show() override { showChanged( 0, getNumLeds()-1 ); }
+    virtual void showChanged( uint16_t firstChanged, uint16_t lastChanged ) override;
+    virtual void updateBrightness( uint8_t newBrightness ) override { }
+#if FFX_ASYNC_THREADS
+    virtual bool isShowComplete() override { return !busy; }
+    virtual void waitForShow() override;
+#endif
+    /*! While a frame is being sent, the time until it should be done (from the output's wire time, at least 1 tick).  Once 
+     *  it has gone, the output's timeToShowTicks() if it put the frame off - otherwise ULONG_MAX. */
+    virtual unsigned long timeToShowTicks() override;
+    virtual unsigned long getWireMicros() override { return output->getWireMicros(); }
+    FFXPixelController *getOutput() { return output; }
+    /*! Frames sent, and the number of those show() had to wait for the previous frame to finish */
+    unsigned long getShowCount() { return showCount; }
+    unsigned long getWaitCount() { return waitCount; }
+
+  private:
+    FFXPixelController *output;
+    unsigned long showCount = 0;
+    unsigned long waitCount = 0;
+    unsigned long sendStart = 0;              // micros() when the frame being sent was handed over
+    void send( uint16_t firstChanged, uint16_t lastChanged, uint8_t brightness );
+#if FFX_ASYNC_THREADS
+    std::thread sender;
+    std::mutex lock;
+    std::condition_variable signal;
+    std::atomic<bool> busy{ false };          // a frame is waiting to be sent or being sent
+    bool stopping = false;
+    uint16_t sendFirst = 0;
+    uint16_t sendLast = 0;
+    uint8_t sendBrightness = 0;
+    bool deferred = false;                    // the output put the last frame off...
+    FFXSpan deferredSpan = FFXSpan();         // ...with these changes in it
+    void run();
+#endif
+};
+
+#endif
@@ -7,20 +7,32 @@
 #include "FFXAutoFader.h"
 
 void FFXAutoFader::updateFader() {
-  // uint8_t oldValue = vValue;
+  uint8_t oldValue = vValue;
+  targetPending = false;
   if (isFading()) {
     if (fadeTimer.isUp()) {
       fadeTimer.stop();
       vValue = targetValue;
     }
     else {
-      vValue = fixed_map( fadeTimer.timeSinceTriggered(), 0, fadeTimer.getInterval(), prevValue, targetValue );
+      vValue = fixed_map_ticks( fadeTimer.timeSinceTriggeredTicks(), 0, fadeTimer.getIntervalTicks(), prevValue, targetValue );
     }
     updated = true;
   }
   else {
     updated = false;
   }
+  valueChanged = (vValue != oldValue);
+}
+
+unsigned long FFXAutoFader::timeToNextChangeTicks() {
+  if (targetPending || valueChanged) { return 0; }
+  if (!isFading()) { return updated ? 0 : ULONG_MAX; }
+  unsigned long remaining = fadeTimer.timeRemainingTicks();
+  if (remaining == 0 || vValue == targetValue) { return remaining; }
+  long next = (targetValue > vValue) ? vValue+1 : vValue-1;
+  unsigned long until = fixed_map_ticks_until( fadeTimer.timeSinceTriggeredTicks(), 0, fadeTimer.getIntervalTicks(), prevValue, targetValue, next );
+  return (until < remaining) ? until : remaining;
 }
 
 void FFXAutoFader::setTarget( uint8_t newTarget ) {
@@ -29,6 +41,7 @@ void FFXAutoFader::setTarget( uint8_t newTarget ) {
         prevValue = vValue;
         targetValue = newTarget;
         updated = true;
+        targetPending = true;
         if (fadeTimer.isStarted()) {
           fadeTimer.step();
         }
@@ -35,13 +35,19 @@ class FFXAutoFader {
     };    
     virtual void onUpdate( CRGBSet &pixels ) = 0;
     void setInterval( uint16_t ms) { fadeTimer.setInterval(ms); }
+    void setIntervalMicros( unsigned long us ) { fadeTimer.setIntervalMicros(us); }
     uint16_t getInterval() { return fadeTimer.getInterval(); }
     void updateFader();
+    /*! Ticks until the next updateFader() that matters - 0 if the value has just changed (whatever is drawn with the value
+     *  before and after a change is drawn once more) or changes now, ULONG_MAX if not fading */
+    unsigned long timeToNextChangeTicks();
   private:
     uint8_t vValue = 0;
     uint8_t targetValue = 0;
     uint8_t prevValue = 0;
     bool updated = true;
+    bool targetPending = false;  // setTarget() called since the last updateFader()
+    bool valueChanged = false;   // the last updateFader() changed the value
     StepTimer fadeTimer = StepTimer( 1000, false );
 };
 
@@ -5,6 +5,8 @@
 //  gmoehrke@gmail.com
 // 
 #include "FFXBase.h"
+#include "FFXBlend.h"
+#include "FFXTrace.h"
 
 
 const uint8_t PROGMEM gamma8[] = {
@@ -40,6 +42,29 @@ void FFXBase::initialize( uint16_t initSize ) {
    setStartExpired(true);  // Start immediately - Timer starts in triggered state, so initLeds, then writeNextFrame is called on first call to update() 
 }
 
+const char *FFXEvent::attributeName( Type type ) {
+  switch (type) {
+    case INTERVAL : { return "Interval"; }
+    case MOVEMENT : { return "Movement"; }
+    case COLOR : { return "Color"; }
+    case CROSSFADE : { return "FrameProvider:Crossfade"; }
+    case PRIMARY_BRIGHTNESS : { return "Brightness"; }
+    case LOG : { return "LOG"; }
+    default : { return ""; }
+  }
+}
+
+void FFXStateObserver::onEvent( const FFXEvent &event ) {
+  String value;
+  switch (event.type) {
+    case FFXEvent::MOVEMENT : { value = FFXBase::movementTypeStr( (FFXBase::MovementType)event.value ); break; }
+    case FFXEvent::COLOR : { value = FFXColor::colorModeName( (FFXColor::FFXColorMode)event.value ); break; }
+    case FFXEvent::LOG : { value = (event.text ? event.text : ""); break; }
+    default : { value = String( (long)event.value ); }
+  }
+  onNotify( event.source ? event.source : "", FFXEvent::attributeName( event.type ), value );
+}
+
 String FFXBase::movementTypeStr( MovementType mvt ) {
   switch(mvt) {
     case MVT_FORWARD : { return "forward"; break; }
@@ -84,24 +109,24 @@ String  FFXBase::fadeMethodStr( FadeType value ) {
     }
    }
 
+uint8_t FFXBase::fadeAlpha( uint8_t alpha, FadeType ft ) {
+  switch (ft) {
+    case GAMMA : { return pgm_read_byte(&gamma8[alpha]); }
+    case CUBIC : { return ease8InOutApprox(alpha); } 
+    default : { return alpha; }
+  }
+}
+
 CRGB FFXBase::alphaBlend( CRGB &a, CRGB &b, uint8_t alpha, FadeType ftUp, FadeType ftDown ) {
       if ( (ftUp != LINEAR) || (ftDown != LINEAR) ) {
         uint8_t aLuma = a.getLuma();
         uint8_t bLuma = b.getLuma();
         if (aLuma > bLuma) 
         { 
-          switch (ftUp) {
-            case GAMMA : { alpha = pgm_read_byte(&gamma8[alpha]); break; }
-            case CUBIC : { alpha = ease8InOutApprox(alpha); break; } 
-            case LINEAR : { break; }
-          }
+          alpha = fadeAlpha( alpha, ftUp );
         } 
         else if (bLuma > aLuma) {
-          switch (ftDown) {
-            case GAMMA : { alpha = pgm_read_byte(&gamma8[alpha]); break; }
-            case CUBIC : { alpha = ease8InOutApprox(alpha); break; } 
-            case LINEAR : { break; }
-          }
+          alpha = fadeAlpha( alpha, ftDown );
         }
       }
       return CRGB( alphaBlend( a.r, b.r, alpha ), 
@@ -109,32 +134,41 @@ CRGB FFXBase::alphaBlend( CRGB &a, CRGB &b, uint8_t alpha, FadeType ftUp, FadeTy
                    alphaBlend( a.b, b.b, alpha ) );
    }   
 
-void FFXBase::rotateBufferForwardWithWrap( CRGB *source, CRGB *dest, uint8_t numLeds, uint8_t steps ) {
-     if ( (steps > 0) && (steps < numLeds)) {
-       bool buffertail = (steps<(numLeds/2));
-       uint8_t buffersize = buffertail ? steps : numLeds-steps;
-       CRGB* tempsrc = new CRGB[buffersize];
-       if (buffertail) {
-          //  Move the tail end of the array into temp buffer
-          memmove8( &tempsrc[0], &source[numLeds-steps], buffersize*sizeof(CRGB) );
-          //  Move the front end of source array into the tail of the dest array
-          memmove8( &dest[steps], &source[0], (numLeds-buffersize)*sizeof(CRGB) );
-          //  Move the temp buffer into the front end of the dest array
-          memmove8( &dest[0], &tempsrc[0], buffersize*sizeof(CRGB) );
-       }
-       else
-       {
-          // Move the front end of the array into temp buffer
-          memmove8( &tempsrc[0], &source[0], buffersize * sizeof(CRGB) );
-          // Move the tail end of the source array into front of the dest array
-          memmove8( &dest[0], &source[numLeds-steps], (numLeds-buffersize) * sizeof(CRGB) );
-          // Move the temp buffer into tail end of the dest array
-          memmove8( &dest[steps], &tempsrc[0], buffersize * sizeof(CRGB) );
-       }
-       delete tempsrc;
-     }
-   }
+void FFXBase::alphaBlend( CRGB *a, CRGB *b, CRGB *dest, uint16_t num, uint8_t alpha, FadeType ftUp, FadeType ftDown ) {
+  FFXBlend::blend( a, b, dest, num, alpha, ftUp, ftDown );
+}
+
+static void reverseBuffer( CRGB *buf, uint16_t first, uint16_t last ) {
+  while (first < last) {
+    CRGB temp = buf[first];
+    buf[first++] = buf[last];
+    buf[last--] = temp;
+  }
+}
 
+void FFXBase::rotateBufferForwardWithWrap( CRGB *source, CRGB *dest, uint16_t numLeds, uint16_t steps ) {
+  if (numLeds == 0) { return; }
+  steps = steps % numLeds;
+  if (source == dest) {
+    if (steps > 0) {
+      // In place rotation by three reversals - no temporary buffer needed
+      reverseBuffer( dest, 0, numLeds-1 );
+      reverseBuffer( dest, 0, steps-1 );
+      reverseBuffer( dest, steps, numLeds-1 );
+    }
+  }
+  else {
+    memmove8( &dest[steps], &source[0], (numLeds-steps)*sizeof(CRGB) );
+    if (steps > 0) { memmove8( &dest[0], &source[numLeds-steps], steps*sizeof(CRGB) ); }
+  }
+}
+
+void FFXBase::copyFromRing( CRGB *dest, const CRGB *ring, uint16_t numLeds, uint16_t offset, uint16_t start, uint16_t count ) {
+  uint16_t phys = (uint16_t)(((uint32_t)start + numLeds - offset) % numLeds);
+  uint16_t first = (count < numLeds-phys) ? count : numLeds-phys;
+  memmove8( dest, &ring[phys], first*sizeof(CRGB) );
+  if (count > first) { memmove8( &dest[first], &ring[0], (count-first)*sizeof(CRGB) ); }
+}
 
 void FFXBase::setColor( CRGB newColor )
 {
@@ -142,12 +176,25 @@ void FFXBase::setColor( CRGB newColor )
    currColor.setCRGB(newColor);
 }
 
+void FFXBase::fadeSpanToBlackBy( CRGB *bufLeds, FFXSpan &lit, uint8_t fadeBy ) {
+  if (!lit.isEmpty()) {
+    fadeToBlackBy( &bufLeds[lit.first], lit.length(), fadeBy );
+    markDirty( lit );
+    while (!lit.isEmpty() && !bufLeds[lit.first]) { lit.first++; }
+    while (!lit.isEmpty() && !bufLeds[lit.last]) { lit.last--; }
+  }
+}
+
 void FFXBase::update(CRGB *frameBuffer ) {
+      frameDataChanged = true;
+      dirty.clear();
+      dirtyReported = false;
       if (!frozen) {
 
         if (!initialized) {
             initLeds(frameBuffer);
             initialized = true;
+            markDirty( 0, numLeds-1 );
          }
         if (currPhase == 1) {
            cycleStart( frameBuffer );
@@ -156,7 +203,10 @@ void FFXBase::update(CRGB *frameBuffer ) {
            vCycleStart( frameBuffer );
         }
         if (currColor.isUpdated()) { changed = true; }
-        writeNextFrame( frameBuffer );
+        {
+          FFX_TRACE_SCOPE( "writeNextFrame" );
+          writeNextFrame( frameBuffer );
+        }
         uint16_t next = getNextPhase();
         if ( next==1 ) {
           cycleEnd( frameBuffer );
@@ -169,11 +219,26 @@ void FFXBase::update(CRGB *frameBuffer ) {
         currVPhase = vNext;
       }
       else { whileFrozen( frameBuffer ); }
+      if (!dirtyReported) { dirty.add( 0, numLeds-1 ); }
       if ( timeSinceStarted() > ((secondsElapsed+1)*1000) ) {
         onEachSecond(++secondsElapsed);
       }
       step();
    }
 
+void FFXBase::catchUp( unsigned long steps ) {
+  if (!frozen && steps > 0) {
+    onCatchUp( steps );
+    unsigned long phase = (unsigned long)currPhase - 1 + steps;
+    currCycle += phase / numLeds;
+    currPhase = (phase % numLeds) + 1;
+    if (vCycleRange) {
+      unsigned long vPhase = (unsigned long)currVPhase - 1 + steps;
+      currVCycle += vPhase / vCycleRange;
+      currVPhase = (vPhase % vCycleRange) + 1;
+    }
+  }
+}
+
 
   
@@ -10,22 +10,42 @@
 #include "FFXColor.h"
 #include "FlexTimer.h"
 
+/*!
+ *   FFXEvent - Notification sent by an FFXStateNotifier.  Plain data, so sending one allocates nothing.  source is the 
+ *   name of the sender (only valid during the call).  value holds the new setting for the attribute named by type: 
+ *   interval (ms), MovementType, FFXColorMode, crossfade on/off or brightness.  text is only used by LOG.
+ */
+struct FFXEvent {
+  enum Type : uint8_t { INTERVAL, MOVEMENT, COLOR, CROSSFADE, PRIMARY_BRIGHTNESS, LOG };
+  Type type;
+  const char *source;
+  int32_t value;
+  const char *text;
+  FFXEvent( Type initType, const char *initSource, int32_t initValue, const char *initText = nullptr ) : 
+    type(initType), source(initSource), value(initValue), text(initText) { }
+  /*! Attribute name used by the String notifications (see FFXStateObserver::onNotify()) */
+  static const char *attributeName( Type type );
+};
+
 /*!
  *   FFXStateObserver - Base class for FFX event observer class.  Descendents of this class may
- *   be registered with any FFXStateNotifier.  Override the pure virtual onNotify() 
- *   method to handle notification events.
+ *   be registered with any FFXStateNotifier.  Override onEvent() to handle notification events.
+ * 
+ *   onNotify() is the older String form of the same notifications - the default onEvent() converts each event to 
+ *   Strings and passes it on to onNotify(), so existing observers keep working (at the cost of the String allocations).
 */
 class FFXStateObserver {
   public:
     FFXStateObserver() {}
     virtual ~FFXStateObserver() { }
-    virtual void onNotify( String source, String attribute, String value ) = 0;
+    virtual void onEvent( const FFXEvent &event );
+    virtual void onNotify( String source, String attribute, String value ) { }
 };
 
 /*!
  *   FFXStateNotifier - Base class for FFX event publisher class.  Maintains a list of 
  *   FFXStageObserver objects to send notifications.  Calls to notify() will be passed
- *   to the onNotify() method of each registered FFXStateObjerver.
+ *   to the onEvent() method (or, for String notifications, the onNotify() method) of each registered FFXStateObjerver.
 */
 class FFXStateNotifier {
   public:
@@ -39,6 +59,9 @@ class FFXStateNotifier {
         observers.push_back( obs );
       }
     }
+    void notify( const FFXEvent &event ) {
+      for (auto o : observers) { o->onEvent( event ); }
+    }
     void notify( String source, String attribute, String value) {
       for (auto o : observers) { o->onNotify( source, attribute, value ); }
     }
@@ -47,6 +70,38 @@ class FFXStateNotifier {
     std::vector<FFXStateObserver*> observers = std::vector<FFXStateObserver*>();
 };
 
+/*!
+ *   FFXSpan - Inclusive range of pixel indexes [first..last], used to track the part of a frame that changed ("dirty") so
+ *   that later stages (frame provider, dimmer, opacity, overlays) only touch those pixels.  Spans are kept as a single 
+ *   range - adding to a span extends it to cover both.  An empty span has first > last.
+ */
+struct FFXSpan {
+  uint16_t first = 0xFFFF;
+  uint16_t last = 0;
+
+  FFXSpan() { }
+  FFXSpan( uint16_t initFirst, uint16_t initLast ) : first(initFirst), last(initLast) { }
+
+  bool isEmpty() const { return first > last; }
+  uint16_t length() const { return isEmpty() ? 0 : last-first+1; }
+  void clear() { first = 0xFFFF; last = 0; }
+  void add( uint16_t pos ) { add( pos, pos ); }
+  void add( uint16_t lo, uint16_t hi ) {
+    if (lo > hi) { return; }
+    if (isEmpty()) { first = lo; last = hi; }
+    else { if (lo < first) { first = lo; } if (hi > last) { last = hi; } }
+  }
+  void add( const FFXSpan &other ) { add( other.first, other.last ); }
+  // Portion of this span inside [lo..hi]
+  FFXSpan clip( uint16_t lo, uint16_t hi ) const {
+    FFXSpan result;
+    if (!isEmpty() && first <= hi && lo <= last) { result.first = (first > lo ? first : lo); result.last = (last < hi ? last : hi); }
+    return result;
+  }
+  // Same span moved by delta (e.g. segment to strip coordinates) - must not be empty
+  FFXSpan shift( int32_t delta ) const { return isEmpty() ? FFXSpan() : FFXSpan( first+delta, last+delta ); }
+};
+
 /*!
  *   FFXBase - Base class for all LED Strip animation effects.
  *
@@ -76,9 +131,18 @@ class FFXStateNotifier {
  *
  *     FFXBase also provides several "utility" methods for performing common operations used in animated effects:
  *     
- *     Rotate pixels within a CRGB Buffer, wrapping around at the ends:
+ *     Rotate pixels within a CRGB Buffer, wrapping around at the ends (in place, no allocation):
  *       rotateBufferForwardwithWrap( ... )
  *       rotateBufferBackwardWithWrap( ... )
+ *
+ *     Frame offset - an effect may treat its frame buffer as a ring and "rotate" it by moving a logical start offset
+ *       (see FFXRotate) instead of moving the pixel data.  Logical pixel i of the frame is then stored at physical index
+ *       (i - offset) mod numLeds.  The frame provider tracks the offset of each of its buffers and resolves it when copying
+ *       or blending frames out to the display buffer (copyFromRing).  Effects that never touch the offset are unaffected.
+ *     
+ *     Dirty span - update() records which pixels (logical indexes) of the frame were changed by that call (getDirtySpan()).  
+ *       Effects that only touch part of the frame call markDirty() from writeNextFrame(), or markClean() when nothing changed.  
+ *       If an effect reports nothing, the whole frame is assumed to have changed, so existing effects need no changes.
  *     
  *     Calculate the "mirror" image position of a given pixel (i.e. same distance from center, on the other side):
  * 
@@ -114,9 +178,9 @@ public:
    String getFXName() { return fxName; }
    uint8_t getFXID() { return fxid; }
 
-   virtual void setInterval( unsigned long newInterval ) override {
-     FlexTimer::setInterval(newInterval);
-     notify( getFXName(), "Interval", String(newInterval));
+   virtual void setIntervalTicks( unsigned long newTicks ) override {
+     FlexTimer::setIntervalTicks(newTicks);
+     notify( FFXEvent( FFXEvent::INTERVAL, fxName.c_str(), getInterval() ) );
    }
 
    virtual void setColor( CRGB newColor );
@@ -129,24 +193,24 @@ public:
 
    void setMovement( MovementType newMovement ) { 
      currMovement = newMovement;
-     notify( getFXName(), "Movement", movementTypeStr(newMovement) ); 
+     notify( FFXEvent( FFXEvent::MOVEMENT, fxName.c_str(), newMovement ) ); 
     }
 
    FFXColor &getFXColor() { return currColor; }
    CRGB getColor() { return currColor.getCRGB(); }
    void setFXColor( FFXColor &newColor) { 
      currColor = newColor;
-     notify( getFXName(), "Color", currColor.getColorModeName()); 
+     notify( FFXEvent( FFXEvent::COLOR, fxName.c_str(), currColor.getColorMode() ) ); 
    }
 
    static uint8_t inline alphaBlend( uint8_t a, uint8_t b, uint8_t alpha ) { return scale8(a, 255-alpha) + scale8(b, alpha); }
+   /*! Blend amount alpha after applying the fade curve ft (gamma8 or ease8InOutApprox) */
+   static uint8_t fadeAlpha( uint8_t alpha, FadeType ft );
+   /*! Blend b over a by alpha.  Unless both fade types are LINEAR, alpha follows the ftUp curve where a is brighter than b 
+       and the ftDown curve where b is brighter */
    static CRGB alphaBlend( CRGB &a, CRGB &b, uint8_t alpha, FadeType ftUp = LINEAR, FadeType ftDown = LINEAR );
-      
-   static void alphaBlend( CRGB *a, CRGB *b, CRGB *dest, uint16_t num, uint8_t alpha, FadeType ftUp = LINEAR, FadeType ftDown = LINEAR ) {
-    for (uint16_t i=0; i<num; i++ ) {
-      dest[i] = alphaBlend( a[i], b[i], alpha ); 
-    }
-   }
+   /*! Same as above for num pixels - uses the fastest kernel available (see FFXBlend) */
+   static void alphaBlend( CRGB *a, CRGB *b, CRGB *dest, uint16_t num, uint8_t alpha, FadeType ftUp = LINEAR, FadeType ftDown = LINEAR );
    
    static uint16_t mirror( uint16_t index, uint16_t range ) {
      return (index > range) ? 0 : range-1-index;
@@ -155,10 +219,12 @@ public:
      return mirror( index, numLeds );
    }
 
-   static void rotateBufferForwardWithWrap( CRGB *source, CRGB *dest, uint8_t numLeds, uint8_t steps );
+   static void rotateBufferForwardWithWrap( CRGB *source, CRGB *dest, uint16_t numLeds, uint16_t steps );
    static void rotateBufferBackwardWithWrap( CRGB *source, CRGB *dest, uint16_t numLeds, uint16_t steps ) {
-     rotateBufferForwardWithWrap( source, dest, numLeds, numLeds-steps );
+     if (numLeds > 0) { rotateBufferForwardWithWrap( source, dest, numLeds, numLeds-(steps % numLeds) ); }
    }
+   // Copy count logical pixels, starting at logical index start, out of a ring buffer stored with the given offset
+   static void copyFromRing( CRGB *dest, const CRGB *ring, uint16_t numLeds, uint16_t offset, uint16_t start, uint16_t count );
 
    void rotateForward( CRGB *bufLeds, uint16_t steps ) {
      rotateBufferForwardWithWrap( bufLeds, bufLeds, numLeds, steps );
@@ -201,6 +267,8 @@ public:
    uint16_t getMovementVPhase();
 
    uint16_t getNumLeds() { return numLeds; }
+   uint16_t getFrameOffset() { return frameOffset; }
+   void setFrameOffset( uint16_t newOffset ) { frameOffset = (numLeds ? newOffset % numLeds : 0); }
    uint16_t getVCycleRange() { return vCycleRange; }
    uint16_t setVCycleRange( uint16_t newRange ) { 
      return vCycleRange = newRange; 
@@ -218,6 +286,9 @@ public:
    virtual void onVCycleStart( CRGB *currFrame ) { }
    virtual void onVCycleEnd( CRGB *currFrame ) { }
    virtual void onBrightness( uint8_t newBrightness ) { }
+   // onCatchUp is called by catchUp() before the phase moves on - effects that keep state of their own from frame to frame (a hue, an 
+   // offset, ...) can override it to move that state on by the steps that were skipped as well
+   virtual void onCatchUp( unsigned long steps ) { }
    
    // initLeds is called once before the first call to writeNextFrame.  This can be overridden to do any additional initialization, clear the background, set colors, etc.
    // Note that LEDs are not updated/shown between the call to initLeds and the first call to writeNextFrame - this is simply a hook that gets called once to setup anything
@@ -239,10 +310,21 @@ public:
    bool isFrozen() { return frozen; }
 
    void update(CRGB *frameBuffer );
+   // Move the phase, vPhase and cycle counts on as if update() had been called steps more times, without drawing anything - used 
+   // when a segment that was skipped (not visible) starts drawing again.  The cycle hooks are not called for skipped steps.
+   void catchUp( unsigned long steps );
 
    boolean isUpdated() { if (currColor.isUpdated()) { changed=true; } return changed;  }
    void setUpdated(boolean newValue) { changed = newValue; }
 
+   // Effects that overwrite every pixel in writeNextFrame() (never read the previous frame) set fullFrameRedraw, so the frame
+   // provider does not need to carry the previous frame into the buffer being drawn.
+   bool isFullFrameRedraw() { return fullFrameRedraw; }
+   // false if the last call to update() left the pixel data unchanged (e.g. only the frame offset moved)
+   bool isFrameDataChanged() { return frameDataChanged; }
+   // logical pixels changed by the last call to update() - see "Dirty span" above
+   const FFXSpan &getDirtySpan() { return dirty; }
+
   
   protected:
     uint8_t fxid = 0;
@@ -252,6 +334,18 @@ public:
     MovementType currMovement = MVT_FORWARD;
     uint16_t currPhase = 1;
     uint16_t currVPhase = 1;
+    uint16_t frameOffset = 0;               // logical rotation of the frame buffer - see "Frame offset" above
+    bool fullFrameRedraw = false;
+    bool frameDataChanged = true;
+    FFXSpan dirty = FFXSpan();
+    bool dirtyReported = false;
+    void markDirty( uint16_t pos ) { dirty.add( pos ); dirtyReported = true; }
+    void markDirty( uint16_t first, uint16_t last ) { dirty.add( first, last ); dirtyReported = true; }
+    void markDirty( const FFXSpan &span ) { dirty.add( span ); dirtyReported = true; }
+    void markClean() { dirtyReported = true; }
+    // Fade the pixels in lit toward black (for trails) and mark them dirty.  lit must cover every non-black pixel of the 
+    // frame - it is shrunk past any pixels that reached black.
+    void fadeSpanToBlackBy( CRGB *bufLeds, FFXSpan &lit, uint8_t fadeBy );
     unsigned long currCycle = 1;
     unsigned long currVCycle = 1;
     uint16_t vCycleRange;
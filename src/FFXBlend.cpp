@@ -0,0 +1,241 @@
+//
+//  FFXBlend.cpp
+//
+//  Copyright 2020 - Geoff Moehrke 
+//  gmoehrke@gmail.com
+// 
+#include "FFXBlend.h"
+
+#if defined(FFX_HOST_BUILD) && !defined(FFX_BLEND_SCALAR_ONLY) && defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+  #define FFX_BLEND_X86 1
+  #include <immintrin.h>
+#elif defined(FFX_HOST_BUILD) && !defined(FFX_BLEND_SCALAR_ONLY) && defined(__ARM_NEON)
+  #define FFX_BLEND_NEON 1
+  #include <arm_neon.h>
+#endif
+
+// All kernels work on the bytes of the CRGB arrays: dest = scale8(a, 255-alpha) + scale8(b, alpha) for each byte, which
+// (with scale8(i, s) = (i * (1+s)) >> 8) is ((a * (256-alpha)) >> 8) + ((b * (1+alpha)) >> 8) - both products fit in 16 bits.
+// "Uniform" kernels use one alpha for every byte, "varying" kernels take an alpha for each byte.
+typedef void (*FFXUniformKernel)( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, uint8_t alpha );
+typedef void (*FFXVaryingKernel)( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, const uint8_t *alpha );
+
+static void blendUniformScalar( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, uint8_t alpha ) {
+  for (uint32_t i = 0; i < count; i++) { dest[i] = FFXBase::alphaBlend( a[i], b[i], alpha ); }
+}
+
+static void blendVaryingScalar( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, const uint8_t *alpha ) {
+  for (uint32_t i = 0; i < count; i++) { dest[i] = FFXBase::alphaBlend( a[i], b[i], alpha[i] ); }
+}
+
+#ifdef FFX_BLEND_X86
+
+static inline __m128i blendHalfSSE2( __m128i a, __m128i b, __m128i wa, __m128i wb ) {
+  return _mm_add_epi16( _mm_srli_epi16( _mm_mullo_epi16( a, wa ), 8 ), _mm_srli_epi16( _mm_mullo_epi16( b, wb ), 8 ) );
+}
+
+static void blendUniformSSE2( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, uint8_t alpha ) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i wa = _mm_set1_epi16( 256-alpha );
+  const __m128i wb = _mm_set1_epi16( 1+alpha );
+  uint32_t i = 0;
+  for (; i+16 <= count; i += 16) {
+    __m128i va = _mm_loadu_si128( (const __m128i *)&a[i] );
+    __m128i vb = _mm_loadu_si128( (const __m128i *)&b[i] );
+    __m128i lo = blendHalfSSE2( _mm_unpacklo_epi8( va, zero ), _mm_unpacklo_epi8( vb, zero ), wa, wb );
+    __m128i hi = blendHalfSSE2( _mm_unpackhi_epi8( va, zero ), _mm_unpackhi_epi8( vb, zero ), wa, wb );
+    _mm_storeu_si128( (__m128i *)&dest[i], _mm_packus_epi16( lo, hi ) );
+  }
+  blendUniformScalar( &a[i], &b[i], &dest[i], count-i, alpha );
+}
+
+static void blendVaryingSSE2( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, const uint8_t *alpha ) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i w256 = _mm_set1_epi16( 256 );
+  const __m128i w1 = _mm_set1_epi16( 1 );
+  uint32_t i = 0;
+  for (; i+16 <= count; i += 16) {
+    __m128i va = _mm_loadu_si128( (const __m128i *)&a[i] );
+    __m128i vb = _mm_loadu_si128( (const __m128i *)&b[i] );
+    __m128i vw = _mm_loadu_si128( (const __m128i *)&alpha[i] );
+    __m128i wlo = _mm_unpacklo_epi8( vw, zero );
+    __m128i whi = _mm_unpackhi_epi8( vw, zero );
+    __m128i lo = blendHalfSSE2( _mm_unpacklo_epi8( va, zero ), _mm_unpacklo_epi8( vb, zero ), _mm_sub_epi16( w256, wlo ), _mm_add_epi16( wlo, w1 ) );
+    __m128i hi = blendHalfSSE2( _mm_unpackhi_epi8( va, zero ), _mm_unpackhi_epi8( vb, zero ), _mm_sub_epi16( w256, whi ), _mm_add_epi16( whi, w1 ) );
+    _mm_storeu_si128( (__m128i *)&dest[i], _mm_packus_epi16( lo, hi ) );
+  }
+  blendVaryingScalar( &a[i], &b[i], &dest[i], count-i, &alpha[i] );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i blendHalfAVX2( __m256i a, __m256i b, __m256i wa, __m256i wb ) {
+  return _mm256_add_epi16( _mm256_srli_epi16( _mm256_mullo_epi16( a, wa ), 8 ), _mm256_srli_epi16( _mm256_mullo_epi16( b, wb ), 8 ) );
+}
+
+// 32 bytes at a time, widened to 16 bits in two halves of 16 bytes.  packus works within 128 bit lanes, so the 64 bit 
+// quarters come out as lo[0-7] hi[0-7] lo[8-15] hi[8-15] and are put back in order with permute4x64.
+__attribute__((target("avx2")))
+static void blendUniformAVX2( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, uint8_t alpha ) {
+  const __m256i wa = _mm256_set1_epi16( 256-alpha );
+  const __m256i wb = _mm256_set1_epi16( 1+alpha );
+  uint32_t i = 0;
+  for (; i+32 <= count; i += 32) {
+    __m256i lo = blendHalfAVX2( _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&a[i] ) ), 
+                                _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&b[i] ) ), wa, wb );
+    __m256i hi = blendHalfAVX2( _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&a[i+16] ) ), 
+                                _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&b[i+16] ) ), wa, wb );
+    _mm256_storeu_si256( (__m256i *)&dest[i], _mm256_permute4x64_epi64( _mm256_packus_epi16( lo, hi ), 0xD8 ) );
+  }
+  _mm256_zeroupper();     // avoid the AVX/SSE transition penalty in the SSE2 kernel
+  blendUniformSSE2( &a[i], &b[i], &dest[i], count-i, alpha );
+}
+
+__attribute__((target("avx2")))
+static void blendVaryingAVX2( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, const uint8_t *alpha ) {
+  const __m256i w256 = _mm256_set1_epi16( 256 );
+  const __m256i w1 = _mm256_set1_epi16( 1 );
+  uint32_t i = 0;
+  for (; i+32 <= count; i += 32) {
+    __m256i wlo = _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&alpha[i] ) );
+    __m256i whi = _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&alpha[i+16] ) );
+    __m256i lo = blendHalfAVX2( _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&a[i] ) ), 
+                                _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&b[i] ) ), 
+                                _mm256_sub_epi16( w256, wlo ), _mm256_add_epi16( wlo, w1 ) );
+    __m256i hi = blendHalfAVX2( _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&a[i+16] ) ), 
+                                _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)&b[i+16] ) ), 
+                                _mm256_sub_epi16( w256, whi ), _mm256_add_epi16( whi, w1 ) );
+    _mm256_storeu_si256( (__m256i *)&dest[i], _mm256_permute4x64_epi64( _mm256_packus_epi16( lo, hi ), 0xD8 ) );
+  }
+  _mm256_zeroupper();
+  blendVaryingSSE2( &a[i], &b[i], &dest[i], count-i, &alpha[i] );
+}
+
+#endif
+
+#ifdef FFX_BLEND_NEON
+
+static inline uint8x8_t blendHalfNEON( uint8x8_t a, uint8x8_t b, uint16x8_t wa, uint16x8_t wb ) {
+  uint16x8_t r = vaddq_u16( vshrq_n_u16( vmulq_u16( vmovl_u8( a ), wa ), 8 ), vshrq_n_u16( vmulq_u16( vmovl_u8( b ), wb ), 8 ) );
+  return vmovn_u16( r );
+}
+
+static void blendUniformNEON( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, uint8_t alpha ) {
+  const uint16x8_t wa = vdupq_n_u16( 256-alpha );
+  const uint16x8_t wb = vdupq_n_u16( 1+alpha );
+  uint32_t i = 0;
+  for (; i+16 <= count; i += 16) {
+    uint8x16_t va = vld1q_u8( &a[i] );
+    uint8x16_t vb = vld1q_u8( &b[i] );
+    uint8x8_t lo = blendHalfNEON( vget_low_u8( va ), vget_low_u8( vb ), wa, wb );
+    uint8x8_t hi = blendHalfNEON( vget_high_u8( va ), vget_high_u8( vb ), wa, wb );
+    vst1q_u8( &dest[i], vcombine_u8( lo, hi ) );
+  }
+  blendUniformScalar( &a[i], &b[i], &dest[i], count-i, alpha );
+}
+
+static void blendVaryingNEON( const uint8_t *a, const uint8_t *b, uint8_t *dest, uint32_t count, const uint8_t *alpha ) {
+  const uint16x8_t w256 = vdupq_n_u16( 256 );
+  const uint16x8_t w1 = vdupq_n_u16( 1 );
+  uint32_t i = 0;
+  for (; i+16 <= count; i += 16) {
+    uint8x16_t va = vld1q_u8( &a[i] );
+    uint8x16_t vb = vld1q_u8( &b[i] );
+    uint8x16_t vw = vld1q_u8( &alpha[i] );
+    uint16x8_t wlo = vmovl_u8( vget_low_u8( vw ) );
+    uint16x8_t whi = vmovl_u8( vget_high_u8( vw ) );
+    uint8x8_t lo = blendHalfNEON( vget_low_u8( va ), vget_low_u8( vb ), vsubq_u16( w256, wlo ), vaddq_u16( wlo, w1 ) );
+    uint8x8_t hi = blendHalfNEON( vget_high_u8( va ), vget_high_u8( vb ), vsubq_u16( w256, whi ), vaddq_u16( whi, w1 ) );
+    vst1q_u8( &dest[i], vcombine_u8( lo, hi ) );
+  }
+  blendVaryingScalar( &a[i], &b[i], &dest[i], count-i, &alpha[i] );
+}
+
+#endif
+
+static FFXBlend::Kernel detectKernel() {
+#if defined(FFX_BLEND_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) { return FFXBlend::AVX2; }
+  return FFXBlend::SSE2;
+#elif defined(FFX_BLEND_NEON)
+  return FFXBlend::NEON;
+#else
+  return FFXBlend::SCALAR;
+#endif
+}
+
+static bool kernelSelected = false;
+static FFXBlend::Kernel currKernel = FFXBlend::SCALAR;
+static FFXUniformKernel uniformKernel = blendUniformScalar;
+static FFXVaryingKernel varyingKernel = blendVaryingScalar;
+
+bool FFXBlend::isSupported( Kernel kernel ) {
+  switch (kernel) {
+    case SCALAR : { return true; }
+#if defined(FFX_BLEND_X86)
+    case SSE2 : { return true; }
+    case AVX2 : { return detectKernel()==AVX2; }
+#elif defined(FFX_BLEND_NEON)
+    case NEON : { return true; }
+#endif
+    default : { return false; }
+  }
+}
+
+bool FFXBlend::setKernel( Kernel kernel ) {
+  if (!isSupported(kernel)) { return false; }
+  switch (kernel) {
+#if defined(FFX_BLEND_X86)
+    case SSE2 : { uniformKernel = blendUniformSSE2; varyingKernel = blendVaryingSSE2; break; }
+    case AVX2 : { uniformKernel = blendUniformAVX2; varyingKernel = blendVaryingAVX2; break; }
+#elif defined(FFX_BLEND_NEON)
+    case NEON : { uniformKernel = blendUniformNEON; varyingKernel = blendVaryingNEON; break; }
+#endif
+    default : { uniformKernel = blendUniformScalar; varyingKernel = blendVaryingScalar; }
+  }
+  currKernel = kernel;
+  kernelSelected = true;
+  return true;
+}
+
+FFXBlend::Kernel FFXBlend::getKernel() {
+  if (!kernelSelected) { setKernel( detectKernel() ); }
+  return currKernel;
+}
+
+const char *FFXBlend::kernelName( Kernel kernel ) {
+  switch (kernel) {
+    case SSE2 : { return "sse2"; }
+    case AVX2 : { return "avx2"; }
+    case NEON : { return "neon"; }
+    default : { return "scalar"; }
+  }
+}
+
+#define FFX_BLEND_BLOCK 64    // pixels per block when the blend amount varies by pixel
+
+void FFXBlend::blend( const CRGB *a, const CRGB *b, CRGB *dest, uint16_t num, uint8_t alpha, FFXBase::FadeType ftUp, FFXBase::FadeType ftDown ) {
+  if (!kernelSelected) { getKernel(); }
+  uint8_t upAlpha = (ftUp != FFXBase::FadeType::LINEAR || ftDown != FFXBase::FadeType::LINEAR) ? FFXBase::fadeAlpha( alpha, ftUp ) : alpha;
+  uint8_t downAlpha = (ftUp != FFXBase::FadeType::LINEAR || ftDown != FFXBase::FadeType::LINEAR) ? FFXBase::fadeAlpha( alpha, ftDown ) : alpha;
+  if (upAlpha == alpha && downAlpha == alpha) {
+    uniformKernel( (const uint8_t *)a, (const uint8_t *)b, (uint8_t *)dest, (uint32_t)num*sizeof(CRGB), alpha );
+  }
+  else {
+    // The curve used depends on which pixel is brighter (see FFXBase::alphaBlend()) - work out the amount for each byte 
+    // of a block, then blend the block
+    uint8_t amounts[FFX_BLEND_BLOCK*sizeof(CRGB)];
+    for (uint16_t done = 0; done < num; done += FFX_BLEND_BLOCK) {
+      uint16_t count = (num-done < FFX_BLEND_BLOCK) ? num-done : FFX_BLEND_BLOCK;
+      for (uint16_t i = 0; i < count; i++) {
+        uint8_t aLuma = a[done+i].getLuma();
+        uint8_t bLuma = b[done+i].getLuma();
+        uint8_t amount = (aLuma > bLuma) ? upAlpha : ((bLuma > aLuma) ? downAlpha : alpha);
+        amounts[i*3] = amount;
+        amounts[i*3+1] = amount;
+        amounts[i*3+2] = amount;
+      }
+      varyingKernel( (const uint8_t *)&a[done], (const uint8_t *)&b[done], (uint8_t *)&dest[done], (uint32_t)count*sizeof(CRGB), amounts );
+    }
+  }
+}
@@ -0,0 +1,38 @@
+//
+//  FFXBlend.h
+//
+//  Copyright 2020 - Geoff Moehrke 
+//  gmoehrke@gmail.com
+// 
+#ifndef FFX_BLEND_H
+#define FFX_BLEND_H
+
+#include "FFXBase.h"
+
+/*!
+ *  FFXBlend - Kernels for blending arrays of CRGB (crossfading frames).  The result of blend() is always identical to calling 
+ *  FFXBase::alphaBlend( CRGB&, CRGB&, alpha, ftUp, ftDown ) for each pixel - only the speed differs.
+ *
+ *  Host builds pick the fastest kernel the CPU supports the first time blend() is called - AVX2 or SSE2 on x86, NEON on ARM.
+ *  Arduino builds always use the portable (SCALAR) kernel.  Define FFX_BLEND_SCALAR_ONLY to leave the SIMD kernels out.
+ *
+ *  Blends with LINEAR fade types (the default) use one blend amount for the whole array.  With GAMMA or CUBIC fade types the 
+ *  amount depends on which of each pair of pixels is brighter, so the amounts are worked out for a block of pixels at a 
+ *  time and then blended with the same kernel.
+ */
+class FFXBlend {
+  public:
+    enum Kernel { SCALAR=0, SSE2=1, AVX2=2, NEON=3 };
+
+    static void blend( const CRGB *a, const CRGB *b, CRGB *dest, uint16_t num, uint8_t alpha, 
+                       FFXBase::FadeType ftUp = FFXBase::FadeType::LINEAR, FFXBase::FadeType ftDown = FFXBase::FadeType::LINEAR );
+
+    /*! Kernel currently used by blend() */
+    static Kernel getKernel();
+    static bool isSupported( Kernel kernel );
+    /*! Use a specific kernel (benchmarks, testing) - returns false (and changes nothing) if it is not supported */
+    static bool setKernel( Kernel kernel );
+    static const char *kernelName( Kernel kernel );
+};
+
+#endif
@@ -0,0 +1,73 @@
+//
+//  FFXBufferPool.cpp
+//
+//  Copyright 2020 - Geoff Moehrke 
+//  gmoehrke@gmail.com
+// 
+#include "FFXBufferPool.h"
+#include "FFXTrace.h"
+
+bool FFXBufferPool::reserve( size_t arenaBytes ) {
+  if (arenaBlocksInUse > 0) { return false; }
+  if (arena) { free( arena ); }
+  arena = (arenaBytes > 0) ? (uint8_t *)malloc( arenaBytes ) : nullptr;
+  arenaSize = arena ? arenaBytes : 0;
+  arenaUsed = 0;
+  freeList = nullptr;
+  return (arena != nullptr) || (arenaBytes == 0);
+}
+
+CRGB *FFXBufferPool::allocate( uint16_t numPixels ) {
+  FFX_TRACE_SCOPE( "FFXBufferPool::allocate" );
+  Block *block = nullptr;
+  // best fit from the free list
+  Block **best = nullptr;
+  for (Block **link = &freeList; *link; link = &((*link)->next)) {
+    if ((*link)->numPixels >= numPixels && (!best || (*link)->numPixels < (*best)->numPixels)) {
+      best = link;
+      if ((*link)->numPixels == numPixels) { break; }
+    }
+  }
+  if (best) {
+    block = *best;
+    *best = block->next;
+  }
+  else if (arena && arenaSize-arenaUsed >= blockSize( numPixels )) {
+    block = (Block *)&(arena[arenaUsed]);
+    arenaUsed += blockSize( numPixels );
+    block->numPixels = numPixels;
+    block->inArena = true;
+  }
+  if (block) {
+    arenaBlocksInUse++;
+  }
+  else {
+    block = (Block *)malloc( sizeof(Block) + numPixels*sizeof(CRGB) );
+    if (!block) { return nullptr; }
+    block->numPixels = numPixels;
+    block->inArena = false;
+    heapAllocs++;
+    heapBytes += block->numPixels*sizeof(CRGB);
+    if (heapBytes > heapHighWater) { heapHighWater = heapBytes; }
+  }
+  block->next = nullptr;
+  bytesInUse += block->numPixels*sizeof(CRGB);
+  if (bytesInUse > highWater) { highWater = bytesInUse; }
+  return (CRGB *)(block+1);
+}
+
+void FFXBufferPool::release( CRGB *buffer ) {
+  if (buffer) {
+    Block *block = ((Block *)buffer)-1;
+    bytesInUse -= block->numPixels*sizeof(CRGB);
+    if (block->inArena) {
+      block->next = freeList;
+      freeList = block;
+      arenaBlocksInUse--;
+    }
+    else {
+      heapBytes -= block->numPixels*sizeof(CRGB);
+      free( block );
+    }
+  }
+}
@@ -0,0 +1,79 @@
+//
+//  FFXBufferPool.h
+//
+//  Copyright 2020 - Geoff Moehrke 
+//  gmoehrke@gmail.com
+// 
+#ifndef FFX_BUFFER_POOL_H
+#define FFX_BUFFER_POOL_H
+
+#include "FFXBase.h"
+
+// Number of full-length frames the controller reserves in its buffer pool by default - enough for the primary segment's 
+// crossfade buffers, a full-length overlay and the primary frame cache (see FFXController::getPrimaryFrame()).  Define 
+// before including FastFX to change it.
+#ifndef FFX_BUFFER_POOL_FRAMES
+  #define FFX_BUFFER_POOL_FRAMES 6
+#endif
+
+/*!
+ *  FFXBufferPool - Fixed arena that pixel buffers (frame provider buffers, overlay frames, opacity backgrounds) are carved
+ *  out of, so that toggling crossfade, starting overlays, changing opacity, etc. don't keep allocating and freeing heap 
+ *  memory.  On a long running controller (ESP8266 in particular) that churn fragments the heap.
+ *
+ *  The arena is allocated once (see FFXController::initialize()).  Released buffers go on a free list and are handed out 
+ *  again for any request that fits - blocks are never split or merged, so the arena itself can't fragment.  Since the same
+ *  segment sizes get requested over and over, blocks are nearly always reused as-is.  When the arena is full, buffers come 
+ *  from the heap instead (and go back to it when released).
+ *
+ *  Statistics:
+ *
+ *    getBytesInUse() / getHighWater()         - bytes handed out (arena + heap), now and at most
+ *    getHeapBytes() / getHeapHighWater()      - bytes that had to come from the heap because the arena was full.  A high 
+ *                                               water mark that stops growing shows the pool is big enough and heap use is flat.
+ *    getHeapAllocs()                          - number of allocations that went to the heap
+ */
+class FFXBufferPool {
+  public:
+    FFXBufferPool() { }
+    ~FFXBufferPool() { if (arena) { free( arena ); } }
+
+    /*! Allocate an arena of arenaBytes (0 = heap only).  Only possible when no arena buffers are in use - returns false otherwise. */
+    bool reserve( size_t arenaBytes );
+    /*! Arena bytes needed to hold the given number of buffers of numPixels each */
+    static size_t bytesFor( uint16_t numPixels, uint16_t buffers ) { return buffers * blockSize( numPixels ); }
+
+    CRGB *allocate( uint16_t numPixels );
+    void release( CRGB *buffer );
+
+    size_t getArenaSize() { return arenaSize; }
+    size_t getArenaUsed() { return arenaUsed; }
+    size_t getBytesInUse() { return bytesInUse; }
+    size_t getHighWater() { return highWater; }
+    size_t getHeapBytes() { return heapBytes; }
+    size_t getHeapHighWater() { return heapHighWater; }
+    unsigned long getHeapAllocs() { return heapAllocs; }
+
+  private:
+    struct Block {
+      Block *next;
+      uint16_t numPixels;           // capacity
+      bool inArena;
+    };
+    static size_t blockSize( uint16_t numPixels ) {
+      size_t size = sizeof(Block) + numPixels*sizeof(CRGB);
+      return (size + alignof(Block) - 1) / alignof(Block) * alignof(Block);
+    }
+    uint8_t *arena = nullptr;
+    size_t arenaSize = 0;
+    size_t arenaUsed = 0;           // arena carved into blocks so far
+    Block *freeList = nullptr;      // released arena blocks
+    unsigned int arenaBlocksInUse = 0;
+    size_t bytesInUse = 0;
+    size_t highWater = 0;
+    size_t heapBytes = 0;
+    size_t heapHighWater = 0;
+    unsigned long heapAllocs = 0;
+};
+
+#endif
@@ -53,6 +53,10 @@ class FFXColor {
 
     FFXColorMode getColorMode() { return currColorMode; }
     String getColorModeName() { return String(mode_name[currColorMode]); }
+    static const char *colorModeName( FFXColorMode mode ) {
+      static const char *names[4] = { "singleCRGB", "singleCHSV", "palette16", "palette256" };
+      return (mode <= palette256) ? names[mode] : "";
+    }
     void setColorMode(FFXColorMode const newMode);
 
     uint8_t getPaletteRange() { return pRange; }
@@ -0,0 +1,89 @@
+//
+//  FFXCompositor.cpp
+//
+//  Copyright 2020 - Geoff Moehrke 
+//  gmoehrke@gmail.com
+// 
+#include "FFXCompositor.h"
+#include "FFXBlend.h"
+
+// Physical index of logical pixel i of a ring buffer - see FFXBase "Frame offset"
+static inline uint16_t ringIndex( uint16_t i, uint16_t size, uint16_t offset ) { 
+  return (uint16_t)(((uint32_t)i + size - offset) % size);
+}
+
+void FFXCompositor::setBackground( const CRGB *bkPixels, uint8_t opacity, uint8_t opacityAfter ) {
+  background = bkPixels;
+  bkAmount = 255-opacity;
+  bkAmountAfter = (opacityAfter < 255) ? 255-opacityAfter : 0;
+}
+
+void FFXCompositor::setOverlay( FFXOverlay *ovl, CRGB *initOvlFrame, const FFXSpan &initOvlSpan ) {
+  overlay = ovl;
+  ovlFrame = initOvlFrame;
+  ovlSpan = initOvlSpan;
+}
+
+#define FFX_COMPOSITE_BLOCK 32    // pixels crossfaded at a time (by FFXBlend) before the remaining stages are applied
+
+template<bool CROSSFADE, bool DIM, bool BACKGROUND>
+void FFXCompositor::drawRun( CRGB *dest, CRGB *a, CRGB *b, uint16_t first, uint16_t count ) {
+  CRGB frameBlock[CROSSFADE ? FFX_COMPOSITE_BLOCK : 1];
+  for (uint16_t done = 0; done < count; done += FFX_COMPOSITE_BLOCK) {
+    uint16_t len = minimum<uint16_t>( count-done, FFX_COMPOSITE_BLOCK );
+    const CRGB *pixels = &(a[done]);
+    if (CROSSFADE) {
+      FFXBlend::blend( &(a[done]), &(b[done]), frameBlock, len, frame.amount, frame.fadeUp, frame.fadeDown );
+      pixels = frameBlock;
+    }
+    for (uint16_t n = 0; n < len; n++) {
+      uint16_t i = first+done+n;
+      CRGB pixel = pixels[n];
+      if (DIM) { pixel.nscale8( brightness ); }
+      if (BACKGROUND) {
+        nblend( pixel, background[i], bkAmount );
+        nblend( pixel, background[i], bkAmountAfter );
+      }
+      if (i >= ovlSpan.first && i <= ovlSpan.last) { overlay->applyPixel( ovlFrame[i], pixel, i ); }
+      dest[done+n] = pixel;
+    }
+  }
+}
+
+void FFXCompositor::draw( CRGB *dest, const FFXSpan &span ) {
+  if (span.isEmpty() || !frame.a) { return; }
+  if (!overlay) { ovlSpan.clear(); }
+  bool crossFade = (frame.b != nullptr);
+  bool dim = (brightness < 255);
+  uint16_t i = span.first;
+  // Work in runs where none of the ring buffers wrap around
+  while (i <= span.last) {
+    uint16_t run = span.last-i+1;
+    uint16_t pa = ringIndex( i, frameSize, frame.aOffset );
+    run = minimum<uint16_t>( run, frameSize-pa );
+    CRGB *b = nullptr;
+    if (crossFade) {
+      uint16_t pb = ringIndex( i, frameSize, frame.bOffset );
+      run = minimum<uint16_t>( run, frameSize-pb );
+      b = &(frame.b[pb]);
+    }
+    CRGB *a = &(frame.a[pa]);
+    CRGB *out = &(dest[i]);
+    // one specialized loop for each combination of stages, so the per-pixel work carries no tests for unused ones
+    if (background) {
+      if (crossFade) { if (dim) { drawRun<true,true,true>( out, a, b, i, run ); } else { drawRun<true,false,true>( out, a, b, i, run ); } }
+      else           { if (dim) { drawRun<false,true,true>( out, a, b, i, run ); } else { drawRun<false,false,true>( out, a, b, i, run ); } }
+    }
+    else {
+      if (crossFade) { 
+        if (dim) { drawRun<true,true,false>( out, a, b, i, run ); } 
+        else if (!overlay) { FFXBlend::blend( a, b, out, run, frame.amount, frame.fadeUp, frame.fadeDown ); }
+        else { drawRun<true,false,false>( out, a, b, i, run ); } 
+      }
+      else if (dim)  { drawRun<false,true,false>( out, a, b, i, run ); } 
+      else if (!overlay) { memmove8( out, a, run*sizeof(CRGB) ); }
+      else           { drawRun<false,false,false>( out, a, b, i, run ); } 
+    }
+    i += run;
+  }
+}
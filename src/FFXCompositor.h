@@ -0,0 +1,53 @@
+//
+//  FFXCompositor.h
+//
+//  Copyright 2020 - Geoff Moehrke 
+//  gmoehrke@gmail.com
+// 
+#ifndef FFX_COMPOSITOR_H
+#define FFX_COMPOSITOR_H
+
+#include "FFXBase.h"
+#include "FFXFrameProvider.h"
+#include "FFXOverlay.h"
+
+/*!
+ *  FFXCompositor - Draws a segment's output pixels in a single pass.  Each pixel is read from the segment's frame (crossfaded
+ *  if need be), dimmed, blended with the primary segment's frame for opacity and overlaid, then written to the display buffer 
+ *  once - instead of each of those stages making its own pass over the segment.  The values that are the same for every
+ *  pixel (blend amounts, brightness, opacity) are set up once per frame before calling draw().
+ *
+ *  The result is the same, bit for bit, as running the stages one after the other:
+ *
+ *    frame  - copy of the current/next frame or FFXBase::alphaBlend() of both (crossfaded a block at a time by FFXBlend)
+ *    dimmer - nscale8 by the segment brightness (when < 255)
+ *    opacity - nblend with the primary frame (dimmed by the primary brightness - see FFXController::getPrimaryFrame()), once 
+ *              with the opacity at the start of the update and again with the value after the opacity fader was updated
+ *    overlay - FFXOverlay::applyPixel() (only for overlays where isPerPixel() - others apply themselves afterward)
+ */
+class FFXCompositor {
+  public:
+    FFXCompositor( const FFXFrameSource &initFrame, uint16_t initFrameSize, uint8_t initBrightness ) : 
+      frame(initFrame), frameSize(initFrameSize), brightness(initBrightness) { }
+    /*! Blend with bkPixels (indexed like the segment).  The opacity values are the segment's opacity before and after its 
+     *  fader was updated this frame. */
+    void setBackground( const CRGB *bkPixels, uint8_t opacity, uint8_t opacityAfter );
+    /*! Apply ovl, whose current frame is in ovlFrame, to the pixels in ovlSpan */
+    void setOverlay( FFXOverlay *ovl, CRGB *ovlFrame, const FFXSpan &ovlSpan );
+    /*! Draw the pixels in span (segment indexes) to dest (the first pixel of the segment in the display buffer) */
+    void draw( CRGB *dest, const FFXSpan &span );
+  private:
+    template<bool CROSSFADE, bool DIM, bool BACKGROUND>
+    void drawRun( CRGB *dest, CRGB *a, CRGB *b, uint16_t first, uint16_t count );
+    FFXFrameSource frame;
+    uint16_t frameSize;
+    uint8_t brightness;
+    const CRGB *background = nullptr;
+    uint8_t bkAmount = 0;                 // nblend amounts for the background - 255-opacity
+    uint8_t bkAmountAfter = 0;
+    FFXOverlay *overlay = nullptr;
+    CRGB *ovlFrame = nullptr;
+    FFXSpan ovlSpan = FFXSpan();
+};
+
+#endif
@@ -6,6 +6,8 @@
 // 
 #include "FFXController.h"
 #include "FFXCoreEffects.h"
+#include "FFXTrace.h"
+#include <algorithm>
 
 FFXController::FFXController( FFXPixelController *initSC ) {
   initialize( initSC );
@@ -14,15 +16,21 @@ FFXController::FFXController( FFXPixelController *initSC ) {
 FFXController::FFXController() {
 }
 
-void FFXController::initialize( FFXPixelController *initPC ) {
+void FFXController::initialize( FFXPixelController *initPC, uint16_t poolFrames ) {
   if (ledController) {
     delete ledController;
   }
   for (auto seg : segments) { delete seg; }
   segments.clear();
+  rebuildTagTable();
+  coverage.invalidate();
+  bufferPool.release( primaryFrame );
+  primaryFrame = nullptr;
+  primaryFrameSpan.clear();
   ledController = initPC;
   ledController->setBrightness(255);
   numLeds = ledController->getNumLeds();
+  bufferPool.reserve( FFXBufferPool::bytesFor( numLeds, poolFrames ) );
   liveLeds = ledController->getLeds();
   fill_solid( liveLeds, CRGB::Black, numLeds );
   ledController->show();
@@ -30,6 +38,18 @@ void FFXController::initialize( FFXPixelController *initPC ) {
   minRefreshTimer.start();
 }
 
+void FFXController::onEvent( FFXSegment *segment, FXEventType event, const char *name ) {
+  if (stringEvents) {
+    // String form of the event, as passed to onFXEvent() by earlier versions
+    switch (event) {
+      case FX_BRIGHTNESS_CHANGED :
+      case FX_LOCAL_BRIGHTNESS_ENABLED :
+      case FX_OPACITY_CHANGED : { onFXEvent( segment->getTag(), event, "Segment:"+ (segment->isPrimary() ? "Primary" : segment->getTag()) ); break; }
+      default : { onFXEvent( segment->getTag(), event, String( name ? name : "" ) ); }
+    }
+  }
+}
+
 void FFXController::setFX( FFXBase *newFX ) {
   if (newFX) {
    getPrimarySegment()->setFX(newFX);
@@ -41,32 +61,100 @@ void FFXController::setOverlayFX( FFXOverlay *newFX ) {
 }
 
 FFXSegment *FFXController::addSegment(String initTag, uint16_t initStartIdx, uint16_t initEndIdx, FFXBase* initEffect ) {
-  FFXSegment *result = nullptr;
-  auto it = std::find_if( segments.begin(), segments.end(), [&initTag](FFXSegment*& element) -> bool { return element->compareTag(initTag); } );
-  if (it!=segments.end()) {
-    result = *it;
-  }
-  else {
+  FFXSegment *result = getSegment( getSegmentHandle(initTag) );
+  if (!result && segments.size() < FFX_NO_SEGMENT) {
     if (!initEffect) { initEffect = new SolidFX( initEndIdx-initStartIdx+1 ); }
-    result = new FFXSegment( initTag, initStartIdx, initEndIdx, initEffect, liveLeds, this );
+    result = new FFXSegment( initTag, initStartIdx, initEndIdx, initEffect, liveLeds, this, segments.size() );
     segments.push_back( result );
+    addToTagTable( result );
+    coverage.invalidate();
     if (result->getFX()) {
       result->getFX()->start();
     }
+    if (governor.getLevel() != FFXGovernor::FULL_QUALITY) { applyGovernorLevel(); }
   }
   return result;
 }
 
-FFXSegment *FFXController::findSegment(String tag) {
-    auto it = std::find_if( segments.begin(), segments.end(), [&tag](FFXSegment*& element) -> bool { return element->compareTag(tag); } ); 
-    if (it==segments.end()) { 
-      return getPrimarySegment(); 
+FFXSegment *FFXController::findSegment(const String &tag) {
+    FFXSegment *result = getSegment( getSegmentHandle(tag) );
+    return result ? result : getPrimarySegment();
+}
+
+uint32_t FFXController::hashTag( const char *tag ) {
+  // FNV-1a
+  uint32_t result = 2166136261u;
+  while (*tag) { result = (result ^ (uint8_t)(*tag++)) * 16777619u; }
+  return result;
+}
+
+uint16_t FFXController::getSegmentHandle(const String &tag) {
+  if (tagTableSize) {
+    uint32_t hash = hashTag( tag.c_str() );
+    for (uint16_t i = hash & (tagTableSize-1); tagTable[i]; i = (i+1) & (tagTableSize-1)) {
+      FFXSegment *seg = segments[tagTable[i]-1];
+      if (seg->getTagHash()==hash && seg->compareTag(tag)) { return tagTable[i]-1; }
     }
-    else { 
-      return *it; 
-    } 
+  }
+  return FFX_NO_SEGMENT;
 }
 
+void FFXController::addToTagTable( FFXSegment *seg ) {
+  if (segments.size()*2 > tagTableSize) { 
+    rebuildTagTable(); 
+  }
+  else {
+    uint16_t i = seg->getTagHash() & (tagTableSize-1);
+    while (tagTable[i]) { i = (i+1) & (tagTableSize-1); }
+    tagTable[i] = seg->getHandle()+1;
+  }
+}
+
+void FFXController::rebuildTagTable() {
+  uint32_t newSize = 8;
+  while (newSize < segments.size()*2) { newSize *= 2; }
+  if (newSize > 32768) { newSize = 32768; }
+  if (newSize != tagTableSize) {
+    if (tagTable) { free( tagTable ); }
+    tagTable = (uint16_t *)malloc( newSize*sizeof(uint16_t) );
+    tagTableSize = tagTable ? newSize : 0;
+  }
+  if (tagTable) {
+    memset( tagTable, 0, tagTableSize*sizeof(uint16_t) );
+    uint16_t inTable = 0;
+    for (auto seg : segments) {
+      // First segment with a given tag wins, as with the linear search
+      if (inTable < tagTableSize-1 && getSegmentHandle(seg->getTag())==FFX_NO_SEGMENT) {
+        uint16_t i = seg->getTagHash() & (tagTableSize-1);
+        while (tagTable[i]) { i = (i+1) & (tagTableSize-1); }
+        tagTable[i] = seg->getHandle()+1;
+        inTable++;
+      }
+    }
+  }
+}
+
+const CRGB *FFXController::getPrimaryFrame( uint16_t first, uint16_t last ) {
+  if (!primaryFrame) { primaryFrame = bufferPool.allocate( numLeds ); }
+  // Fill in whatever part of first..last isn't there yet (keeping the valid pixels one contiguous span)
+  FFXSpan needed = FFXSpan( first, last );
+  needed.add( primaryFrameSpan );
+  FFXSpan pieces[2] = { needed, FFXSpan() };
+  if (!primaryFrameSpan.isEmpty()) {
+    pieces[0] = (needed.first < primaryFrameSpan.first) ? FFXSpan( needed.first, primaryFrameSpan.first-1 ) : FFXSpan();
+    pieces[1] = (needed.last > primaryFrameSpan.last) ? FFXSpan( primaryFrameSpan.last+1, needed.last ) : FFXSpan();
+  }
+  FFXSegment *primary = getPrimarySegment();
+  for (FFXSpan &piece : pieces) {
+    if (!piece.isEmpty()) {
+      primary->getFrameProvider()->getLastFrame( &(primaryFrame[piece.first]), piece.first, piece.last );
+      CRGBSet pixels = CRGBSet( &(primaryFrame[piece.first]), piece.length() );
+      primary->getActiveDimmer()->onUpdate( pixels );
+    }
+  }
+  primaryFrameSpan = needed;
+  return primaryFrame;
+}
 
 void FFXController::show() {
       if (centerOffset > 0) {
@@ -76,26 +164,175 @@ void FFXController::show() {
       if (centerOffset > 0) {
         FFXBase::rotateBufferBackwardWithWrap( liveLeds, liveLeds, numLeds, centerOffset );
       }
-      ledController->show();
+      unsigned long showTicks = GET_TIME_TICKS;
+      unsigned long showStart = micros();
+      {
+        FFX_TRACE_SCOPE( "FFXPixelController::show" );
+        ledController->showChanged( changedSpan.first, changedSpan.last );
+      }
+      lastShowMicros = micros() - showStart;
+      FFX_INSTRUMENT_ONLY( stats.add( FFXRenderStats::SHOW, lastShowMicros, changedSpan.length()*sizeof(CRGB) ) );
+      // the changes are kept until they have really gone out, if the pixel controller put the show off
+      if (!isShowDeferred()) {
+        lastShowTicks = showTicks;
+        changedSpan.clear();
+      }
+}
+
+void FFXController::setFrameBudget( unsigned long micros ) {
+  frameBudget = micros;
+  if (frameBudget == 0) {
+    for (auto seg : segments) {
+      seg->getFrameProvider()->setBlendAllowed( true );
+      if (seg->getOverlayFrameProvider()) { seg->getOverlayFrameProvider()->setBlendAllowed( true ); }
+    }
+  }
+}
+
+unsigned long FFXController::getDroppedBlendSteps() {
+  unsigned long result = 0;
+  for (auto seg : segments) {
+    result += seg->getFrameProvider()->getDroppedBlendSteps();
+    if (seg->getOverlayFrameProvider()) { result += seg->getOverlayFrameProvider()->getDroppedBlendSteps(); }
+  }
+  return result;
+}
+
+void FFXController::allocateBlendSteps() {
+  // Rank every crossfading provider by priority, plus one for each update it has had to wait, then allow as many as fit 
+  // into what the rest of the update leaves of the budget.  A provider with no measured cost yet is always allowed.
+  // Ties go in segment order (overlays before their segment's frame).
+  blendQueue.clear();
+  blendOrder.clear();
+  for (auto seg : segments) {
+    if (seg->isVisible() && seg->getFX()) {
+      FFXFrameProvider *ovl = seg->getOverlayFrameProvider();
+      if (ovl && seg->getOverlay() && ovl->wantsBlend( seg->getOverlay() )) { blendQueue.push_back( ovl ); }
+      if (seg->getFrameProvider()->wantsBlend( seg->getFX() )) { blendQueue.push_back( seg->getFrameProvider() ); }
+    }
+  }
+  for (uint16_t i = 0; i < blendQueue.size(); i++) {
+    uint32_t rank = 510 - blendQueue[i]->getBlendPriority() - blendQueue[i]->getBlendWait();
+    blendOrder.push_back( (rank << 16) | i );
+  }
+  std::sort( blendOrder.begin(), blendOrder.end() );
+  unsigned long available = (frameBudget > baseUpdateMicros) ? frameBudget - baseUpdateMicros : 0;
+  unsigned long allocated = 0;
+  for (uint32_t entry : blendOrder) {
+    FFXFrameProvider *provider = blendQueue[entry & 0xFFFF];
+    bool allowed = (allocated + provider->getBlendCost() <= available);
+    if (allowed) { allocated += provider->getBlendCost(); }
+    provider->setBlendAllowed( allowed );
+  }
+}
+
+void FFXController::applyGovernorLevel() {
+  uint8_t level = governor.getLevel();
+  for (auto seg : segments) {
+    seg->setBlendStepSize( (level >= FFXGovernor::COARSE_BLENDS) ? FFX_GOVERNOR_BLEND_STEP : 1 );
+    seg->setCrossFadeSuspended( level >= FFXGovernor::NO_LOW_PRIORITY_CROSSFADE && seg->getBlendPriority() <= governor.getLowPriority() );
+  }
+  minShowTicks = US_TO_TICKS( governor.getMinShowMicros() );
+}
+
+unsigned long FFXController::timeToNextUpdateTicks() {
+  unsigned long result = minimum( minRefreshTimer.timeRemainingTicks(), ledController->timeToShowTicks() );
+  // a show the pixel controller put off waits for its timeToShowTicks() (above)
+  if (showPending && !isShowDeferred()) {
+    unsigned long since = GET_TIME_TICKS - lastShowTicks;
+    result = minimum<unsigned long>( result, (since >= minShowTicks) ? 0 : minShowTicks - since );
+  }
+  for (auto seg : segments) {
+    if (result == 0) { break; }
+    result = minimum( result, seg->timeToNextUpdateTicks() );
+  }
+  return result;
+}
+
+#ifdef FFX_INSTRUMENT
+size_t FFXController::getStatsReport( char *buffer, size_t size ) {
+  if (size == 0) { return 0; }
+  snprintf( buffer, size, "controller:" );
+  size_t len = stats.appendReport( buffer, size );
+  for (auto seg : segments) {
+    FFXRenderStats *segStats = seg->getStats();
+    if (len+1 < size && segStats->getTotalMicros() > 0) {
+      int n = snprintf( &(buffer[len]), size-len, "\n%u %s:", seg->getHandle(), seg->isPrimary() ? "Primary" : seg->getTag().c_str() );
+      if (n > 0) { len = ((size_t)n < size-len) ? len+n : size-1; }
+      len = segStats->appendReport( buffer, size );
+    }
+  }
+  return len;
+}
+
+void FFXController::resetStats() {
+  stats.reset();
+  for (auto seg : segments) { seg->getStats()->reset(); }
+}
+#endif
+
+void FFXController::idle( unsigned long maxMicros ) {
+  unsigned long us = timeToNextUpdateMicros();
+  if (maxMicros && us > maxMicros) { us = maxMicros; }
+  if (us > 0) { sleepMicros( us ); }
 }
 
 void FFXController::update() {
+    FFX_TRACE_SCOPE( "FFXController::update" );
+    unsigned long updateStart = micros();
+    blendMicros = 0;
+    if (frameBudget) { allocateBlendSteps(); }
     bool redraw = false;
+    FFXSpan damage = FFXSpan();
+    primaryFrameSpan.clear();
+    primaryChangedSpan.clear();
+    for (auto seg : segments) {
+        seg->addPendingDamage( damage );
+    }
     for (auto seg : segments) {
-        seg->updateFrame( liveLeds );
+        seg->updateFrame( liveLeds, damage );
         if (seg->isStateChanged()) { if (!seg->isFading()) { this->onFXStateChange(seg); seg->resetStateChanged(); } }
     }
     for (auto seg : segments ) {
-      seg->updateOverlay( liveLeds );
+      seg->updateOverlay( liveLeds, damage );
       if (seg->isUpdated()) { redraw=true; }
     }
+    changedSpan.add( damage );
     // v1.1.1 - add timer to force refresh at specified interval 
     if (minRefreshTimer.isUp()) {
       redraw = true;
       minRefreshTimer.step();
     }
-    if (redraw) {
+    // a show is also due if an asynchronous pixel controller found the last one put off, after update() had handed it over
+    if (redraw || isShowDeferred()) { showPending = true; }
+    bool shown = false;
+    // an asynchronous pixel controller still sending the last frame - keep drawing and show once it is done.  A show the 
+    // pixel controller put off (e.g. a maximum refresh rate) stays pending, and is tried again once it can go.
+    if (showPending && ledController->isShowComplete() && (!isShowDeferred() || ledController->timeToShowTicks() == 0) &&
+        (minShowTicks == 0 || GET_TIME_TICKS - lastShowTicks >= minShowTicks)) {
       show();
-      showCount++;
+      showPending = isShowDeferred();
+      if (!showPending) {
+        showCount++;
+        shown = true;
+      }
+    }
+    lastUpdateMicros = micros() - updateStart;
+    lastBlendMicros = blendMicros;
+    unsigned long base = (lastUpdateMicros > blendMicros) ? lastUpdateMicros - blendMicros : 0;
+    baseUpdateMicros = (baseUpdateMicros==0) ? base : (baseUpdateMicros*7 + base) / 8;
+#ifdef FFX_INSTRUMENT
+    stats.add( FFXRenderStats::UPDATE, lastUpdateMicros, 0 );
+    unsigned long deadline = frameBudget ? frameBudget : governor.getFrameMicros();
+    if (deadline && lastUpdateMicros > deadline) { stats.addMissedDeadline(); }
+#endif
+    if (governor.isEnabled()) {
+      // charge the time the LEDs take to receive the frame, if show() returned before it was sent
+      unsigned long wire = shown ? ledController->getWireMicros() : 0;
+      unsigned long frameMicros = lastUpdateMicros + ((wire > lastShowMicros) ? wire - lastShowMicros : 0);
+      if (governor.record( micros(), frameMicros, shown )) {
+        applyGovernorLevel();
+        onEvent( getPrimarySegment(), FX_GOVERNOR, FFXGovernor::getLevelName( governor.getLevel() ) );
+      }
     }
 }
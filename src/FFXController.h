@@ -15,8 +15,12 @@
 #include "FFXFrameProvider.h"
 #include "FFXAFDimmer.h"
 #include "FFXSegment.h"
+#include "FFXBufferPool.h"
+#include "FFXCoverageMap.h"
+#include "FFXGovernor.h"
 
 #define PRIMARY_SEG_NAME "FXController::PrimarySegmentName"
+#define FFX_NO_SEGMENT 0xFFFF
 /*!  FFXController - Primary class used for displaying/running effects/colors/etc.  Initialize with a PixelController
  *   like: new FXController( new FFXFastLEDPixelController( ledBufferPtr, numberOfLEDs ) );
  * 
@@ -47,6 +51,14 @@
  * 
  *      ** This will show the rotating rainbow effect on pixels 0-25 and the remainder of the strip will continue to show the primary effect.
  * 
+ *   Each segment also has a handle - a small integer that doesn't change while the segment exists (the primary segment is 0).  Looking 
+ *   a tag up once and keeping the handle avoids the String compare on later calls:
+ * 
+ *   ```
+ *   uint16_t left = FXController->getSegmentHandle("Left");     // FFX_NO_SEGMENT if there is no such segment
+ *   FXController->getSegment(left)->setOpacity(128);
+ *   ```
+ * 
  *   inside main processing loop:
  *  
  *   ``` 
@@ -83,16 +95,76 @@
  * 
  *   Note that FFXController() automatically deletes the overlay FX, when it is complete so it MUST be created using - new OverlayFX(...);
  *   See FFXOverlay.h for more info.
+ * 
+ *   Pixel buffers used by segments, frame providers and overlays come from a buffer pool (see FFXBufferPool) reserved by 
+ *   initialize().  Its size is given in full-length frames:
+ * 
+ *   ```
+ *   FFXController.initialize( new FFXFastLEDPixelController( leds, numberOfLEDs ), 6 );
+ *   FFXController.getBufferPool()->getHeapHighWater();
+ *   ```
+ * 
+ *   Crossfade steps can be limited to a time budget - each update(), the controller lets the highest priority segments 
+ *   (see FFXSegment::setBlendPriority()) draw a new crossfade step as long as their measured cost fits in what is left of 
+ *   the budget after the rest of the update.  The others hold their last blend until their turn comes (segments that 
+ *   have waited move up the order).  The budget is off (0) by default.
+ * 
+ *   ```
+ *   FFXController.setFrameBudget( 4000 );                // micros per update()
+ *   FFXController.getLastUpdateMicros();
+ *   FFXController.getDroppedBlendSteps();
+ *   ```
+ * 
+ *   Instead of tuning effect intervals, crossfades and refresh rates for each install, a target frame rate can be set - the 
+ *   controller then measures each update() and show() (with the time to send the frame to the LEDs) and cuts back on 
+ *   crossfades and the show rate when it can't keep up, and restores them when there is time to spare (see FFXGovernor).  
+ *   Each change is reported to onEvent() as FX_GOVERNOR, with the name of the new level.
+ * 
+ *   ```
+ *   FFXController.setTargetFPS( 60 );
+ *   FFXController.findSegment("Sign")->setBlendPriority( 200 );    // keep crossfading this one as long as possible
+ *   FFXController.getGovernor()->getLevel();
+ *   ```
+ * 
+ *   update() only has work to do when an effect, overlay, crossfade or fade is due to move on.  Rather than calling it in 
+ *   a tight loop, a sketch can ask how long it is until the next one and sleep (or do other work) until then - idle() 
+ *   does this with sleepMicros(), which can be overridden to use a light sleep mode.  Call update() again after changing
+ *   anything (effects, brightness, etc.) rather than waiting out a sleep worked out before the change.
+ * 
+ *   ```
+ *   void loop() {
+ *     FFXController.update();
+ *     FFXController.idle( 50000 );      // up to 50ms - wakes in time for the next frame or fade step
+ *   }
+ *   ```
+ * 
+ *   Built with FFX_INSTRUMENT defined, the controller and each segment record how many times each stage of drawing (effect 
+ *   step, crossfade, dimming, opacity, overlay, show) ran, how long it took and how many bytes it wrote, to find the segments 
+ *   that use up the frame time (see FFXRenderStats).  Without it nothing is recorded and none of this is compiled in.
+ * 
+ *   ```
+ *   char report[2048];
+ *   FFXController.getStatsReport( report, sizeof(report) );      // one line per segment - "stage=calls/avg_us/max_us/kB"
+ *   Serial.println( report );
+ *   FFXController.resetStats();
+ *   ```
+ * 
+ *   Events (effect started, brightness changed, etc.) are reported to onEvent(), which receives the segment, the event 
+ *   type and the name of the effect/attribute involved (nullptr if none) without allocating anything.  The default 
+ *   onEvent() passes events on to onFXEvent() with the segment tag and name as Strings, as in earlier versions - call 
+ *   setStringEvents(false) to skip that when onFXEvent() isn't used.
  */
 class FFXController {
 
   public:
     unsigned long long showCount = 0;
-    enum FXEventType { FX_STARTED, FX_STOPPED, FX_OVERLAY_STARTED, FX_OVERLAY_STOPPED, FX_OVERLAY_COMPLETED, FX_OVERLAY_UPDATED, FX_PAUSED, FX_RESUMED, FX_BRIGHTNESS_CHANGED, FX_LOCAL_BRIGHTNESS_ENABLED, FX_OPACITY_CHANGED, FX_PARAM_CHANGE, FX_LOG };
+    enum FXEventType { FX_STARTED, FX_STOPPED, FX_OVERLAY_STARTED, FX_OVERLAY_STOPPED, FX_OVERLAY_COMPLETED, FX_OVERLAY_UPDATED, FX_PAUSED, FX_RESUMED, FX_BRIGHTNESS_CHANGED, FX_LOCAL_BRIGHTNESS_ENABLED, FX_OPACITY_CHANGED, FX_PARAM_CHANGE, FX_LOG, FX_GOVERNOR };
     FFXController( FFXPixelController *initPC );
     FFXController();
-    ~FFXController() { 
+    virtual ~FFXController() { 
       if (ledController) { delete ledController; } 
+      bufferPool.release( primaryFrame );
+      if (tagTable) { free( tagTable ); }
       // if (ovlFX) { delete ovlFX; }
       if (segments.size() > 0) {
         for (auto seg : segments) {
@@ -102,17 +174,44 @@ class FFXController {
       }
     }
 
-    void initialize( FFXPixelController *initPC );
+    /*! Start using initPC, with a buffer pool big enough for poolFrames full-length frames (0 = allocate buffers from the heap) */
+    void initialize( FFXPixelController *initPC, uint16_t poolFrames = FFX_BUFFER_POOL_FRAMES );
+    FFXBufferPool *getBufferPool() { return &bufferPool; }
 
+    virtual void onEvent( FFXSegment *segment, FXEventType event, const char *name );
     virtual void onFXEvent( const String &segment, FXEventType event, const String &name ) { };
+    void setStringEvents( bool enable ) { stringEvents = enable; }
+    bool getStringEvents() { return stringEvents; }
     virtual void onFXStateChange(FFXSegment *segment) {};
     void setFX( FFXBase *newFX );
     FFXBase *getFX() { return getPrimarySegment()->getFX(); }
 
     FFXSegment *addSegment(String initTag, uint16_t initStartIdx, uint16_t initEndIdx, FFXBase* initEffect );
     FFXSegment *addSegment(String initTag, uint16_t initStartIdx, uint16_t initEndIdx) { return addSegment(initTag, initStartIdx, initEndIdx, nullptr ); }
-    FFXSegment *findSegment(String tag);
+    /*! Segment with the given tag, or the primary segment if there isn't one */
+    FFXSegment *findSegment(const String &tag);
     FFXSegment *getPrimarySegment() { return segments[0]; }
+    /*! Handle of the segment with the given tag (FFX_NO_SEGMENT if there isn't one) */
+    uint16_t getSegmentHandle(const String &tag);
+    /*! Segment for a handle from getSegmentHandle() or FFXSegment::getHandle() (nullptr if not valid) */
+    FFXSegment *getSegment(uint16_t handle) { return (handle < segments.size()) ? segments[handle] : nullptr; }
+    uint16_t getSegmentCount() { return segments.size(); }
+    /*! Called by FFXSegment::setTag() to keep tag lookups up to date */
+    void onTagChanged( FFXSegment *seg ) { rebuildTagTable(); }
+    static uint32_t hashTag( const char *tag );
+    /*! True if any other visible segment shares pixels with seg */
+    bool isOverlapped( FFXSegment *seg ) { return getCoverageMap()->isOverlapped( seg->getHandle() ); }
+    /*! True if nothing is drawn over seg's pixels after it - no later visible segment and no other segment's overlay */
+    bool isOnTop( FFXSegment *seg ) { return getCoverageMap()->isOnTop( seg->getHandle() ); }
+    /*! Which segments cover which pixels - rebuilt when needed.  Segments call invalidateCoverage() when their visibility, 
+     *  opacity (opaque or not) or overlay changes. */
+    FFXCoverageMap *getCoverageMap() { if (!coverage.isValid()) { coverage.build( segments, numLeds ); } return &coverage; }
+    void invalidateCoverage() { coverage.invalidate(); }
+    void notifySegments( boolean includePrimary, const FFXEvent &event ) {
+      for (FFXSegment *seg : segments) {
+        if (includePrimary || !seg->isPrimary()) { seg->onEvent( event ); }
+      }
+    }
     void notifySegments( boolean includePrimary, String source, String attribute, String value ) {
       for (FFXSegment *seg : segments) {
         if (includePrimary || !seg->isPrimary()) { seg->onNotify(source, attribute, value); }
@@ -134,10 +233,83 @@ class FFXController {
     void setMinRefreshInterval( unsigned long newVal ) {  if (newVal!=minRefreshTimer.getInterval()) { minRefreshTimer.setInterval(newVal);} }
     void show();
     void update();
+    /*! Ticks until update() next has anything to do - the earliest effect/overlay step, crossfade step, fade step, put 
+     *  off show() or minimum refresh over all segments.  0 = call update() now. */
+    unsigned long timeToNextUpdateTicks();
+    unsigned long timeToNextUpdate() { return TICKS_TO_MS(timeToNextUpdateTicks()); }
+    unsigned long timeToNextUpdateMicros() { unsigned long t = timeToNextUpdateTicks(); return (t >= ULONG_MAX/(1000/FLEX_TICKS_PER_MS)) ? ULONG_MAX : t*(1000/FLEX_TICKS_PER_MS); }
+    /*! Sleep (see sleepMicros()) until update() next has anything to do, for maxMicros at most (0 = no limit) */
+    void idle( unsigned long maxMicros = 0 );
+    /*! Called by idle() - the default uses delay()/delayMicroseconds().  Override to use a low power sleep mode. */
+    virtual void sleepMicros( unsigned long us ) { if (us >= 1000) { delay( us/1000 ); } if (us % 1000) { delayMicroseconds( us % 1000 ); } }
+    /*! Target time (micros) for each call to update() - crossfade steps that would go over it are dropped.  0 = no limit. */
+    void setFrameBudget( unsigned long micros );
+    unsigned long getFrameBudget() { return frameBudget; }
+    /*! Time taken by the last update() (micros) */
+    unsigned long getLastUpdateMicros() { return lastUpdateMicros; }
+    /*! Time the last update() spent drawing crossfade steps (micros) */
+    unsigned long getLastBlendMicros() { return lastBlendMicros; }
+    /*! Average time update() takes apart from crossfade steps - the budget for crossfade steps is what is left of the frame budget */
+    unsigned long getBaseUpdateMicros() { return baseUpdateMicros; }
+    /*! Crossfade steps dropped so far, by all segments and overlays */
+    unsigned long getDroppedBlendSteps();
+    /*! Cut back on quality automatically when frames can't be produced at this rate (see FFXGovernor) - 0 = off */
+    void setTargetFPS( uint16_t fps ) { governor.setTargetFPS( fps ); applyGovernorLevel(); }
+    uint16_t getTargetFPS() { return governor.getTargetFPS(); }
+    FFXGovernor *getGovernor() { return &governor; }
+    /*! Time taken by the last show() (micros) - not including any time the LED data is still being sent after it returns */
+    unsigned long getLastShowMicros() { return lastShowMicros; }
+    /*! Minimum time between frames shown (micros), set by the governor - 0 = no limit */
+    unsigned long getMinShowMicros() { return governor.getMinShowMicros(); }
+    /*! Called by segments with the time taken to draw a crossfade step */
+    void addBlendTime( FFXFrameProvider *provider, unsigned long micros ) { provider->recordBlendCost( micros ); blendMicros += micros; }
+    /*! Pixels changed since the last call to show() - update() only redraws these */
+    const FFXSpan &getChangedSpan() { return changedSpan; }
+    /*! The primary segment's last frame with its brightness applied (strip indexes), as translucent segments blend over it.  
+     *  Valid for pixels first..last until the next update() - each pixel is only worked out once per update, however 
+     *  many segments ask for it. */
+    const CRGB *getPrimaryFrame( uint16_t first, uint16_t last );
+    /*! Pixels of the primary frame (strip indexes) that changed this update - including those it didn't draw, as they are 
+     *  under an opaque segment, but a translucent segment may still blend over them */
+    const FFXSpan &getPrimaryChangedSpan() { return primaryChangedSpan; }
+    void setPrimaryChangedSpan( const FFXSpan &span ) { primaryChangedSpan = span; }
+#ifdef FFX_INSTRUMENT
+    /*! Time spent in show() and update(), and the number of updates over the frame budget/frame time - see FFXRenderStats */
+    FFXRenderStats *getStats() { return &stats; }
+    /*! Report of the controller's stats and those of each segment that has drawn anything, one line each, in buffer.  
+     *  Returns the length of the report (cut short if it doesn't fit). */
+    size_t getStatsReport( char *buffer, size_t size );
+    void resetStats();
+#endif
 
   private:
      boolean initialized = false;                       
+     bool stringEvents = true;
+     unsigned long frameBudget = 0;
+     unsigned long lastUpdateMicros = 0;
+     unsigned long lastBlendMicros = 0;
+     unsigned long baseUpdateMicros = 0;
+     unsigned long blendMicros = 0;
+     std::vector<FFXFrameProvider *> blendQueue = std::vector<FFXFrameProvider *>();
+     std::vector<uint32_t> blendOrder = std::vector<uint32_t>();   // rank << 16 | index into blendQueue
+     void allocateBlendSteps();
+     FFXGovernor governor = FFXGovernor();
+     unsigned long lastShowMicros = 0;
+     unsigned long lastShowTicks = 0;                  // shows are paced on the timer clock (micros() only measures them)
+     unsigned long minShowTicks = 0;
+     bool showPending = false;
+     /*! The pixel controller put the last show() off - see FFXPixelController::timeToShowTicks() */
+     bool isShowDeferred() { return ledController->isShowComplete() && ledController->timeToShowTicks() != ULONG_MAX; }
+#ifdef FFX_INSTRUMENT
+     FFXRenderStats stats = FFXRenderStats();
+#endif
+     void applyGovernorLevel();
      uint16_t centerOffset = 0;
+     // Tag lookup - open addressed hash table of (handle+1), 0 = empty slot.  tagTableSize is a power of 2, at least twice the number of segments.
+     uint16_t *tagTable = nullptr;
+     uint16_t tagTableSize = 0;
+     void addToTagTable( FFXSegment *seg );
+     void rebuildTagTable();
 
   protected:
     std::vector<FFXSegment *> segments = std::vector<FFXSegment *>();
@@ -146,6 +318,12 @@ class FFXController {
     StepTimer minRefreshTimer = StepTimer(500);
     CRGB *liveLeds = nullptr;
     uint16_t numLeds;    
+    FFXSpan changedSpan = FFXSpan();
+    CRGB *primaryFrame = nullptr;                   // cache for getPrimaryFrame()
+    FFXSpan primaryFrameSpan = FFXSpan();           // ...pixels of it that are valid this update
+    FFXSpan primaryChangedSpan = FFXSpan();
+    FFXCoverageMap coverage = FFXCoverageMap();
+    FFXBufferPool bufferPool = FFXBufferPool();     // declared last - segments release their buffers into it when deleted
  };
 
 #endif
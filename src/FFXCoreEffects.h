@@ -187,6 +187,8 @@ class SolidFX : public FFXBase {
     } 
     else {
       setUpdated(false);
+      frameDataChanged = false;
+      markClean();
     }
   }
   
@@ -198,7 +200,7 @@ class SolidFX : public FFXBase {
  */
 class PaletteFX : public FFXBase {
   public:
-     PaletteFX( uint8_t initSize ) : FFXBase( initSize, (uint8_t)200, 10, 250 ) {
+     PaletteFX( uint16_t initSize ) : FFXBase( initSize, (uint8_t)200, 10, 250 ) {
        fxid = PALETTE_FX_ID;
        fxName = PALETTE_FX_NAME;
        currColor.setColorMode( FFXColor::FFXColorMode::palette256);
@@ -231,6 +233,8 @@ class PaletteFX : public FFXBase {
     }   
     else {
       setUpdated(false);
+      frameDataChanged = false;
+      markClean();
     }
   }
 
@@ -251,7 +255,7 @@ class ChaseFX : public FFXRotate {
     uint16_t shiftDelay = 3;
 
   public:
-    ChaseFX( uint8_t initSize, uint8_t initSpeed ) : FFXRotate( initSize, initSpeed, 60UL, 2000UL ) {
+    ChaseFX( uint16_t initSize, uint8_t initSpeed ) : FFXRotate( initSize, initSpeed, 60UL, 2000UL ) {
       fxid = CHASE_FX_ID;
       fxName = CHASE_FX_NAME;
       currColor.setColorMode( FFXColor::FFXColorMode::palette16 );
@@ -260,7 +264,7 @@ class ChaseFX : public FFXRotate {
       currColor.setShiftDelta(0);
       currColor.reset();
     }
-    ChaseFX( uint8_t initSize ) : ChaseFX( initSize, 128 ){}
+    ChaseFX( uint16_t initSize ) : ChaseFX( initSize, 128 ){}
 
     uint8_t getDotWidth() { return dotWidth; }
     void setDotWidth( uint8_t newWidth ) {
@@ -298,6 +302,7 @@ class ChaseFX : public FFXRotate {
         while (i <= numLeds-1-(dotSpacing==0 ? 0 : 1)) {
           uint8_t space = (i==1 ? 0 : dotSpacing);
           //uint16_t strt = (i==1 ? dotSpacing : i);
+          if (i+space > numLeds-1) { break; }    // next dot would start past the end of the buffer
           pixels( i+space, minimum(i+space+(dotWidth-1),numLeds-1) ) = getColor();
           i = i+space+(dotWidth-1)+1;
           if (((currColor.getColorMode() == FFXColor::FFXColorMode::palette16)) || (currColor.getColorMode() == FFXColor::FFXColorMode::palette256)) {
@@ -353,6 +358,7 @@ class MotionFX : public FFXBase {
       fxName = MOTION_FX_NAME;
       currColor.setColorMode( FFXColor::FFXColorMode::singleCHSV );
       setVCycleRange(127);
+      fullFrameRedraw = true;
       basePalette = initPal;
       baseHue = initHue;
       pendPal = basePalette;
@@ -458,6 +464,7 @@ class RainbowFX : public FFXBase {
       fxid = RAINBOW_FX_ID;       
       fxName = RAINBOW_FX_NAME;
       deltahue = 256/numLeds;
+      fullFrameRedraw = true;
     }
     
     RainbowFX( uint16_t initSize) : RainbowFX( initSize, 30 ) {};  
@@ -470,6 +477,15 @@ class RainbowFX : public FFXBase {
         } 
         setUpdated(true);
     }
+
+    virtual void onCatchUp( unsigned long steps ) override {
+        uint8_t delta = (uint8_t)(steps * deltahue);
+        switch (getMovement()) {
+          case MVT_BACKWARD : { startHue -= delta; break; }
+          case MVT_STILL : { break; }
+          default : { startHue += delta; break; }
+        }
+    }
 };
 
 /*!
@@ -480,6 +496,7 @@ class JuggleFX : public FFXBase {
   private:
     uint8_t balls = 10;
     std::vector<FFXTrigMotion *> motion = std::vector<FFXTrigMotion *>();
+    FFXSpan lit;                   // pixels that are not black (the balls and their trails)
 
   public:
     JuggleFX( uint16_t initSize, unsigned long initTimer ) : FFXBase( initSize, initTimer, 1UL, 80UL ) {
@@ -505,19 +522,22 @@ class JuggleFX : public FFXBase {
     
     virtual void initLeds(CRGB *bufLeds) override {            
       fill_solid(bufLeds, numLeds, CRGB::Black );
+      lit.clear();
     }
 
     virtual void writeNextFrame(CRGB* bufLeds) override {
     // N colored dots, weaving in and out of sync with each other
     currColor.resetStep();    
-    fadeToBlackBy( bufLeds, numLeds, 50 );
+    fadeSpanToBlackBy( bufLeds, lit, 50 );
     for (auto m : motion) {
       if (m->getDelay()==0) {
         uint16_t pos = m->getPosition();      
         uint16_t next_pos = m->getNextPosition();
         bufLeds[pos] |= currColor.getCRGB();
+        lit.add(pos);
         if (m->fractComplete() > 0) {
           bufLeds[next_pos] = FFXBase::alphaBlend( bufLeds[next_pos], bufLeds[pos], m->fractComplete(), FFXBase::GAMMA, FFXBase::GAMMA ); 
+          lit.add(next_pos);
         }
         if (pos==0) { 
           m->setRangeMax( random8(0,8) ); 
@@ -526,6 +546,7 @@ class JuggleFX : public FFXBase {
       currColor.step();
       m->step();
     }      
+    markDirty(lit);
     currColor.shift();       
     setUpdated(true);
   }
@@ -540,6 +561,7 @@ class CylonFX : public FFXBase {
   private:
     FFXTrigMotion mt;
     bool twin = false;
+    FFXSpan lit;                   // pixels that are not black (the eye and its trail)
 
   public:
     CylonFX( uint16_t initSize, unsigned long initTimer ) : FFXBase( initSize, initTimer, 10UL, 330UL ) {
@@ -559,24 +581,35 @@ class CylonFX : public FFXBase {
     
     virtual void initLeds( CRGB *bufLeds ) override {
       fill_solid( bufLeds, numLeds, CRGB::Black );
+      lit.clear();
     }
         
     virtual void writeNextFrame(CRGB *bufLeds) override {        
-        fadeToBlackBy( bufLeds, numLeds, 50 );
+        fadeSpanToBlackBy( bufLeds, lit, 50 );
         uint16_t pos = mt.getPosition();
         bufLeds[pos] = currColor.getCRGB();
+        lit.add(pos);
         if (mt.fractComplete() > 0) {
           bufLeds[mt.getNextPosition()] = FFXBase::alphaBlend( bufLeds[mt.getNextPosition()], bufLeds[pos], mt.fractComplete(), FFXBase::GAMMA, FFXBase::GAMMA ); 
+          lit.add(mt.getNextPosition());
         }
         if (twin) {
           bufLeds[mirror(pos)] = bufLeds[pos];        
+          lit.add(mirror(pos));
           if (mt.fractComplete() > 0) {
             bufLeds[mirror(mt.getNextPosition())] = FFXBase::alphaBlend( bufLeds[mirror(mt.getNextPosition())], bufLeds[mirror(pos)], mt.fractComplete(), FFXBase::GAMMA, FFXBase::GAMMA ); 
+            lit.add(mirror(mt.getNextPosition()));
           }
         }
+        markDirty(lit);
         mt.step();
         setUpdated(true);
     }
+
+    // the eye moves on - its trail is drawn (and faded) from where it is when drawing starts again
+    virtual void onCatchUp( unsigned long steps ) override {
+        for (unsigned long i = 0; i < steps; i++) { mt.step(); }
+    }
     
 };
 
@@ -655,11 +688,11 @@ public:
       currColor.setColorMode( FFXColor::singleCRGB );
       currColor.setCRGB( baseColor );      
       pixelState = new uint8_t[numLeds];
-      memset( pixelState, sizeof(pixelState), SteadyDim);      
+      memset( pixelState, SteadyDim, numLeds );      
     }  
   
   TwinkleFX( uint16_t initSize ) : TwinkleFX( initSize, 30 ) {}; 
-  ~TwinkleFX() { delete pixelState; }
+  ~TwinkleFX() { delete[] pixelState; }
   
   virtual void initLeds( CRGB *bufLeds ) override {
       fill_solid( bufLeds, numLeds, currColor.getCRGB() );
@@ -718,6 +751,7 @@ class DimUsingPaletteFX : public FFXBase {
     DimUsingPaletteFX(  uint16_t initSize ) : FFXBase( initSize, (uint8_t)10, 10, 1000 ) {
       fxid = DIM_PAL_FX_ID;
       fxName = DIM_PAL_FX_NAME;
+      fullFrameRedraw = true;
       currColor.setColorMode( FFXColor::FFXColorMode::palette256 );
       currColor.setPalette( ::soft_white_dim_gp );
     }
@@ -782,6 +816,7 @@ public:
     PacificaFX( uint16_t initSize ) : FFXBase( initSize, (uint8_t)255, 1UL, 20UL ) { 
         fxid = PACIFICA_FX_ID;
         fxName = PACIFICA_FX_NAME;
+        fullFrameRedraw = true;
       }
 
     virtual void writeNextFrame( CRGB *bufLeds ) override {
@@ -792,7 +827,7 @@ private:
     void pacifica_loop( CRGB *bufLeds ) {
       // Increment the four "color index start" counters, one for each wave layer.
       // Each is incremented at a different speed, and the speeds vary over time.
-      uint32_t ms = millis();
+      uint32_t ms = GET_TIME_MILLIS;
       uint32_t deltams = ms - sLastms;
       sLastms = ms;
       uint16_t speedfactor1 = beatsin16(3, 179, 269);
@@ -866,7 +901,7 @@ private:
     }
 
   private:
-    uint16_t sCIStart1, sCIStart2, sCIStart3, sCIStart4;
+    uint16_t sCIStart1 = 0, sCIStart2 = 0, sCIStart3 = 0, sCIStart4 = 0;
     uint32_t sLastms = 0;    
 };
 
@@ -902,6 +937,8 @@ public:
     {
       fxid = FIRE_FX_ID;       
       fxName = FIRE_FX_NAME;      
+      // mirrored with an odd length leaves the center pixel to carry over from the previous frame
+      fullFrameRedraw = (!bMirrored || (numLeds % 2)==0);
       currColor.setColorMode( FFXColor::singleCRGB );
       currColor.setCRGB( CRGB::Black );        
       heat = new byte[getNumLeds()] { 0 };
@@ -1006,6 +1043,7 @@ class WaveOverlayFX : public FFXOverlay {
 
     WaveOverlayFX( uint16_t initSize, uint8_t speed, uint8_t repeat, MovementType dir = MVT_FORWARD ) : FFXOverlay(initSize, speed, repeat, 0) {
       fxName = WAVE_OVLY_FX_NAME;
+      perPixel = true;
       setVCycleRange( numLeds + 50 );
       currColor.setColorMode(FFXColor::FFXColorMode::palette256);
       setMovement( dir );
@@ -1068,6 +1106,7 @@ class PulseOverlayFX : public FFXOverlay {
   public:
     PulseOverlayFX( uint16_t initSize, uint8_t speed, uint8_t repeat ) : FFXOverlay(initSize, speed, repeat, 0) {
       fxName = PULSE_OVLY_FX_NAME;
+      perPixel = true;
       currColor.setColorMode(FFXColor::FFXColorMode::palette256);
       setMovement( MVT_STILL );
       setMaxAlpha(240);
@@ -1098,6 +1137,7 @@ class PulseOverlayFX : public FFXOverlay {
       for (uint16_t i=rangeLo; i<=rangeHi; i++) {
         alpha[i] = valpha;
       }
+      applySpan = (valpha ? FFXSpan( rangeLo, rangeHi ) : FFXSpan());
       setUpdated(true);
     }
 
@@ -1117,6 +1157,7 @@ class ZipOverlayFX : public FFXOverlay {
   public:
     ZipOverlayFX( uint16_t initSize, uint8_t speed, uint8_t repeat ) : FFXOverlay(initSize, speed, repeat, 0) {
       fxName = ZIP_OVLY_FX_NAME;
+      perPixel = true;
       currColor.setColorMode(FFXColor::FFXColorMode::palette256);
       setMovement( MVT_FORWARD );
       setMaxAlpha(240);
@@ -1140,20 +1181,20 @@ class ZipOverlayFX : public FFXOverlay {
     }
 
    virtual void onVCycleStart( CRGB *currFrame ) override {
-     // set all pixels to transparent
-     clearAlpha();
+     // set all pixels to transparent - every write below goes through setAlpha(), so the apply span can start empty
+     resetAlpha();
      // if starting in the center - set the middle 3 pixels opaque and move outward from there...
      if (getCurrMovement(getCurrVCycle())==MVT_BACKWARD) {
-        alpha[rangeMid+1]=255;
-        alpha[rangeMid]=255;
-        alpha[rangeMid-1]=255;
+        setAlpha(rangeMid+1, 255);
+        setAlpha(rangeMid, 255);
+        setAlpha(rangeMid-1, 255);
      }
      // call parent class' method in case it needs to do something
      FFXOverlay::onVCycleStart( currFrame );
    }
 
   virtual void onVCycleEnd( CRGB *currFrame ) override {
-     clearAlpha();
+     resetAlpha();
      // call parent class' method in case it needs to do something
      FFXOverlay::onVCycleEnd( currFrame );
   }
@@ -1163,13 +1204,13 @@ class ZipOverlayFX : public FFXOverlay {
       uint16_t vindex = fixed_map( getMovementVPhase(), 1, getVCycleRange(), rangeLo, rangeHi);            
       if (vindex <= rangeMid) { 
         a = (getCurrMovement(getCurrVCycle())==MVT_BACKWARD) ? 0 : 255;        
-        alpha[vindex] = a; 
-        alpha[mirror(vindex)] = a;
+        setAlpha(vindex, a); 
+        setAlpha(mirror(vindex), a);
       }
       else { 
         a = (getCurrMovement(getCurrVCycle())==MVT_BACKWARD) ? 255 : 0;        
-        alpha[vindex-rangeMid-1] = a; 
-        alpha[mirror(vindex-rangeMid-1)] = a;        
+        setAlpha(vindex-rangeMid-1, a); 
+        setAlpha(mirror(vindex-rangeMid-1), a);        
       }
       setUpdated(true);
     }
@@ -0,0 +1,79 @@
+//
+//  FFXCoverageMap.cpp
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "FFXCoverageMap.h"
+#include "FFXSegment.h"
+#include <algorithm>
+
+void FFXCoverageMap::build( std::vector<FFXSegment *> &segments, uint16_t numLeds ) {
+  bounds.clear();
+  bounds.push_back( 0 );
+  for (auto seg : segments) {
+    bounds.push_back( seg->getStart() );
+    if ((uint32_t)seg->getEnd()+1 < numLeds) { bounds.push_back( seg->getEnd()+1 ); }
+  }
+  std::sort( bounds.begin(), bounds.end() );
+  bounds.erase( std::unique( bounds.begin(), bounds.end() ), bounds.end() );
+  uint16_t numIntervals = bounds.size();
+  topOpaque.assign( numIntervals, 0 );
+  topVisible.assign( numIntervals, 0 );
+  numVisible.assign( numIntervals, 0 );
+  numOverlays.assign( numIntervals, 0 );
+  // Segments are drawn in order, so the last one to cover an interval is on top
+  uint16_t handle = 0;
+  for (auto seg : segments) {
+    if (seg->isVisible()) {
+      bool opaque = seg->isOpaque();
+      bool overlay = (seg->getOverlay() != nullptr);
+      for (uint16_t i = intervalAt( seg->getStart() ); i < numIntervals && bounds[i] <= seg->getEnd(); i++) {
+        numVisible[i]++;
+        topVisible[i] = handle+1;
+        if (opaque) { topOpaque[i] = handle+1; }
+        if (overlay) { numOverlays[i]++; }
+      }
+    }
+    handle++;
+  }
+  flags.assign( segments.size(), 0 );
+  handle = 0;
+  for (auto seg : segments) {
+    uint8_t self = (seg->isVisible() ? 1 : 0);
+    uint8_t selfOverlay = (seg->getOverlay() ? 1 : 0);
+    bool overlapped = false;
+    bool onTop = true;
+    bool hidden = false;
+    for (uint16_t i = intervalAt( seg->getStart() ); i < numIntervals && bounds[i] <= seg->getEnd(); i++) {
+      if (numVisible[i] > self) { overlapped = true; }
+      if (topVisible[i] > handle+1 || numOverlays[i] > selfOverlay) { onTop = false; }
+      if (topOpaque[i] > handle+1) { hidden = true; }
+    }
+    flags[handle] = (overlapped ? OVERLAPPED : 0) | (onTop ? ON_TOP : 0) | (hidden ? PARTLY_HIDDEN : 0);
+    handle++;
+  }
+  valid = true;
+}
+
+uint16_t FFXCoverageMap::intervalAt( uint16_t pos ) {
+  return (std::upper_bound( bounds.begin(), bounds.end(), pos ) - bounds.begin()) - 1;
+}
+
+FFXSpan FFXCoverageMap::nextExposed( uint16_t handle, uint16_t first, uint16_t last ) {
+  FFXSpan result = FFXSpan();
+  if (first > last || bounds.empty()) { return result; }
+  uint16_t numIntervals = bounds.size();
+  uint32_t pos = first;
+  for (uint16_t i = intervalAt( first ); i < numIntervals && pos <= last; i++) {
+    uint32_t end = (i+1 < numIntervals) ? bounds[i+1]-1 : 0xFFFF;
+    if (topOpaque[i] <= handle+1) {
+      result.add( pos, (end < last) ? end : last );
+    }
+    else if (!result.isEmpty()) {
+      break;
+    }
+    pos = end+1;
+  }
+  return result;
+}
@@ -0,0 +1,54 @@
+//
+//  FFXCoverageMap.h
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#ifndef FFX_COVERAGE_MAP_H
+#define FFX_COVERAGE_MAP_H
+
+#include "FFXBase.h"
+
+class FFXSegment;
+
+/*!
+ * FFXCoverageMap - Records which segments cover which pixels, so the controller doesn't have to compare every segment with
+ * every other one on each update.  The strip is split into intervals at each segment's start and end; for each interval
+ * the map keeps the last (topmost) opaque segment covering it.  For each segment it keeps whether any other visible segment
+ * overlaps it and whether anything is drawn over it (see FFXController::isOverlapped() and FFXController::isOnTop()).
+ *
+ * The map only depends on each segment's range, visibility, opacity (fully opaque or not) and overlay, so FFXController
+ * rebuilds it only when one of those changes (see invalidate()).  Buffers are kept between rebuilds.
+ */
+class FFXCoverageMap {
+  public:
+    FFXCoverageMap() { }
+
+    void build( std::vector<FFXSegment *> &segments, uint16_t numLeds );
+    void invalidate() { valid = false; }
+    bool isValid() { return valid; }
+
+    /*! Another visible segment shares pixels with the segment */
+    bool isOverlapped( uint16_t handle ) { return (handle < flags.size()) && (flags[handle] & OVERLAPPED); }
+    /*! No later visible segment, and no other segment's overlay, shares pixels with the segment */
+    bool isOnTop( uint16_t handle ) { return (handle < flags.size()) && (flags[handle] & ON_TOP); }
+    /*! Some of the segment's pixels are under a later opaque segment */
+    bool isPartlyHidden( uint16_t handle ) { return (handle < flags.size()) && (flags[handle] & PARTLY_HIDDEN); }
+    /*! First run of pixels (strip indexes) within first..last not hidden under a later opaque segment - empty if there are none */
+    FFXSpan nextExposed( uint16_t handle, uint16_t first, uint16_t last );
+    /*! Number of intervals the strip is split into */
+    uint16_t getIntervalCount() { return bounds.size(); }
+
+  private:
+    enum SegmentFlags : uint8_t { OVERLAPPED = 1, ON_TOP = 2, PARTLY_HIDDEN = 4 };
+    bool valid = false;
+    std::vector<uint16_t> bounds = std::vector<uint16_t>();       // first pixel of each interval, ascending (bounds[0] = 0)
+    std::vector<uint16_t> topOpaque = std::vector<uint16_t>();    // handle+1 of the topmost opaque segment over each interval, 0 = none
+    std::vector<uint16_t> topVisible = std::vector<uint16_t>();   // handle+1 of the topmost visible segment over each interval
+    std::vector<uint16_t> numVisible = std::vector<uint16_t>();   // visible segments over each interval
+    std::vector<uint16_t> numOverlays = std::vector<uint16_t>();  // segments with an overlay over each interval
+    std::vector<uint8_t> flags = std::vector<uint8_t>();          // SegmentFlags, by segment handle
+    uint16_t intervalAt( uint16_t pos );
+};
+
+#endif
@@ -14,20 +14,37 @@
  *  the FFX framework uses its own brightness framework so different segments can 
  *  have different brightness levels.  This can be utilized to limit the overall Maximum
  *  brightness if needed.
+ *
+ *  Given the CLEDController returned by FastLED.addLeds(), only that strip is sent (CLEDController::showLeds()) and the 
+ *  brightness applies to it alone - so several strips can be driven as separate outputs, e.g. by FFXMultiPixelController.
  */ 
 class FFXFastLEDPixelController : public FFXPixelController {
   protected:
     StepTimer maxRateTimer = StepTimer(8);
+    bool showDeferred = false;
+    CLEDController *strip = nullptr;
 
   public:
     FFXFastLEDPixelController( CRGB *initLeds, uint16_t numLeds ) : FFXPixelController( initLeds, numLeds ) { maxRateTimer.start(); }
-    virtual void updateBrightness( uint8_t newBrightness ) { FastLED.setBrightness( newBrightness ); }
+    FFXFastLEDPixelController( CLEDController *initStrip, CRGB *initLeds, uint16_t numLeds ) : FFXFastLEDPixelController( initLeds, numLeds ) { strip = initStrip; }
+    virtual void updateBrightness( uint8_t newBrightness ) { if (!strip) { FastLED.setBrightness( newBrightness ); } }
+    /*! Minimum time between calls to FastLED.show() (default 8ms).  Sub-millisecond values need FLEX_TIMER_MICROS. */
+    void setMinShowIntervalMicros( unsigned long us ) { maxRateTimer.setIntervalMicros( us ); }
+    unsigned long getMinShowIntervalTicks() { return maxRateTimer.getIntervalTicks(); }
+    /*! Time until a show that was put off by the minimum interval can go out (ULONG_MAX if none is waiting) */
+    virtual unsigned long timeToShowTicks() override { return showDeferred ? maxRateTimer.timeRemainingTicks() : ULONG_MAX; }
+    /*! Estimated from the number of LEDs - FFX_WIRE_MICROS_PER_LED each plus FFX_WIRE_LATCH_MICROS */
+    virtual unsigned long getWireMicros() override { return (unsigned long)getNumLeds() * FFX_WIRE_MICROS_PER_LED + FFX_WIRE_LATCH_MICROS; }
     virtual void show() override { 
       if (maxRateTimer.isUp()) {
         yield();  
-        FastLED.show(); 
+        if (strip) { strip->showLeds( getBrightness() ); } else { FastLED.show(); }
         yield(); 
         maxRateTimer.step();
+        showDeferred = false;
+      }
+      else {
+        showDeferred = true;
       }
     }
 };
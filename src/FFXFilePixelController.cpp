@@ -0,0 +1,188 @@
+//
+//  FFXFilePixelController.cpp
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "FFXFilePixelController.h"
+
+#if !defined(__AVR__)
+
+#include <string.h>
+#include "FlexClock.h"
+
+static inline uint8_t *putValue( uint8_t *dest, uint64_t value, uint8_t bytes ) {
+  for (uint8_t i = 0; i < bytes; i++) { *dest++ = (uint8_t)(value >> (8*i)); }
+  return dest;
+}
+
+static inline uint64_t getValue( const uint8_t *src, uint8_t bytes ) {
+  uint64_t result = 0;
+  for (uint8_t i = 0; i < bytes; i++) { result |= ((uint64_t)src[i]) << (8*i); }
+  return result;
+}
+
+static const uint8_t frameHeaderSize = 14;    // time (8), brightness, type, payload size (4)
+
+FFXFilePixelController::FFXFilePixelController( CRGB *initLeds, uint16_t numLeds, const char *path, Format initFormat ) :
+  FFXPixelController( initLeds, numLeds ) {
+  format = initFormat;
+  // Worst case for a delta is a new run every other pixel - 4 bytes of run header per 2 pixels
+  encoded = (uint8_t *)malloc( frameHeaderSize + numLeds*sizeof(CRGB) + (numLeds/2+1)*4 );
+  if (format == DELTA) { lastFrame = (CRGB *)malloc( numLeds*sizeof(CRGB) ); }
+  out = fopen( path, "wb" );
+  if (!encoded || (format == DELTA && !lastFrame)) { close(); }
+  if (out) {
+    uint8_t header[8] = { 'F', 'F', 'X', 'F', FFX_FRAME_FILE_VERSION, format, 0, 0 };
+    putValue( &(header[6]), numLeds, 2 );
+    write( header, sizeof(header) );
+  }
+}
+
+bool FFXFilePixelController::close() {
+  bool result = false;
+  if (out) {
+    result = (fclose( out ) == 0);
+    out = nullptr;
+  }
+  if (encoded) { free( encoded ); encoded = nullptr; }
+  if (lastFrame) { free( lastFrame ); lastFrame = nullptr; }
+  return result;
+}
+
+void FFXFilePixelController::write( const uint8_t *data, size_t size ) {
+  if (out) {
+    if (fwrite( data, 1, size, out ) == size) {
+      bytesWritten += size;
+    }
+    else {
+      fclose( out );
+      out = nullptr;
+    }
+  }
+}
+
+size_t FFXFilePixelController::encodeDelta( uint8_t *dest, uint16_t first, uint16_t last ) {
+  // Runs of changed pixels - gaps of a single unchanged pixel are cheaper to write than to skip
+  CRGB *leds = getLeds();
+  uint8_t *start = dest;
+  uint32_t prevEnd = 0;                   // pixel after the last run written
+  uint32_t i = first;
+  while (i <= last) {
+    if (leds[i] == lastFrame[i]) { i++; continue; }
+    uint32_t runStart = i;
+    uint32_t runEnd = i;                  // last changed pixel in the run
+    for (uint32_t j = i+1; j <= last && j <= runEnd+2; j++) {
+      if (leds[j] != lastFrame[j]) { runEnd = j; }
+    }
+    dest = putValue( dest, runStart-prevEnd, 2 );
+    dest = putValue( dest, runEnd-runStart+1, 2 );
+    for (uint32_t j = runStart; j <= runEnd; j++) {
+      *dest++ = leds[j].r;
+      *dest++ = leds[j].g;
+      *dest++ = leds[j].b;
+      lastFrame[j] = leds[j];
+    }
+    prevEnd = runEnd+1;
+    i = runEnd+1;
+  }
+  return dest-start;
+}
+
+void FFXFilePixelController::showChanged( uint16_t firstChanged, uint16_t lastChanged ) {
+  if (!out) { return; }
+  uint16_t numLeds = getNumLeds();
+  unsigned long now = FlexClock::nowMicros();
+  if (frameCount > 0) { elapsedMicros += now - lastMicros; }
+  lastMicros = now;
+  uint8_t *payload = &(encoded[frameHeaderSize]);
+  size_t size = 0;
+  FrameType type = FRAME_RAW;
+  if (format == DELTA && frameCount > 0) {
+    if (lastChanged >= numLeds) { lastChanged = numLeds-1; }
+    size = (firstChanged <= lastChanged) ? encodeDelta( payload, firstChanged, lastChanged ) : 0;
+    type = FRAME_DELTA;
+  }
+  if (type == FRAME_RAW || size >= numLeds*sizeof(CRGB)) {
+    CRGB *leds = getLeds();
+    for (uint16_t i = 0; i < numLeds; i++) {
+      payload[i*3] = leds[i].r;
+      payload[i*3+1] = leds[i].g;
+      payload[i*3+2] = leds[i].b;
+    }
+    if (lastFrame) { memmove8( lastFrame, leds, numLeds*sizeof(CRGB) ); }
+    size = numLeds*sizeof(CRGB);
+    type = FRAME_RAW;
+  }
+  uint8_t *header = putValue( encoded, elapsedMicros, 8 );
+  *header++ = getBrightness();
+  *header++ = type;
+  putValue( header, size, 4 );
+  write( encoded, frameHeaderSize + size );
+  frameCount++;
+}
+
+bool FFXFrameFileReader::open( const char *path ) {
+  close();
+  in = fopen( path, "rb" );
+  uint8_t header[8];
+  if (!in || fread( header, 1, sizeof(header), in ) != sizeof(header) || memcmp( header, "FFXF", 4 ) != 0 ||
+      header[4] != FFX_FRAME_FILE_VERSION || header[5] > FFXFilePixelController::DELTA) {
+    close();
+    return false;
+  }
+  format = (FFXFilePixelController::Format)header[5];
+  numLeds = getValue( &(header[6]), 2 );
+  frame = (CRGB *)malloc( numLeds*sizeof(CRGB) );
+  if (!frame) { close(); return false; }
+  memset( (void *)frame, 0, numLeds*sizeof(CRGB) );
+  frameCount = 0;
+  return true;
+}
+
+void FFXFrameFileReader::close() {
+  if (in) { fclose( in ); in = nullptr; }
+  if (frame) { free( frame ); frame = nullptr; }
+  if (payload) { free( payload ); payload = nullptr; }
+  payloadSize = 0;
+  numLeds = 0;
+}
+
+bool FFXFrameFileReader::readFrame() {
+  uint8_t header[frameHeaderSize];
+  if (!in || fread( header, 1, sizeof(header), in ) != sizeof(header)) { return false; }
+  uint8_t type = header[9];
+  size_t size = getValue( &(header[10]), 4 );
+  if (size > payloadSize) {
+    uint8_t *newPayload = (uint8_t *)realloc( payload, size );
+    if (!newPayload) { return false; }
+    payload = newPayload;
+    payloadSize = size;
+  }
+  if (fread( payload, 1, size, in ) != size) { return false; }
+  if (type == FFXFilePixelController::FRAME_RAW) {
+    if (size != numLeds*sizeof(CRGB)) { return false; }
+    for (uint16_t i = 0; i < numLeds; i++) { frame[i] = CRGB( payload[i*3], payload[i*3+1], payload[i*3+2] ); }
+  }
+  else if (type == FFXFilePixelController::FRAME_DELTA) {
+    size_t pos = 0;
+    uint32_t pixel = 0;
+    while (pos + 4 <= size) {
+      pixel += getValue( &(payload[pos]), 2 );
+      uint32_t count = getValue( &(payload[pos+2]), 2 );
+      pos += 4;
+      if (pixel + count > numLeds || pos + count*3 > size) { return false; }
+      for (uint32_t i = 0; i < count; i++, pixel++, pos += 3) { frame[pixel] = CRGB( payload[pos], payload[pos+1], payload[pos+2] ); }
+    }
+    if (pos != size) { return false; }
+  }
+  else {
+    return false;
+  }
+  frameMicros = getValue( header, 8 );
+  brightness = header[8];
+  frameCount++;
+  return true;
+}
+
+#endif
@@ -0,0 +1,116 @@
+//
+//  FFXFilePixelController.h
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#ifndef FFX_FILE_PIXEL_CONTROLLER_H
+#define FFX_FILE_PIXEL_CONTROLLER_H
+
+// Needs stdio file support - not available on AVR
+#if !defined(__AVR__)
+
+#include <stdio.h>
+#include "FFXPixelController.h"
+
+#define FFX_FRAME_FILE_VERSION 1
+
+/*!
+ *  FFXFilePixelController - Pixel controller that writes each frame shown to a file instead of driving LEDs, so shows can
+ *  be rendered ahead of time (see extras/render/ffx_render), compared between library versions or rendered as fast as the
+ *  CPU allows rather than at LED wire speed.
+ *
+ *  File layout (all values little endian):
+ *
+ *    header - "FFXF", version (1 byte), format (1 byte - RAW or DELTA), number of LEDs (2 bytes)
+ *    frame  - time since the first frame (8 bytes, micros by FlexClock - so virtual time under a VirtualClock),
+ *             brightness (1 byte), frame type (1 byte), payload size (4 bytes), payload
+ *
+ *  Frame types:
+ *
+ *    FRAME_RAW   - every pixel, 3 bytes (r,g,b) each
+ *    FRAME_DELTA - pixels that changed since the previous frame, as runs of: pixels to skip (2 bytes), pixels that follow
+ *                  (2 bytes), then 3 bytes for each of those pixels.  Skipped pixels keep their previous value.
+ *
+ *  A RAW file has only FRAME_RAW frames.  A DELTA file starts with a FRAME_RAW frame and uses FRAME_DELTA after it, unless
+ *  a raw frame would be smaller.  Only the pixels in the span passed to showChanged() are compared with the last frame.
+ *
+ *  FFXFrameFileReader reads the frames back.
+ */
+class FFXFilePixelController : public FFXPixelController {
+  public:
+    enum Format : uint8_t { RAW = 0, DELTA = 1 };
+    enum FrameType : uint8_t { FRAME_RAW = 0, FRAME_DELTA = 1 };
+
+    FFXFilePixelController( CRGB *initLeds, uint16_t numLeds, const char *path, Format initFormat = DELTA );
+    virtual ~FFXFilePixelController() { close(); }
+
+    /*! False if the file could not be opened or a write failed */
+    bool isOpen() { return out != nullptr; }
+    /*! Flush and close the file - false if it wasn't open or couldn't be written.  Frames shown after this are dropped. */
+    bool close();
+    virtual void updateBrightness( uint8_t newBrightness ) override { }
+    virtual void show() override { showChanged( 0, getNumLeds()-1 ); }
+    virtual void showChanged( uint16_t firstChanged, uint16_t lastChanged ) override;
+    Format getFormat() { return format; }
+    unsigned long getFrameCount() { return frameCount; }
+    /*! Bytes written to the file so far, including headers */
+    unsigned long long getBytesWritten() { return bytesWritten; }
+
+  private:
+    FILE *out = nullptr;
+    Format format = DELTA;
+    CRGB *lastFrame = nullptr;            // DELTA - the frame last written
+    uint8_t *encoded = nullptr;           // frame being written
+    unsigned long frameCount = 0;
+    unsigned long long bytesWritten = 0;
+    unsigned long lastMicros = 0;
+    uint64_t elapsedMicros = 0;           // time of the current frame, from the first
+    void write( const uint8_t *data, size_t size );
+    size_t encodeDelta( uint8_t *dest, uint16_t first, uint16_t last );
+};
+
+/*!
+ *  FFXFrameFileReader - Reads frames written by FFXFilePixelController.
+ *
+ *  ```
+ *  FFXFrameFileReader reader;
+ *  if (reader.open( "show.ffx" )) {
+ *    while (reader.readFrame()) {
+ *      use( reader.getFrame(), reader.getNumLeds(), reader.getMicros() );
+ *    }
+ *  }
+ *  ```
+ */
+class FFXFrameFileReader {
+  public:
+    FFXFrameFileReader() { }
+    ~FFXFrameFileReader() { close(); }
+    bool open( const char *path );
+    void close();
+    /*! Read the next frame - false at the end of the file, or if it is not valid */
+    bool readFrame();
+    uint16_t getNumLeds() { return numLeds; }
+    FFXFilePixelController::Format getFormat() { return format; }
+    /*! Pixels of the frame last read */
+    const CRGB *getFrame() { return frame; }
+    /*! Time of the frame last read, from the first frame */
+    uint64_t getMicros() { return frameMicros; }
+    uint8_t getBrightness() { return brightness; }
+    unsigned long getFrameCount() { return frameCount; }
+
+  private:
+    FILE *in = nullptr;
+    uint16_t numLeds = 0;
+    FFXFilePixelController::Format format = FFXFilePixelController::RAW;
+    CRGB *frame = nullptr;
+    uint8_t *payload = nullptr;
+    size_t payloadSize = 0;
+    uint64_t frameMicros = 0;
+    uint8_t brightness = 255;
+    unsigned long frameCount = 0;
+};
+
+#endif
+
+#endif
@@ -7,15 +7,16 @@
 #include "FFXFrameProvider.h"
 #include "FFXSegment.h"
 #include "FFXController.h"
+#include "FFXTrace.h"
 
 void FFXFrameProvider::allocateBuffer(CRGB **buffer) {
    if (*buffer) { deallocateBuffer(buffer); }
-   *buffer = (CRGB *)malloc(segment->getBufferSize());
+   *buffer = segment->getController()->getBufferPool()->allocate(segment->getLength());
  }
 
 void FFXFrameProvider::deallocateBuffer(CRGB **buffer) {
    if (*buffer) {
-     free( *buffer);
+     segment->getController()->getBufferPool()->release( *buffer );
      *buffer = nullptr;
    }
 }
@@ -24,7 +25,9 @@ FFXFrameProvider::FFXFrameProvider( FFXSegment *initSegment, CRGB *fdLEDBuffer,
   segment = initSegment;
   if (fdLEDBuffer) {
     currFrameBuffer = fdLEDBuffer;
-    crossFade = true;
+    directMode = true;
+    crossFade = false;
+    crossFadePref = false;
   }
   else if (segment) {
     crossFade = true;
@@ -38,25 +41,35 @@ FFXFrameProvider::FFXFrameProvider( FFXSegment *initSegment, CRGB *fdLEDBuffer,
 
 void FFXFrameProvider::setCrossFade( boolean newValue ) {
   if (newValue != crossFade) {
+    FFX_TRACE_INSTANT( newValue ? "crossfade on" : "crossfade off", segment->getHandle() );
     if (newValue) {
+       if (directMode) { exitDirect(); }
        allocateBuffer(&nextFrameBuffer);
        memmove8( nextFrameBuffer, currFrameBuffer, segment->getBufferSize());
+       nextOffset = currOffset;
+       buffersInSync = true;
        crossFade = true;
+       redrawPending = true;
        //segment->getController()->onFXEvent( FXController::FXEventType::FX, "Segment:"+ (isPrimary() ? "Primary" : getTag()) );
     }
    else {
-     if (nextFrameBuffer) { memmove8( currFrameBuffer, nextFrameBuffer, segment->getBufferSize() ); }
+     if (nextFrameBuffer) { 
+       memmove8( currFrameBuffer, nextFrameBuffer, segment->getBufferSize() ); 
+       currOffset = nextOffset;
+     }
      deallocateBuffer(&nextFrameBuffer);
+     buffersInSync = false;
      crossFade = false;
+     redrawPending = true;
    }
    if (segment) {
-     segment->onNotify( segment->getTag(), "FrameProvider:Crossfade", String(crossFade) );
+     segment->onEvent( FFXEvent( FFXEvent::CROSSFADE, segment->getTag().c_str(), crossFade ) );
    }
   }
 }
 
 void FFXFrameProvider::checkCrossFade( FFXBase *effect ) {
-  if (effect->getInterval() <= fadeThresholdms) {
+  if (crossFadeSuspended || effect->getIntervalTicks() <= fadeThresholdTicks) {
     setCrossFade(false);    
   }
   else {
@@ -64,73 +77,312 @@ void FFXFrameProvider::checkCrossFade( FFXBase *effect ) {
   }
 }
 
+void FFXFrameProvider::enterDirect( CRGB *destLEDs, FFXBase *effect ) {
+  if (!directMode && !crossFade && destLEDs) {
+    // Leave the last frame in the display buffer (unrotated), then drop the private buffer
+    copyFrame( destLEDs, currFrameBuffer, currOffset, 0, segment->getLength() );
+    deallocateBuffer(&currFrameBuffer);
+    deallocateBuffer(&nextFrameBuffer);
+    currFrameBuffer = destLEDs;
+    currOffset = 0;
+    effect->setFrameOffset(0);
+    buffersInSync = false;
+    directMode = true;
+    redrawPending = true;
+  }
+}
+
+void FFXFrameProvider::exitDirect() {
+  if (directMode) {
+    // The display buffer holds the last frame drawn - carry it into a private buffer so the effect continues from it
+    CRGB *displayBuffer = currFrameBuffer;
+    currFrameBuffer = nullptr;
+    allocateBuffer(&currFrameBuffer);
+    memmove8( currFrameBuffer, displayBuffer, segment->getBufferSize() );
+    directMode = false;
+    redrawPending = true;
+  }
+}
+
+void FFXFrameProvider::alignBuffer( CRGB *buffer, uint16_t &bufferOffset, FFXBase *effect ) {
+  // Normally the effect continues from the offset already in the buffer.  If not (new effect, or one that 
+  // doesn't use offsets following one that did), physically rotate the contents to match - once.
+  if (effect->getFrameOffset() != bufferOffset) {
+    uint16_t numLeds = segment->getLength();
+    FFXBase::rotateBufferForwardWithWrap( buffer, buffer, numLeds, (uint16_t)(((uint32_t)bufferOffset + numLeds - effect->getFrameOffset()) % numLeds) );
+    bufferOffset = effect->getFrameOffset();
+    buffersInSync = false;
+  }
+}
+
+void FFXFrameProvider::copyFrame( CRGB *destLEDs, CRGB *buffer, uint16_t &bufferOffset, uint16_t startIdx, uint16_t count ) {
+  if (destLEDs == buffer) {
+    // writing to itself (direct mode) - all that is needed is to resolve the offset
+    if (bufferOffset) {
+      FFXBase::rotateBufferForwardWithWrap( buffer, buffer, segment->getLength(), bufferOffset );
+      bufferOffset = 0;
+      buffersInSync = false;
+    }
+  }
+  else if (bufferOffset == 0) {
+    memmove8( destLEDs, &(buffer[startIdx]), count*sizeof(CRGB) );
+  }
+  else {
+    FFXBase::copyFromRing( destLEDs, buffer, segment->getLength(), bufferOffset, startIdx, count );
+  }
+}
+
+void FFXFrameProvider::copySpan( CRGB *destLEDs, CRGB *buffer, uint16_t &bufferOffset, const FFXSpan &span ) {
+  if (destLEDs == buffer) {
+    copyFrame( destLEDs, buffer, bufferOffset, 0, segment->getLength() );
+  }
+  else if (!span.isEmpty()) {
+    copyFrame( &(destLEDs[span.first]), buffer, bufferOffset, span.first, span.length() );
+  }
+}
+
+void FFXFrameProvider::blendFrames( CRGB *destLEDs, uint16_t startIdx, uint16_t count, uint8_t amount ) {
+  if (currOffset==0 && nextOffset==0) {
+    FFXBase::alphaBlend( &(currFrameBuffer[startIdx]), &(nextFrameBuffer[startIdx]), destLEDs, count, amount, fadeMethodUp, fadeMethodDown );
+  }
+  else {
+    // blend in runs where both buffers are contiguous - at most 3 runs
+    uint16_t numLeds = segment->getLength();
+    uint16_t done = 0;
+    while (done < count) {
+      uint16_t logical = startIdx + done;
+      uint16_t a = (uint16_t)(((uint32_t)logical + numLeds - currOffset) % numLeds);
+      uint16_t b = (uint16_t)(((uint32_t)logical + numLeds - nextOffset) % numLeds);
+      uint16_t run = minimum<uint16_t>( count-done, numLeds-a, numLeds-b );
+      FFXBase::alphaBlend( &(currFrameBuffer[a]), &(nextFrameBuffer[b]), &(destLEDs[done]), run, amount, fadeMethodUp, fadeMethodDown );
+      done += run;
+    }
+  }
+}
+
 void FFXFrameProvider::updateFrame( CRGB *destLEDs, FFXBase* effect ) {
-  if (effect->isUp() || (effect->timeRemaining() <= fadeThresholdms)) {    
+  FFXSpan span = FFXSpan( 0, segment->getLength()-1 );
+  updateFrame( destLEDs, effect, span );
+}
+
+void FFXFrameProvider::updateFrame( CRGB *destLEDs, FFXBase* effect, FFXSpan &span ) {
+  FFX_TRACE_SCOPE( "FFXFrameProvider::updateFrame", segment->getHandle() );
+  advance( effect, span );
+  if (destLEDs) { render( destLEDs, span ); }
+}
+
+void FFXFrameProvider::advance( FFXBase* effect, FFXSpan &span ) {
+  // Frames are only rewritten where they can differ from what was written last time (plus whatever the caller asks for).
+  // While crossfading, output is always some mix of the current and next frames, which only differ within the last 
+  // step's dirty span - the step before that is included so the blend it left behind gets resolved.
+  FFX_TRACE_SCOPE( "FFXFrameProvider::advance", segment->getHandle() );
+  uint16_t numLeds = segment->getLength();
+  blendStep = false;
+  if (effect->isUp() || (effect->timeRemainingTicks() <= fadeThresholdTicks)) {    
     if (effect->isUp()  || !nextFrameBuffer ) {
       priorBlendAmt = 0;
       blendSteps = 0;
       step( effect );
-      memmove8( destLEDs, currFrameBuffer, segment->getBufferSize() ); 
+      if (catchUpPending) { effect->setLastUp( catchUpTicks ); }
+      addChangedSpan( span, true );
+      output = OUTPUT_CURRENT;
     }
     else {
+      addChangedSpan( span, false );
       // Not enough time to draw a blended frame - so draw a frame...until the timer expires to begin the next transition
-      if (blendSteps>0) {
-        // if a blended frame has already been drawn - then resolve to the next frame
-        memmove8( destLEDs, nextFrameBuffer, segment->getBufferSize() ); 
-      }
-      else {
-        // if nothing has been blended, keep drawning the current frame until the timer expires
-        memmove8( destLEDs, currFrameBuffer, segment->getBufferSize() ); 
-      }
+      // if a blended frame has already been drawn - then resolve to the next frame, otherwise keep drawing the current 
+      // frame until the timer expires
+      output = (blendSteps>0) ? OUTPUT_NEXT : OUTPUT_CURRENT;
       priorBlendAmt = 255;
     }
   }
+  else if (crossFade && nextFrameBuffer && effect->isUpdated() && (!blendAllowed || (blendStepSize > 1 && nextBlendAmount(effect)==priorBlendAmt))) {
+    // Over the controller's frame budget (or not a whole step since the last blend) - keep showing the last blend, nothing changes
+    if (redrawPending) {
+      span.add( 0, numLeds-1 );
+      redrawPending = false;
+    }
+    outputBlendAmt = priorBlendAmt;
+    output = (priorBlendAmt > 0) ? OUTPUT_BLEND : OUTPUT_CURRENT;
+    if (!blendAllowed) { droppedBlendSteps++; }
+  }
   else {
+    addChangedSpan( span, false );
     // if crossFading and the nextFrameBuffer is allocated...
     if ((crossFade && nextFrameBuffer && effect->isUpdated())) {
-        // Calculate the crossfade blend to the next frame
-        // Account for changes to updateInterval - don't revert back to frames with 
-        // lower blend value (in cases where the interval is increased), just wait for it to catch up...
-        uint8_t blendAmt = maximum<uint8_t>(fixed_map(effect->timeSinceTriggered(), 1, effect->getCurrInterval(), 1, 255), priorBlendAmt);
-        // Blend between current frame and next frame
-        FFXBase::alphaBlend( currFrameBuffer, nextFrameBuffer, destLEDs, segment->getLength(), blendAmt, fadeMethodUp, fadeMethodDown );
+        outputBlendAmt = nextBlendAmount( effect );
+        output = OUTPUT_BLEND;
+        blendStep = true;
         blendSteps += 1;
-        priorBlendAmt = blendAmt;
+        priorBlendAmt = outputBlendAmt;
     }
-    else if ((currFrameBuffer != destLEDs) && destLEDs) {
-      memmove8(destLEDs, currFrameBuffer, segment->getBufferSize() );
+    else {
+      output = OUTPUT_CURRENT;
     }
   }
+  catchUpPending = false;
+  span = span.clip( 0, numLeds-1 );
+}
+
+void FFXFrameProvider::catchUp( FFXBase* effect ) {
+  // Follows advance() - without a next frame buffer the effect is stepped once it is within the crossfade threshold of its
+  // deadline (so it runs that much faster than its interval), with one it is stepped when its timer is up
+  unsigned long interval = effect->getIntervalTicks();
+  unsigned long lead = nextFrameBuffer ? 0 : fadeThresholdTicks;
+  if (!effect->isStarted() || interval == 0 || effect->timeRemainingTicks() > lead) { return; }
+  // An interval within the threshold steps the effect on every update, however often that is - count one per interval
+  unsigned long cadence = (interval > lead) ? interval - lead : interval;
+  unsigned long due = effect->nextUp() - lead;
+  unsigned long missed = (GET_TIME_TICKS - due) / cadence;
+  uint16_t offset = effect->getFrameOffset();
+  effect->catchUp( missed );
+  if (effect->getFrameOffset() != offset) {
+    // The effect rotated its frame on - take the new offset as a rotation of the frame it continues from, rather than 
+    // letting alignBuffer() move the pixels back to where they were
+    uint16_t numLeds = segment->getLength();
+    uint16_t delta = (effect->getFrameOffset() + numLeds - offset) % numLeds;
+    if (crossFade && nextFrameBuffer) { nextOffset = (nextOffset + delta) % numLeds; }
+    else { currOffset = (currOffset + delta) % numLeds; }
+  }
+  catchUpTicks = due + missed*cadence;
+  catchUpPending = true;
+}
+
+uint8_t FFXFrameProvider::nextBlendAmount( FFXBase *effect ) {
+  // Calculate the crossfade blend to the next frame
+  // Account for changes to updateInterval - don't revert back to frames with 
+  // lower blend value (in cases where the interval is increased), just wait for it to catch up...
+  uint8_t result = maximum<uint8_t>(fixed_map_ticks(effect->timeSinceTriggeredTicks(), 1, effect->getCurrIntervalTicks(), 1, 255), priorBlendAmt);
+  if (blendStepSize > 1) {
+    // whole steps on from the last blend only
+    result = priorBlendAmt + ((result - priorBlendAmt) / blendStepSize) * blendStepSize;
+  }
+  return result;
+}
+
+unsigned long FFXFrameProvider::timeToNextFrameTicks( FFXBase *effect ) {
+  // Follows advance() - without a next frame buffer the effect is stepped once it is within the crossfade threshold,
+  // with one the output switches to the next frame then and the effect is stepped when its timer is up
+  unsigned long remaining = effect->timeRemainingTicks();
+  if (remaining <= fadeThresholdTicks) { return nextFrameBuffer ? remaining : 0; }
+  unsigned long result = remaining - fadeThresholdTicks;
+  // A blend of two identical frames doesn't change anything
+  if (wantsBlend( effect ) && effect->isUpdated() && priorBlendAmt < 255 && !(buffersInSync && currOffset == nextOffset)) {
+    long target = minimum<long>( (long)priorBlendAmt + blendStepSize, 255 );
+    unsigned long until = fixed_map_ticks_until( effect->timeSinceTriggeredTicks(), 1, effect->getCurrIntervalTicks(), 1, 255, target );
+    result = minimum( result, until );
+  }
+  return result;
+}
+
+void FFXFrameProvider::render( CRGB *destLEDs, const FFXSpan &span ) {
+  switch (output) {
+    case OUTPUT_NEXT : { copySpan( destLEDs, nextFrameBuffer, nextOffset, span ); break; }
+    case OUTPUT_BLEND : { 
+      // Blend between current frame and next frame
+      if (!span.isEmpty()) { blendFrames( &(destLEDs[span.first]), span.first, span.length(), outputBlendAmt ); }
+      break; 
+    }
+    default : { copySpan( destLEDs, currFrameBuffer, currOffset, span ); }
+  }
+}
+
+FFXFrameSource FFXFrameProvider::getOutputSource() {
+  switch (output) {
+    case OUTPUT_NEXT : { return FFXFrameSource( nextFrameBuffer, nextOffset ); }
+    case OUTPUT_BLEND : { return FFXFrameSource( currFrameBuffer, currOffset, nextFrameBuffer, nextOffset, outputBlendAmt, fadeMethodUp, fadeMethodDown ); }
+    default : { return FFXFrameSource( currFrameBuffer, currOffset ); }
+  }
+}
+
+void FFXFrameProvider::addChangedSpan( FFXSpan &span, bool stepped ) {
+  uint16_t numLeds = segment->getLength();
+  if (redrawPending) {
+    span.add( 0, numLeds-1 );
+    redrawPending = false;
+  }
+  else if (crossFade) {
+    span.add( lastStepSpan );
+    span.add( prevStepSpan );
+  }
+  else if (stepped) {
+    span.add( lastStepSpan );
+  }
+  span = span.clip( 0, numLeds-1 );
 }
 
 void FFXFrameProvider::getLastFrame(CRGB *destLEDs, uint16_t startIdx, uint16_t endIdx ) {
+  uint16_t count = endIdx-startIdx+1;
   if (!crossFade && currFrameBuffer) {
-    memmove8( destLEDs, &(currFrameBuffer[startIdx]), sizeof(CRGB)*(endIdx-startIdx+1) );
+    copyFrame( destLEDs, currFrameBuffer, currOffset, startIdx, count );
   }
   else {
     if ((priorBlendAmt == 0)||((!nextFrameBuffer)&&currFrameBuffer)) {
-      memmove8( destLEDs, &(currFrameBuffer[startIdx]), sizeof(CRGB)*(endIdx-startIdx+1) );
+      copyFrame( destLEDs, currFrameBuffer, currOffset, startIdx, count );
     }
     else if ((priorBlendAmt == 255)&&(nextFrameBuffer)) {
-      memmove8( destLEDs, &(nextFrameBuffer[startIdx]), sizeof(CRGB)*(endIdx-startIdx+1) );
+      copyFrame( destLEDs, nextFrameBuffer, nextOffset, startIdx, count );
     }
     else if (currFrameBuffer && nextFrameBuffer) {
-      FFXBase::alphaBlend( &(currFrameBuffer[startIdx]), &(nextFrameBuffer[startIdx]), destLEDs, (endIdx-startIdx+1), priorBlendAmt, fadeMethodUp, fadeMethodDown );
+      blendFrames( destLEDs, startIdx, count, priorBlendAmt );
     }
   }
 }
 
 void FFXFrameProvider::step( FFXBase* effect ) {
+  FFX_TRACE_SCOPE( "FFXFrameProvider::step", segment->getHandle() );
+  FFX_STAGE_START( stepStart );
+  bool carried = true;        // false if the buffer being drawn does not start out holding the current frame
   if (crossFade) {
       if (nextFrameBuffer) {
-        memmove8(currFrameBuffer,nextFrameBuffer, segment->getBufferSize());
+        // The frame we were fading to becomes the current frame - swap, don't copy
+        CRGB *tempBuffer = currFrameBuffer;
+        currFrameBuffer = nextFrameBuffer;
+        nextFrameBuffer = tempBuffer;
+        uint16_t tempOffset = currOffset;
+        currOffset = nextOffset;
+        nextOffset = tempOffset;
+        // Incremental effects draw on top of the current frame, so it has to be carried into the buffer being drawn
+        if (!effect->isFullFrameRedraw() || effect->isFrozen()) {
+          if (buffersInSync) {
+            nextOffset = currOffset;
+          }
+          else {
+            memmove8(nextFrameBuffer, currFrameBuffer, segment->getBufferSize());
+            nextOffset = currOffset;
+            buffersInSync = true;
+          }
         }
+        else {
+          buffersInSync = false;
+          carried = false;
+        }
+      }
       else {
         allocateBuffer(&nextFrameBuffer);
+        buffersInSync = false;
+        carried = false;
     }
+    alignBuffer( nextFrameBuffer, nextOffset, effect );
     effect->update( nextFrameBuffer );
+    nextOffset = effect->getFrameOffset();
+    buffersInSync = buffersInSync && !effect->isFrameDataChanged();
   }
   else {
+    alignBuffer( currFrameBuffer, currOffset, effect );
     effect->update( currFrameBuffer );
+    currOffset = effect->getFrameOffset();
+    if (directMode && currOffset) {
+      // The display buffer can't hold a logical offset - rotate in place and let the effect continue from offset 0
+      FFXBase::rotateBufferForwardWithWrap( currFrameBuffer, currFrameBuffer, segment->getLength(), currOffset );
+      effect->setFrameOffset(0);
+      currOffset = 0;
+    }
   }
+  prevStepSpan = lastStepSpan;
+  lastStepSpan = carried ? effect->getDirtySpan() : FFXSpan( 0, segment->getLength()-1 );
+#ifdef FFX_INSTRUMENT
+  // Overlay steps are counted by the segment, as part of OVERLAY
+  if (segment->getFrameProvider() == this) { FFX_STAGE_END( segment->getStats(), FFXRenderStats::EFFECT, stepStart, lastStepSpan.length()*sizeof(CRGB) ); }
+#endif
 }
@@ -22,14 +22,37 @@ template<typename T>
 inline T minimum( T a, T b, T c ) { return minimum( minimum(a,b), c ) ; }
 
 class FFXSegment;
+
+/*!
+ * FFXFrameSource - Describes where a frame provider's output comes from, so it can be read one pixel at a time (see 
+ * FFXCompositor) rather than copied out first.  Output is either a single buffer (b == nullptr) or buffer a crossfaded 
+ * with buffer b by amount, using the provider's fade methods.  Each buffer is stored with its frame offset (see FFXBase).
+ */
+struct FFXFrameSource {
+  CRGB *a = nullptr;
+  uint16_t aOffset = 0;
+  CRGB *b = nullptr;
+  uint16_t bOffset = 0;
+  uint8_t amount = 0;
+  FFXBase::FadeType fadeUp = FFXBase::FadeType::LINEAR;
+  FFXBase::FadeType fadeDown = FFXBase::FadeType::LINEAR;
+  FFXFrameSource() { }
+  FFXFrameSource( CRGB *initA, uint16_t initAOffset ) : a(initA), aOffset(initAOffset) { }
+  FFXFrameSource( CRGB *initA, uint16_t initAOffset, CRGB *initB, uint16_t initBOffset, uint8_t initAmount, 
+                  FFXBase::FadeType initFadeUp, FFXBase::FadeType initFadeDown ) : 
+    a(initA), aOffset(initAOffset), b(initB), bOffset(initBOffset), amount(initAmount), fadeUp(initFadeUp), fadeDown(initFadeDown) { }
+};
+
 /*!
  * FFXFrameProvider - Controls the fetching of frames that get displayed by the FXController.  There are several "modes" of operation
  * that can be utilized:
  *
- *   Direct mode - (Crossfade=false AND constructed with FASTLed framebuffer passed in the constructor)
+ *   Direct mode - (Crossfade=false AND constructed with FASTLed framebuffer passed in the constructor, or switched via enterDirect())
  *
  *       This is the most efficient usage.  It uses a single buffer (CRGB[]) that is passed in the constructor.
- *       This is typically the array of CRGB used by fastLED for display and allocates no additional heap.
+ *       This is typically the array of CRGB used by fastLED for display and allocates no additional heap.  FFXSegment
+ *       switches to this mode on its own when nothing else needs the segment's private copy of the frame (see 
+ *       FFXSegment::canRenderDirect()).  exitDirect() (or enabling crossfade) goes back to a private buffer.
  *
  *   Indirect modes - Indirect modes use independent buffer(s) where pixel data is written and maintained.  This means that each frame is calculated independently from
  *   what is in the FastLED display buffer.  This can be useful for overlaying or mixing effects.
@@ -39,6 +62,23 @@ class FFXSegment;
  *       with crossfade - Uses 2 buffers to smooth animated effects.  A second buffer is used to "smooth" transitions from frame to frame - uses multiple 
  *       cycles to blend from the current frame to the next one.  The number of blend steps between frames depends on the available time between frames and 
  *       the FrameViewController will fill as many steps as it can in that time.  
+ *
+ *   Advancing a frame swaps the current and next buffers rather than copying.  The previous frame is only copied forward
+ *   when the effect draws incrementally on top of it (see FFXBase::isFullFrameRedraw()) and the two buffers differ.
+ *
+ *   Only the part of the frame that changed is written out to the display buffer on each update - see FFXBase::getDirtySpan().
+ *
+ *   updateFrame() is advance() followed by render().  FFXSegment calls advance() on its own and reads the result through 
+ *   getOutputSource() so the frame, dimming and opacity can be drawn in one pass (see FFXCompositor).
+ *
+ *   Each buffer keeps the frame offset (see FFXBase) its contents were written with, so effects that rotate by offset never 
+ *   move their pixel data.  The offset is resolved only when the frame is copied or blended out to the display buffer.
+ *
+ *   Blend budget - the time taken to draw each crossfade step is measured (getBlendCost()).  When the controller has a frame 
+ *   budget (see FFXController::setFrameBudget()) it decides before each update which providers may draw a new blend step, 
+ *   highest getBlendPriority() first.  A provider that isn't allowed keeps showing its last blend and counts the step as 
+ *   dropped (getDroppedBlendSteps()).  setBlendStepSize() makes crossfades coarser - a new step is only drawn once the blend 
+ *   has moved on by at least that much, so there are at most 255/size steps per frame.  Both are used by FFXGovernor.
  */
 class FFXFrameProvider {
 
@@ -48,7 +88,7 @@ class FFXFrameProvider {
     FFXFrameProvider( FFXSegment *initSegment ) : FFXFrameProvider( initSegment,  nullptr ) { };
 
     ~FFXFrameProvider() {
-      if (currFrameBuffer) { deallocateBuffer( &currFrameBuffer ); } 
+      if (currFrameBuffer && !directMode) { deallocateBuffer( &currFrameBuffer ); } 
       if (nextFrameBuffer) { deallocateBuffer( &nextFrameBuffer ); }
     }
 
@@ -59,21 +99,74 @@ class FFXFrameProvider {
     bool getCrossFadePref() { return crossFadePref; }
     bool setCrossFadePref( boolean newValue ) { crossFadePref = newValue; setCrossFade(crossFadePref); return crossFadePref; }
     void checkCrossFade( FFXBase *effect );
+    /*! Turn crossfade off regardless of the preference (until called again with false) */
+    void setCrossFadeSuspended( bool newValue, FFXBase *effect ) { if (newValue != crossFadeSuspended) { crossFadeSuspended = newValue; if (effect) { checkCrossFade( effect ); } } }
+    bool isCrossFadeSuspended() { return crossFadeSuspended; }
+    /*! True when frames are drawn straight into the display buffer - no private buffer and no copy */
+    bool isDirect() { return directMode; }
+    /*! Switch to direct mode, drawing into destLEDs from now on.  Ignored while crossfading. */
+    void enterDirect( CRGB *destLEDs, FFXBase *effect );
+    void exitDirect();
     FFXBase::FadeType getFadeMethodUp() { return fadeMethodUp; }    
     FFXBase::FadeType getFadeMethodDown() { return fadeMethodDown; }
     void setFadeMethod( FFXBase::FadeType newValueUp, FFXBase::FadeType newValueDown ) { 
       if (newValueDown != fadeMethodDown) fadeMethodDown = newValueDown; 
       if (newValueUp != fadeMethodUp) fadeMethodUp = newValueUp;
     }
-    unsigned long getCrossFadeThreshold() { return fadeThresholdms; }
+    unsigned long getCrossFadeThreshold() { return TICKS_TO_MS(fadeThresholdTicks); }
+    /*! Minimum time remaining before the next frame for a crossfade step to still be drawn.  Only values in whole ms are
+     *  meaningful unless the timers are built with FLEX_TIMER_MICROS. */
+    void setCrossFadeThresholdMicros( unsigned long newValue ) { fadeThresholdTicks = US_TO_TICKS(newValue); }
     uint8_t getLastBlendSteps() { return blendSteps; }
     uint8_t getLastBlendAmount() { return priorBlendAmt; }
+    /*! True if the next advance() would draw a crossfade step (if allowed) rather than a new frame */
+    bool wantsBlend( FFXBase *effect ) { return crossFade && nextFrameBuffer && !effect->isUp() && (effect->timeRemainingTicks() > fadeThresholdTicks); }
+    /*! Ticks until advance() would do something different - step the effect, draw a new crossfade step or switch to the 
+     *  next frame (0 = now) */
+    unsigned long timeToNextFrameTicks( FFXBase *effect );
+    /*! True if the last advance() drew a new crossfade step */
+    bool isBlendStep() { return blendStep; }
+    /*! Average time (micros) to draw a crossfade step - see recordBlendCost() */
+    unsigned long getBlendCost() { return blendCost; }
+    /*! Called with the time taken to write out a crossfade step */
+    void recordBlendCost( unsigned long micros ) { blendCost = (blendCost==0) ? micros : (blendCost*3 + micros) / 4; }
+    uint8_t getBlendPriority() { return blendPriority; }
+    void setBlendPriority( uint8_t newValue ) { blendPriority = newValue; }
+    /*! Set by the controller - when false, advance() holds the last blend instead of drawing a new step */
+    void setBlendAllowed( bool newValue ) { blendAllowed = newValue; blendWait = (newValue ? 0 : ((blendWait < 255) ? blendWait+1 : 255)); }
+    bool isBlendAllowed() { return blendAllowed; }
+    /*! Number of updates in a row this provider has not been allowed to blend */
+    uint8_t getBlendWait() { return blendWait; }
+    unsigned long getDroppedBlendSteps() { return droppedBlendSteps; }
+    /*! Smallest change in blend amount drawn as a new crossfade step (1 = every update, the default) */
+    void setBlendStepSize( uint8_t newValue ) { blendStepSize = maximum<uint8_t>( newValue, 1 ); }
+    uint8_t getBlendStepSize() { return blendStepSize; }
     void updateFrame( CRGB *destLEDs, FFXBase* effect );
+    /*! Write the frame into destLEDs only where it changed since the last call, plus the pixels already in span (segment 
+     *  indexes - e.g. where something else drew over the frame).  On return span holds every pixel that was written. */
+    void updateFrame( CRGB *destLEDs, FFXBase* effect, FFXSpan &span );
     void updateFrame( FFXBase* effect ) { updateFrame( currFrameBuffer, effect ); }
+    /*! Step or crossfade the effect as needed and work out this update's output, without writing it anywhere.  span as 
+     *  for updateFrame(). */
+    void advance( FFXBase* effect, FFXSpan &span );
+    /*! Move an effect that hasn't been advanced for a while (e.g. its segment was hidden) on by the steps advance() would 
+     *  have taken in the meantime.  The last of them is taken by the next advance(), which dates it back to when it was due, 
+     *  so the effect's timer carries on as if it had never stopped. */
+    void catchUp( FFXBase* effect );
+    /*! Write the output of the last advance() into destLEDs, for the pixels in span */
+    void render( CRGB *destLEDs, const FFXSpan &span );
+    /*! Buffers (and blend) that make up the output of the last advance() */
+    FFXFrameSource getOutputSource();
     void getLastFrame(CRGB *destLEDs, uint16_t startIdx, uint16_t endIdx);
    
    protected:
     void step( FFXBase* effect );    
+    void alignBuffer( CRGB *buffer, uint16_t &bufferOffset, FFXBase *effect );
+    void copyFrame( CRGB *destLEDs, CRGB *buffer, uint16_t &bufferOffset, uint16_t startIdx, uint16_t count );
+    void copySpan( CRGB *destLEDs, CRGB *buffer, uint16_t &bufferOffset, const FFXSpan &span );
+    void addChangedSpan( FFXSpan &span, bool stepped );
+    void blendFrames( CRGB *destLEDs, uint16_t startIdx, uint16_t count, uint8_t amount );
+    uint8_t nextBlendAmount( FFXBase *effect );
     CRGB *getNextFrameBuffer() { return nextFrameBuffer; }     
     CRGB *getCurrentFrameBuffer() { return currFrameBuffer; }
   
@@ -81,13 +174,33 @@ class FFXFrameProvider {
     FFXSegment *segment;
     CRGB *currFrameBuffer=nullptr;            // buffer containing the current frame - during crossfading this keeps the original frame
     CRGB *nextFrameBuffer=nullptr;            // buffer containing the next frame - this is the frame we are cross-fading to
+    uint16_t currOffset = 0;                  // frame offset (ring rotation) of the contents of currFrameBuffer
+    uint16_t nextOffset = 0;                  // frame offset of the contents of nextFrameBuffer
+    bool buffersInSync = false;               // true when curr and next hold the same pixel data (offsets may differ)
+    bool directMode = false;                  // currFrameBuffer is the display buffer (not owned)
+    FFXSpan lastStepSpan = FFXSpan();         // pixels changed by the last effect step (dirty span)
+    FFXSpan prevStepSpan = FFXSpan();         // ...and by the step before that
+    bool redrawPending = true;                // write the whole frame on the next update (mode changed)
     bool crossFade = true;
     bool crossFadePref = true;
-    unsigned long fadeThresholdms = 6;        // Minimum number of ms remaining between cycle steps where there is still time to draw a cross faded frame
+    bool crossFadeSuspended = false;
+    unsigned long fadeThresholdTicks = MS_TO_TICKS(6);  // Minimum time (ticks) remaining between cycle steps where there is still time to draw a cross faded frame
     FFXBase::FadeType fadeMethodUp = FFXBase::FadeType::LINEAR;
     FFXBase::FadeType fadeMethodDown = FFXBase::FadeType::LINEAR;
     uint8_t priorBlendAmt = 0;             // keep track of the last crossfade blend amount used...when the interval is increased mid-frame, we don't want to jump back to an "earlier" frame.
     uint16_t blendSteps = 0;
+    enum OutputType { OUTPUT_CURRENT, OUTPUT_NEXT, OUTPUT_BLEND };
+    OutputType output = OUTPUT_CURRENT;    // what the last advance() produced - current frame, next frame or a blend of both
+    uint8_t outputBlendAmt = 0;
+    bool blendStep = false;                // last advance() drew a new crossfade step
+    bool blendAllowed = true;
+    uint8_t blendWait = 0;
+    uint8_t blendPriority = 128;
+    unsigned long blendCost = 0;           // micros, running average
+    unsigned long droppedBlendSteps = 0;
+    uint8_t blendStepSize = 1;
+    bool catchUpPending = false;           // the next step is the last one catchUp() counted...
+    unsigned long catchUpTicks = 0;        // ...which was due at this time
     void allocateBuffer(CRGB **buffer);
     void deallocateBuffer(CRGB **buffer);
 };
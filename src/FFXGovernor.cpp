@@ -0,0 +1,90 @@
+//
+//  FFXGovernor.cpp
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "FFXGovernor.h"
+
+void FFXGovernor::setTargetFPS( uint16_t fps ) {
+  targetFPS = fps;
+  level = FULL_QUALITY;
+  windowStarted = false;
+  load = 0;
+  frameCost = 0;
+  overWindows = 0;
+  underWindows = 0;
+  restoreWindows = 4;
+  lastChangeRestored = false;
+}
+
+bool FFXGovernor::record( unsigned long now, unsigned long updateMicros, bool shown ) {
+  if (!targetFPS) { return false; }
+  if (!windowStarted) {
+    windowStart = now - updateMicros;
+    windowFrames = 0;
+    windowFrameMicros = 0;
+    windowStarted = true;
+  }
+  if (shown) {
+    windowFrames++;
+    windowFrameMicros += updateMicros;
+  }
+  if (now - windowStart < FFX_GOVERNOR_WINDOW_MICROS) { return false; }
+  uint8_t oldLevel = level;
+  endWindow( now - windowStart );
+  windowStart = now;
+  windowFrames = 0;
+  windowFrameMicros = 0;
+  return level != oldLevel;
+}
+
+void FFXGovernor::endWindow( unsigned long elapsed ) {
+  frameCost = windowFrames ? windowFrameMicros / windowFrames : 0;
+  unsigned long rate = (unsigned long)(((uint64_t)windowFrames * 1000000UL) / elapsed);
+  if (rate > targetFPS) { rate = targetFPS; }
+  uint64_t percent = ((uint64_t)frameCost * rate) / 10000UL;
+  load = (percent > 0xFFFF) ? 0xFFFF : percent;
+  if (load > maxLoad) {
+    underWindows = 0;
+    if (++overWindows >= 2 && level < MAX_LEVEL) {
+      // cut back straight after a restore - wait longer before the next one
+      if (lastChangeRestored && restoreWindows < 64) { restoreWindows *= 2; }
+      level++;
+      overWindows = 0;
+      lastChangeRestored = false;
+    }
+  }
+  else if (load < restoreLoad) {
+    overWindows = 0;
+    if (++underWindows >= restoreWindows && level > FULL_QUALITY) {
+      level--;
+      underWindows = 0;
+      lastChangeRestored = true;
+      if (level == FULL_QUALITY) { restoreWindows = 4; }
+    }
+  }
+  else {
+    overWindows = 0;
+    underWindows = 0;
+  }
+}
+
+unsigned long FFXGovernor::getMinShowMicros() {
+  switch (level) {
+    case HALF_SHOW_RATE : { return getFrameMicros()*2; }
+    case QUARTER_SHOW_RATE : { return getFrameMicros()*4; }
+    default : { return 0; }
+  }
+}
+
+const char *FFXGovernor::getLevelName( uint8_t level ) {
+  switch (level) {
+    case FULL_QUALITY : { return "FullQuality"; }
+    case COARSE_BLENDS : { return "CoarseBlends"; }
+    case NO_LOW_PRIORITY_CROSSFADE : { return "NoLowPriorityCrossfade"; }
+    case HALF_SHOW_RATE : { return "HalfShowRate"; }
+    case QUARTER_SHOW_RATE : { return "QuarterShowRate"; }
+    default : { return "Unknown"; }
+  }
+}
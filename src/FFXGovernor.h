@@ -0,0 +1,92 @@
+//
+//  FFXGovernor.h
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#ifndef FFX_GOVERNOR_H
+#define FFX_GOVERNOR_H
+
+#include "FFXBase.h"
+
+#ifndef FFX_GOVERNOR_WINDOW_MICROS
+#define FFX_GOVERNOR_WINDOW_MICROS 250000UL    // load is measured over windows of this length
+#endif
+#ifndef FFX_GOVERNOR_BLEND_STEP
+#define FFX_GOVERNOR_BLEND_STEP 32             // blend step size used at COARSE_BLENDS and above (at most 8 steps per frame)
+#endif
+
+/*!
+ * FFXGovernor - Decides how far to cut back on quality when FFXController can't keep up with a target frame rate (see
+ * FFXController::setTargetFPS()).  The controller passes it the duration of each update() - including the time taken to
+ * send the frame to the LEDs (see FFXPixelController::getWireMicros()) - and whether a frame was shown.  Over each window
+ * (FFX_GOVERNOR_WINDOW_MICROS) it works out the load - the share of the time available at the target rate that is spent
+ * producing frames:
+ *
+ *    load = average time per frame shown * min( frames shown per second, target fps )
+ *
+ * Two windows in a row over the maximum load (default 90%) move to the next level, and enough windows in a row under the
+ * restore load (default 50%) move back one:
+ *
+ *    FULL_QUALITY               - nothing changed
+ *    COARSE_BLENDS              - crossfades draw a new step only every FFX_GOVERNOR_BLEND_STEP of blend
+ *    NO_LOW_PRIORITY_CROSSFADE  - ...and segments with a blend priority at or below getLowPriority() stop crossfading
+ *    HALF_SHOW_RATE             - ...and frames are shown at no more than half the target rate
+ *    QUARTER_SHOW_RATE          - ...or a quarter of it
+ *
+ * If quality has to be cut again right after being restored, the governor waits twice as long before the next restore
+ * (up to 64 windows), so it settles rather than switching back and forth.
+ */
+class FFXGovernor {
+  public:
+    enum Level : uint8_t { FULL_QUALITY, COARSE_BLENDS, NO_LOW_PRIORITY_CROSSFADE, HALF_SHOW_RATE, QUARTER_SHOW_RATE };
+    static const uint8_t MAX_LEVEL = QUARTER_SHOW_RATE;
+
+    FFXGovernor() { }
+
+    /*! 0 = off (FULL_QUALITY) */
+    void setTargetFPS( uint16_t fps );
+    uint16_t getTargetFPS() { return targetFPS; }
+    bool isEnabled() { return targetFPS > 0; }
+    /*! Time available for each frame at the target rate (micros) */
+    unsigned long getFrameMicros() { return targetFPS ? 1000000UL / targetFPS : 0; }
+    void setMaxLoad( uint8_t percent ) { maxLoad = percent; }
+    uint8_t getMaxLoad() { return maxLoad; }
+    void setRestoreLoad( uint8_t percent ) { restoreLoad = percent; }
+    uint8_t getRestoreLoad() { return restoreLoad; }
+    /*! Segments with a blend priority at or below this stop crossfading at NO_LOW_PRIORITY_CROSSFADE (default 128, the
+     *  default priority - raise a segment's priority above it to keep its crossfade) */
+    void setLowPriority( uint8_t newValue ) { lowPriority = newValue; }
+    uint8_t getLowPriority() { return lowPriority; }
+
+    /*! Record one update() taking updateMicros (now = micros() at the end of it).  Returns true if the level changed. */
+    bool record( unsigned long now, unsigned long updateMicros, bool shown );
+    uint8_t getLevel() { return level; }
+    /*! Load (%) over the last full window */
+    uint16_t getLoad() { return load; }
+    /*! Average time per frame shown over the last full window (micros) */
+    unsigned long getFrameCost() { return frameCost; }
+    /*! Minimum time between frames shown at the current level (micros) - 0 = no limit */
+    unsigned long getMinShowMicros();
+    static const char *getLevelName( uint8_t level );
+
+  private:
+    uint16_t targetFPS = 0;
+    uint8_t maxLoad = 90;
+    uint8_t restoreLoad = 50;
+    uint8_t lowPriority = 128;
+    uint8_t level = FULL_QUALITY;
+    bool windowStarted = false;
+    unsigned long windowStart = 0;
+    unsigned long windowFrames = 0;
+    unsigned long windowFrameMicros = 0;
+    uint16_t load = 0;
+    unsigned long frameCost = 0;
+    uint8_t overWindows = 0;
+    uint8_t underWindows = 0;
+    uint8_t restoreWindows = 4;             // windows under the restore load needed to move back a level
+    bool lastChangeRestored = false;
+    void endWindow( unsigned long elapsed );
+};
+
+#endif
@@ -0,0 +1,107 @@
+//
+//  FFXMultiPixelController.cpp
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "FFXMultiPixelController.h"
+#include "FFXFrameProvider.h"
+
+FFXMultiPixelController::FFXMultiPixelController( CRGB *initLeds, uint16_t numLeds ) : FFXPixelController( initLeds, numLeds ) {
+  if (!initLeds) {
+    CRGB *leds = (CRGB *)malloc( numLeds*sizeof(CRGB) );
+    if (leds) { memset( (void *)leds, 0, numLeds*sizeof(CRGB) ); }
+    setLeds( leds );
+    ownLeds = true;
+  }
+}
+
+FFXMultiPixelController::~FFXMultiPixelController() {
+  for (Output &out : outputs) { delete out.sender; }
+  if (ownLeds) { free( getLeds() ); }
+}
+
+int FFXMultiPixelController::addOutput( FFXPixelController *output, uint16_t first, bool async ) {
+  if (!output || (uint32_t)first + output->getNumLeds() > getNumLeds()) { return -1; }
+  Output out;
+  out.output = output;
+  out.sender = output;
+#if FFX_ASYNC_THREADS
+  // An output whose LED array is part of ours can't be sent in the background - we would be drawing into it as it went out
+  bool shared = (output->getLeds() >= getLeds() && output->getLeds() < getLeds()+getNumLeds());
+  if (async && !shared) { out.sender = new FFXAsyncPixelController( output ); }
+#endif
+  out.first = first;
+  out.pending = FFXSpan( 0, output->getNumLeds()-1 );
+  outputs.push_back( out );
+  return outputs.size()-1;
+}
+
+void FFXMultiPixelController::showOutput( Output &out, bool all ) {
+  FFXPixelController *sender = out.sender;
+  uint16_t size = sender->getNumLeds();
+  CRGB *slice = &(getLeds()[out.first]);
+  if (sender->getLeds() != slice) { memmove8( sender->getLeds(), slice, size*sizeof(CRGB) ); }
+  if (sender->getBrightness() != getBrightness()) {
+    // setBrightness() shows the whole output
+    sender->setBrightness( getBrightness() );
+  }
+  else if (all) {
+    sender->show();
+  }
+  else {
+    sender->showChanged( out.pending.first, out.pending.last );
+  }
+  // keep the changes if the output put the show off (see FFXPixelController::timeToShowTicks())
+  if (!sender->isShowComplete() || sender->timeToShowTicks() == ULONG_MAX) { out.pending.clear(); }
+}
+
+void FFXMultiPixelController::showChanged( uint16_t firstChanged, uint16_t lastChanged ) {
+  if (!getLeds()) { return; }
+  FFXSpan changed = FFXSpan( firstChanged, lastChanged ).clip( 0, getNumLeds()-1 );
+  // nothing changed (e.g. a minimum refresh) - every output is still shown, with whatever it has pending
+  bool refresh = changed.isEmpty();
+  bool all = (changed.first == 0 && changed.last == getNumLeds()-1);
+  // hand every output its frame before waiting on any of them, so they go out together
+  for (Output &out : outputs) {
+    uint16_t last = out.first + out.sender->getNumLeds() - 1;
+    FFXSpan local = changed.clip( out.first, last );
+    if (all) { out.pending = FFXSpan( 0, out.sender->getNumLeds()-1 ); }
+    else if (!local.isEmpty()) { out.pending.add( local.shift( -(int32_t)out.first ) ); }
+    if (refresh || !out.pending.isEmpty()) { showOutput( out, all ); }
+  }
+}
+
+bool FFXMultiPixelController::isShowComplete() {
+  for (Output &out : outputs) { if (!out.sender->isShowComplete()) { return false; } }
+  return true;
+}
+
+void FFXMultiPixelController::waitForShow() {
+  for (Output &out : outputs) { out.sender->waitForShow(); }
+}
+
+unsigned long FFXMultiPixelController::timeToShowTicks() {
+  // still sending - until the last output is done, otherwise until the first output with a show put off can go
+  unsigned long busy = 0;
+  unsigned long deferred = ULONG_MAX;
+  for (Output &out : outputs) {
+    unsigned long ticks = out.sender->timeToShowTicks();
+    if (!out.sender->isShowComplete()) { busy = maximum( busy, ticks ); }
+    else { deferred = minimum( deferred, ticks ); }
+  }
+  return busy ? busy : deferred;
+}
+
+unsigned long FFXMultiPixelController::getWireMicros() {
+  unsigned long longest = 0;
+  unsigned long total = 0;
+  bool parallel = true;
+  for (Output &out : outputs) {
+    unsigned long wire = out.sender->getWireMicros();
+    longest = maximum( longest, wire );
+    total += wire;
+    if (out.sender == out.output) { parallel = false; }
+  }
+  return parallel ? longest : total;
+}
@@ -0,0 +1,76 @@
+//
+//  FFXMultiPixelController.h
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#ifndef FFX_MULTI_PIXEL_CONTROLLER_H
+#define FFX_MULTI_PIXEL_CONTROLLER_H
+
+#include <vector>
+#include "FFXBase.h"
+#include "FFXPixelController.h"
+#include "FFXAsyncPixelController.h"
+
+/*!
+ *  FFXMultiPixelController - Pixel controller that spreads one strip of pixels over several outputs (pixel controllers), so
+ *  a single FFXController - with shared segments, overlays and timing - can drive an installation with many physical
+ *  strips.  Each output shows a range of the controller's pixels, and segments can span outputs freely.
+ *
+ *  Each output has its own LED array and keeps its own rate limit (e.g. FFXFastLEDPixelController's minimum show
+ *  interval).  If an output's LED array is its range of the controller's array, nothing is copied - otherwise the range is
+ *  copied to it before it is shown.  Outputs are only shown when pixels in their range have changed (or when the whole
+ *  strip is shown), and an output that puts a show off (rate limit) is shown again with its pending changes next time.
+ *
+ *  By default each output is sent from its own FFXAsyncPixelController (where FFX_ASYNC_THREADS is available), so all of
+ *  the outputs are sent at the same time and the frame takes as long as the longest output rather than the sum of them.
+ *  That needs each output to have an LED array of its own - an output that uses part of the controller's array is sent
+ *  in place, one after another, since the next frame is drawn into the same pixels.
+ *
+ *  ```
+ *  CRGB out1[300], out2[300];
+ *  FFXMultiPixelController *multi = new FFXMultiPixelController( nullptr, 2*300 );
+ *  multi->addOutput( new FFXFastLEDPixelController( &FastLED.addLeds<WS2812B, 2, GRB>( out1, 300 ), out1, 300 ), 0 );
+ *  multi->addOutput( new FFXFastLEDPixelController( &FastLED.addLeds<WS2812B, 4, GRB>( out2, 300 ), out2, 300 ), 300 );
+ *  FXController.initialize( multi );
+ *  FXController.addSegment( "Span", 250, 349 );          // across the first two outputs
+ *  ```
+ */
+class FFXMultiPixelController : public FFXPixelController {
+  public:
+    /*! initLeds may be nullptr, in which case the controller allocates its own array */
+    FFXMultiPixelController( CRGB *initLeds, uint16_t numLeds );
+    virtual ~FFXMultiPixelController();
+
+    /*! Add an output (which the controller then owns) showing pixels first..first+output->getNumLeds()-1.  With async, the
+     *  output is sent from a background thread, in parallel with the others.  Returns the output's index, or -1 if the
+     *  range doesn't fit. */
+    int addOutput( FFXPixelController *output, uint16_t first, bool async = true );
+    uint8_t getOutputCount() { return outputs.size(); }
+    /*! The output as it was added (not the FFXAsyncPixelController it may be wrapped in) */
+    FFXPixelController *getOutput( uint8_t index ) { return outputs[index].output; }
+    uint16_t getOutputFirst( uint8_t index ) { return outputs[index].first; }
+
+    virtual void show() override { showChanged( 0, getNumLeds()-1 ); }
+    /*! Show the outputs with pixels in firstChanged..lastChanged (all of them, with nothing changed, if the span is empty) */
+    virtual void showChanged( uint16_t firstChanged, uint16_t lastChanged ) override;
+    virtual void updateBrightness( uint8_t newBrightness ) override { }
+    virtual bool isShowComplete() override;
+    virtual void waitForShow() override;
+    virtual unsigned long timeToShowTicks() override;
+    /*! Longest output when they are sent in parallel, otherwise the total */
+    virtual unsigned long getWireMicros() override;
+
+  private:
+    struct Output {
+      FFXPixelController *output = nullptr;       // as added
+      FFXPixelController *sender = nullptr;       // output, or the FFXAsyncPixelController sending it
+      uint16_t first = 0;
+      FFXSpan pending;                            // output pixels changed but not yet shown
+    };
+    std::vector<Output> outputs;
+    bool ownLeds = false;
+    void showOutput( Output &out, bool all );
+};
+
+#endif
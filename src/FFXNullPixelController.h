@@ -0,0 +1,34 @@
+//
+//  FFXNullPixelController.h
+//
+//  Copyright 2020 - Geoff Moehrke 
+//  gmoehrke@gmail.com
+// 
+#ifndef FFX_NULL_PIXEL_CONTROLLER_H
+#define FFX_NULL_PIXEL_CONTROLLER_H
+
+#include "FFXPixelController.h"
+/*! 
+ *  FFXNullPixelController - Pixel controller that does not drive any hardware.  show() only counts frames (and the
+ *  pixels changed in them) so the framework can be run (and profiled) on a host machine or with the LED output disconnected.
+ */ 
+class FFXNullPixelController : public FFXPixelController {
+  protected:
+    unsigned long showCount = 0;
+    unsigned long long changedPixels = 0;
+
+  public:
+    FFXNullPixelController( CRGB *initLeds, uint16_t numLeds ) : FFXPixelController( initLeds, numLeds ) { }
+    virtual void updateBrightness( uint8_t newBrightness ) override { }
+    virtual void show() override { showCount++; changedPixels += getNumLeds(); }
+    virtual void showChanged( uint16_t firstChanged, uint16_t lastChanged ) override { 
+      showCount++; 
+      if (firstChanged <= lastChanged) { changedPixels += lastChanged-firstChanged+1; }
+    }
+    unsigned long getShowCount() { return showCount; }
+    /*! Total number of pixels reported as changed over all frames shown */
+    unsigned long long getChangedPixels() { return changedPixels; }
+    void resetShowCount() { showCount = 0; changedPixels = 0; }
+};
+
+#endif
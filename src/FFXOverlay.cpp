@@ -7,17 +7,9 @@
 #include "FFXOverlay.h"
 
 void FFXOverlay::applyOverlay( CRGB* overlay, CRGB* leds ) {
-  for (uint16_t i=0; i<numLeds; i++) {
-     if (overlay[i]!=CRGB(0,0,0)) {               // Black is treated as 100% transparent
-       if (alpha[i] != 0) {                       // Otherwise use alpha blend if != 0
-         //nblend(leds[i], overlay[i], alpha[i]);
-         uint8_t a = alpha[i] > getMaxAlpha() ? getMaxAlpha() : alpha[i]; 
-         leds[i] = CRGB( alphaBlend( leds[i].r, overlay[i].r, a ),
-                         alphaBlend( leds[i].g, overlay[i].g, a ),
-                         alphaBlend( leds[i].b, overlay[i].b, a ) );
-
-       }
-     }
+  FFXSpan span = applySpan.clip( 0, numLeds-1 );
+  for (uint16_t i=span.first; !span.isEmpty() && i<=span.last; i++) {
+     applyPixel( overlay[i], leds[i], i );
   }
 }
 
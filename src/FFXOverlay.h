@@ -28,12 +28,15 @@ class FFXOverlay : public FFXBase {
        unsigned long nextCycleStart = 0;
        std::vector<uint8_t> alpha;
        uint8_t maxAlpha = 255;
+       FFXSpan applySpan;              // pixels that may have a non-zero alpha - the only ones applyOverlay() visits
+       bool perPixel = false;          // set by descendants that apply with applyPixel() alone (don't override applyOverlay())
 
    public:
      FFXOverlay( uint16_t initSize, uint8_t initSpeed, bool initCont ) : FFXBase( initSize, initSpeed, 0, 50 ) {
        alpha.resize(initSize);
        alpha.clear();
        continuous = initCont;
+       applySpan = FFXSpan( 0, initSize-1 );
      }
      FFXOverlay( uint16_t initSize, bool initCont ) : FFXOverlay(initSize, 126, initCont) {
      }
@@ -48,7 +51,22 @@ class FFXOverlay : public FFXBase {
     }
 
      std::vector<uint8_t> *getAlpha() { return &alpha; }
+     /*! Pixels the overlay may change when applied - the whole overlay unless a descendant narrows it (see setAlpha()) */
+     const FFXSpan &getApplySpan() { return applySpan; }
      virtual void applyOverlay( CRGB* overlay, CRGB* leds );
+     /*! True if applyOverlay() is just applyPixel() over the apply span - the segment may then overlay while it draws */
+     bool isPerPixel() { return perPixel; }
+     /*! Apply overlay pixel ovl (index i) to led - applyOverlay() does this for each pixel in the apply span */
+     inline void applyPixel( const CRGB &ovl, CRGB &led, uint16_t i ) {
+       if (ovl!=CRGB(0,0,0)) {                     // Black is treated as 100% transparent
+         if (alpha[i] != 0) {                      // Otherwise use alpha blend if != 0
+           uint8_t a = alpha[i] > getMaxAlpha() ? getMaxAlpha() : alpha[i]; 
+           led = CRGB( alphaBlend( led.r, ovl.r, a ),
+                       alphaBlend( led.g, ovl.g, a ),
+                       alphaBlend( led.b, ovl.b, a ) );
+         }
+       }
+     }
      virtual void whileFrozen( CRGB *currFrame ) override;
 
      virtual void onVCycleEnd( CRGB *currFrame ) override;
@@ -57,7 +75,12 @@ class FFXOverlay : public FFXBase {
     void setLag( unsigned long newLag ) { if (repeatDelayms != newLag) { repeatDelayms = newLag; } }
     unsigned long getLag() { return repeatDelayms; }
     
-    void clearAlpha() { for (uint16_t i = 0; i<numLeds; i++) { alpha[i] = 0; } }
+    /*! Set every alpha to 0 - the whole overlay is applied afterward, since descendants may write alpha[] directly */
+    void clearAlpha() { for (uint16_t i = 0; i<numLeds; i++) { alpha[i] = 0; } applySpan = FFXSpan( 0, numLeds-1 ); }
+    // Set a single alpha value, keeping track of the span that needs to be applied
+    void setAlpha( uint16_t index, uint8_t value ) { alpha[index] = value; if (value) { markAlphaDirty( index, index ); } }
+    /*! Add pixels first..last to the apply span - call after writing alpha[] directly once the span has been narrowed with resetAlpha() */
+    void markAlphaDirty( uint16_t first, uint16_t last ) { applySpan.add( first, last ); }
     void setMaxAlpha( uint8_t newMax ) {
       if (newMax != maxAlpha) { maxAlpha = newMax; }
     }
@@ -65,6 +88,9 @@ class FFXOverlay : public FFXBase {
     
   protected:
 
+    /*! Set every alpha to 0 and empty the apply span - only for overlays whose alpha writes all go through setAlpha() or markAlphaDirty() */
+    void resetAlpha() { for (uint16_t i = 0; i<numLeds; i++) { alpha[i] = 0; } applySpan.clear(); }
+
     /*  Move a smaller "a" buffer into larger "b" buffer - use with caution - very little range checking.
      *  Bad parameters can cause GPF's easily since this uses generic pointers and memmove operations...
      */
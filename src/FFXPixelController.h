@@ -8,6 +8,15 @@
 #define FFX_PIXEL_CONTROLLER_H
 
 #include "FastLED.h"
+#include <limits.h>
+
+#ifndef FFX_WIRE_MICROS_PER_LED
+#define FFX_WIRE_MICROS_PER_LED 30      // WS2812 and similar - 24 bits at 800KHz
+#endif
+#ifndef FFX_WIRE_LATCH_MICROS
+#define FFX_WIRE_LATCH_MICROS 50        // reset/latch time after each frame
+#endif
+
 /*! 
  *  FFXPixelController - The base class for pixel controllers.  Settings for total number of 
  *  LEDs and overall brightness.
@@ -23,6 +32,18 @@ class FFXPixelController {
     FFXPixelController( CRGB *initLeds, uint16_t initNum );
     virtual ~FFXPixelController() {};
     virtual void show()=0;
+    /*! Show a frame where only pixels firstChanged..lastChanged differ from the last one shown (none if firstChanged > 
+     *  lastChanged).  LED strips have to be sent in full, so the default just calls show(). */
+    virtual void showChanged( uint16_t firstChanged, uint16_t lastChanged ) { show(); }
+    /*! Time (micros) it takes to send a frame to the LEDs once show() has started - used where show() returns before the 
+     *  data is all sent, or doesn't drive real LEDs.  0 = show() itself takes as long as it takes. */
+    virtual unsigned long getWireMicros() { return 0; }
+    /*! False while a frame passed to show() is still being sent in the background (see FFXAsyncPixelController) */
+    virtual bool isShowComplete() { return true; }
+    /*! Wait until the last frame shown has been sent */
+    virtual void waitForShow() { }
+    /*! Ticks until a show() that was put off (e.g. by a maximum refresh rate) can be done - ULONG_MAX if there isn't one */
+    virtual unsigned long timeToShowTicks() { return ULONG_MAX; }
     virtual void updateBrightness( uint8_t newBrightness ) = 0;
     virtual void setBrightness(uint8_t newBrightness);
     uint8_t getBrightness() { return currBrightness; }
@@ -0,0 +1,58 @@
+//
+//  FFXRenderStats.cpp
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "FFXRenderStats.h"
+
+#ifdef FFX_INSTRUMENT
+
+#include <stdio.h>
+#include <string.h>
+
+unsigned long long FFXRenderStats::getTotalMicros() {
+  unsigned long long result = 0;
+  // UPDATE covers everything else the controller does
+  for (uint8_t i = 0; i < UPDATE; i++) { result += stages[i].getTotalMicros(); }
+  return result;
+}
+
+void FFXRenderStats::reset() {
+  for (uint8_t i = 0; i < NUM_STAGES; i++) { stages[i].reset(); }
+  blendSteps = 0;
+  missedDeadlines = 0;
+}
+
+size_t FFXRenderStats::appendReport( char *buffer, size_t size ) {
+  size_t len = strlen( buffer );
+  for (uint8_t i = 0; i < NUM_STAGES && len+1 < size; i++) {
+    FFXStageStats &stage = stages[i];
+    if (stage.getCalls()) {
+      int n = snprintf( &(buffer[len]), size-len, " %s=%lu/%lu/%lu/%llu", getStageName( i ), stage.getCalls(),
+                        stage.getAverageMicros(), stage.getMaxMicros(), stage.getBytes()/1024 );
+      if (n > 0) { len = ((size_t)n < size-len) ? len+n : size-1; }
+    }
+  }
+  if (len+1 < size) {
+    int n = snprintf( &(buffer[len]), size-len, " blend_steps=%lu missed=%lu", blendSteps, missedDeadlines );
+    if (n > 0) { len = ((size_t)n < size-len) ? len+n : size-1; }
+  }
+  return len;
+}
+
+const char *FFXRenderStats::getStageName( uint8_t stage ) {
+  switch (stage) {
+    case EFFECT : { return "effect"; }
+    case BLEND : { return "blend"; }
+    case COPY : { return "copy"; }
+    case DIMMER : { return "dimmer"; }
+    case OPACITY : { return "opacity"; }
+    case OVERLAY : { return "overlay"; }
+    case SHOW : { return "show"; }
+    case UPDATE : { return "update"; }
+    default : { return "unknown"; }
+  }
+}
+
+#endif
@@ -0,0 +1,106 @@
+//
+//  FFXRenderStats.h
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#ifndef FFX_RENDER_STATS_H
+#define FFX_RENDER_STATS_H
+
+#include "FFXBase.h"
+
+/*!
+ *  Render instrumentation - built only when FFX_INSTRUMENT is defined (-DFFX_INSTRUMENT, or the FFX_INSTRUMENT option of the
+ *  host CMake build).  Without it none of this is compiled in and the FFX_STAGE_* macros (and FFX_INSTRUMENT_ONLY()) are empty.
+ *
+ *  Each segment keeps an FFXRenderStats (FFXSegment::getStats()) with the calls, total and longest duration (micros) and
+ *  bytes written for each stage of producing its pixels, plus the crossfade steps drawn and the effect steps that came
+ *  too late.  The controller keeps one more for show() and update() as a whole (FFXController::getStats()).
+ *
+ *    EFFECT   - the effect drawing a new frame (FFXBase::update() -> writeNextFrame()), bytes = its dirty span
+ *    BLEND    - writing out a frame with a new crossfade step
+ *    COPY     - writing out a frame as is (including direct mode, where this is only resolving the frame offset)
+ *    DIMMER   - writing out a frame dimmed by the segment brightness
+ *    OPACITY  - writing out a frame blended with the primary segment, plus working out the (dimmed) primary frame it is
+ *               blended with
+ *    OVERLAY  - stepping, crossfading and applying the segment's overlay
+ *    SHOW     - controller only - FFXPixelController::showChanged(), bytes = the pixels sent
+ *    UPDATE   - controller only - the whole of FFXController::update()
+ *
+ *  FFXCompositor writes a segment's frame, brightness and opacity out in one pass, so each pass is counted once - as BLEND
+ *  if it drew a new crossfade step, otherwise as OPACITY for a secondary segment, DIMMER if the brightness is below 255 and
+ *  COPY if none of these apply.
+ *
+ *  An effect step is counted as a missed deadline when it is drawn a whole interval (or more) after it was due - i.e. the
+ *  next frame was already due as well.  For the controller, an update() that took longer than the frame budget (see
+ *  FFXController::setFrameBudget()), or the frame time of the target frame rate, is counted.
+ *
+ *  ```
+ *  FFXRenderStats *stats = FXController->findSegment("Sign")->getStats();
+ *  stats->getStage( FFXRenderStats::BLEND ).getMaxMicros();
+ *  char report[1024];
+ *  FXController->getStatsReport( report, sizeof(report) );
+ *  FXController->resetStats();
+ *  ```
+ */
+
+#ifdef FFX_INSTRUMENT
+  #define FFX_STAGE_START( var ) unsigned long var = micros()
+  #define FFX_STAGE_END( stats, stage, var, bytes ) (stats)->add( (stage), micros()-(var), (bytes) )
+  #define FFX_INSTRUMENT_ONLY( statement ) statement
+#else
+  #define FFX_STAGE_START( var )
+  #define FFX_STAGE_END( stats, stage, var, bytes )
+  #define FFX_INSTRUMENT_ONLY( statement )
+#endif
+
+#ifdef FFX_INSTRUMENT
+
+class FFXStageStats {
+  public:
+    void add( unsigned long micros, unsigned long bytes ) {
+      calls++;
+      totalMicros += micros;
+      if (micros > maxMicros) { maxMicros = micros; }
+      totalBytes += bytes;
+    }
+    unsigned long getCalls() { return calls; }
+    unsigned long long getTotalMicros() { return totalMicros; }
+    unsigned long getMaxMicros() { return maxMicros; }
+    unsigned long getAverageMicros() { return calls ? totalMicros / calls : 0; }
+    unsigned long long getBytes() { return totalBytes; }
+    void reset() { calls = 0; totalMicros = 0; maxMicros = 0; totalBytes = 0; }
+  private:
+    unsigned long calls = 0;
+    unsigned long long totalMicros = 0;
+    unsigned long maxMicros = 0;
+    unsigned long long totalBytes = 0;
+};
+
+class FFXRenderStats {
+  public:
+    enum Stage : uint8_t { EFFECT, BLEND, COPY, DIMMER, OPACITY, OVERLAY, SHOW, UPDATE, NUM_STAGES };
+
+    void add( uint8_t stage, unsigned long micros, unsigned long bytes ) { stages[stage].add( micros, bytes ); }
+    FFXStageStats &getStage( uint8_t stage ) { return stages[stage]; }
+    void addBlendStep() { blendSteps++; }
+    unsigned long getBlendSteps() { return blendSteps; }
+    void addMissedDeadline() { missedDeadlines++; }
+    unsigned long getMissedDeadlines() { return missedDeadlines; }
+    /*! Total time over all stages (micros) */
+    unsigned long long getTotalMicros();
+    void reset();
+    /*! Append "stage=calls/avg/max/kB" for each stage that has been used, plus the blend step and missed deadline counts,
+     *  to buffer (which already holds a string).  Returns the length of the result. */
+    size_t appendReport( char *buffer, size_t size );
+    static const char *getStageName( uint8_t stage );
+
+  private:
+    FFXStageStats stages[NUM_STAGES];
+    unsigned long blendSteps = 0;
+    unsigned long missedDeadlines = 0;
+};
+
+#endif
+
+#endif
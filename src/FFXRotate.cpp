@@ -13,30 +13,57 @@ void FFXRotate::setColor( CRGB newColor )
   }
 
 
-bool FFXRotate::rotate(CRGB *bufLeds, uint16_t steps ) {
+FFXBase::MovementType FFXRotate::getRotateDirection() {
     if (getMovement()==MVT_FORWARD || getMovement()==MVT_BACKWARD || getMovement()== MVT_BACKFORTH) {
         if (getMovement()!=MVT_BACKWARD || ((getMovement()==MVT_BACKFORTH) && ((currCycle % 2)==1))) {
-          rotateForward( bufLeds, steps );
-         } 
-         else {
-          rotateBackward( bufLeds, steps );
+          return MVT_FORWARD;
+        } 
+        else {
+          return MVT_BACKWARD;
         }
-      return( true );
     }
     else {
-      return( false );
+      return MVT_STILL;
+    }
+  }
+
+bool FFXRotate::rotate(CRGB *bufLeds, uint16_t steps ) {
+    switch (getRotateDirection()) {
+      case MVT_FORWARD : { rotateForward( bufLeds, steps ); return true; }
+      case MVT_BACKWARD : { rotateBackward( bufLeds, steps ); return true; }
+      default : { return false; }
+    }
+  }
+
+bool FFXRotate::rotateOffset( uint16_t steps ) {
+    switch (getRotateDirection()) {
+      // in 32 bits, reduced before narrowing - frameOffset+numLeds doesn't fit in a uint16_t past 32767 pixels
+      case MVT_FORWARD : { setFrameOffset( (uint16_t)(((uint32_t)frameOffset + (steps % numLeds)) % numLeds) ); return true; }
+      case MVT_BACKWARD : { setFrameOffset( (uint16_t)(((uint32_t)frameOffset + numLeds - (steps % numLeds)) % numLeds) ); return true; }
+      default : { return false; }
     }
   }
 
   void FFXRotate::writeNextFrame(CRGB *bufLeds) {
       if (redrawFull) {
+        setFrameOffset(0);
         fillLeds(bufLeds, currPhase);
         setUpdated( true );
         redrawFull = false;
       }
       else {
-        if (rotate(bufLeds, 1 ) ) {
+        // rotating only moves the frame offset - pixel data is untouched (but every logical pixel moved)
+        frameDataChanged = false;
+        if (rotateOffset( 1 )) {
           setUpdated( true );
+        }
+        else {
+          markClean();
+        }
       }
-    }
-  }
\ No newline at end of file
+  }
+
+  void FFXRotate::onCatchUp( unsigned long steps ) {
+      // a full redraw is still to come - it starts from the phase, which catchUp() moves on
+      if (!redrawFull) { rotateOffset( steps % numLeds ); }
+  }
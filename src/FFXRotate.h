@@ -13,18 +13,28 @@
  *  Allows only the contructor and the `fillLeds()` method to be overriden to implement
  *  the effect.
  * 
+ *  Rotation between frames does not move any pixel data - writeNextFrame() calls rotateOffset(), 
+ *  which only advances the frame offset (see FFXBase), so each frame costs O(1) regardless of the 
+ *  strip length.  rotate() still moves the pixels in bufLeds (e.g. to shift the initial pattern 
+ *  in fillLeds() before blurring it) - but it is no longer called for each frame, so a descendant 
+ *  that overrides rotate() to change how the frame moves should override rotateOffset() instead.
+ * 
  */ 
 class FFXRotate : public FFXBase {
 
   protected:
      boolean redrawFull = true;
+     MovementType getRotateDirection();
 
   public:
-    FFXRotate( uint8_t initSize, unsigned long initTimer, unsigned long minRefresh, unsigned long maxRefresh ) :FFXBase( initSize, initTimer, minRefresh, maxRefresh )  {}
+    FFXRotate( uint16_t initSize, unsigned long initTimer, unsigned long minRefresh, unsigned long maxRefresh ) :FFXBase( initSize, initTimer, minRefresh, maxRefresh )  {}
     virtual void setColor( CRGB newColor ) override;
     virtual void fillLeds(CRGB *bufLeds, uint16_t phase) = 0;
     virtual bool rotate(CRGB *bufLeds, uint16_t steps );
+    /*! Rotate the frame by moving its offset, without touching the pixel data */
+    virtual bool rotateOffset( uint16_t steps );
     virtual void writeNextFrame(CRGB *bufLeds) override; 
+    virtual void onCatchUp( unsigned long steps ) override;
 };
 
 #endif
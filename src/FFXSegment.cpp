@@ -6,18 +6,21 @@
 // 
 #include "FFXSegment.h"
 #include "FFXController.h"
+#include "FFXCompositor.h"
+#include "FFXTrace.h"
 
-bool FFXSegment::isPrimary() { return getTag()==PRIMARY_SEG_NAME; }
-  
-FFXSegment::FFXSegment( String initTag, uint16_t initStartIdx, uint16_t initEndIdx, FFXBase* initEffect, CRGB *initFrame, FFXController *parentController ) : FFXStateObserver() {
+FFXSegment::FFXSegment( String initTag, uint16_t initStartIdx, uint16_t initEndIdx, FFXBase* initEffect, CRGB *initFrame, FFXController *parentController, uint16_t initHandle ) : FFXStateObserver() {
     tag = initTag;
+    tagHash = FFXController::hashTag( tag.c_str() );
+    handle = initHandle;
+    primary = (tag==PRIMARY_SEG_NAME);
     startIdx = initStartIdx;
     endIdx = initEndIdx;
     effect = initEffect;
     controller = parentController;
-    localDimmer = ((tag==PRIMARY_SEG_NAME) ? new FFXAFDimmer(500) : nullptr );
+    localDimmer = (primary ? new FFXAFDimmer(500) : nullptr );
     stateChanged = true;
-    if (tag!=PRIMARY_SEG_NAME) {
+    if (!primary) {
       opacity = new FFXAFXFader( getLength() );
       opacity->setInterval(750);
       opacity->setTarget(0);
@@ -30,38 +33,63 @@ FFXSegment::FFXSegment( String initTag, uint16_t initStartIdx, uint16_t initEndI
 
   FFXSegment::~FFXSegment() {
     if (effect) { delete effect; }
+    removeOverlay();
     if (frameView) { delete frameView; }
     if (localDimmer) { delete localDimmer; }
     if (opacity) { delete opacity; }
   }
 
+ void FFXSegment::onEvent( const FFXEvent &event ) {
+     switch (event.type) {
+       case FFXEvent::LOG : { controller->onEvent( this, FFXController::FXEventType::FX_LOG, event.text ); break; }
+       case FFXEvent::INTERVAL : { frameView->checkCrossFade(effect); break; }
+       case FFXEvent::PRIMARY_BRIGHTNESS : { onPrimaryBrightness( event.value ); break; }
+       default : {
+         controller->onEvent( this, FFXController::FXEventType::FX_PARAM_CHANGE, FFXEvent::attributeName(event.type) );
+         frameView->checkCrossFade(effect);
+       }
+     }
+     stateChanged = true;
+  }
+
  void FFXSegment::onNotify(String source, String attribute, String value ) {
+     // String notifications from observers/effects that don't use FFXEvent
      if (attribute=="LOG") { 
-       controller->onFXEvent( getTag(), FFXController::FXEventType::FX_LOG, value ); 
+       controller->onEvent( this, FFXController::FXEventType::FX_LOG, value.c_str() ); 
      }
      else if (attribute=="Interval") {
         frameView->checkCrossFade(effect);
      }
      else if (attribute=="Brightness" && source=="Primary") {
-        if (localDimmer && offWithPrimary && !isPrimary()) {
-          if (value == "0") {
-            savedBrightness = getBrightness();
-            this->setBrightness(0);
-            forcedOff = true;
-          }
-          else {            
-            forcedOff = false;
-            this->setBrightness(savedBrightness);            
-          }
-        }
+        onPrimaryBrightness( value.toInt() );
      }
      else {
-       controller->onFXEvent( getTag(), FFXController::FXEventType::FX_PARAM_CHANGE, attribute );
+       controller->onEvent( this, FFXController::FXEventType::FX_PARAM_CHANGE, attribute.c_str() );
        frameView->checkCrossFade(effect);
      }
      stateChanged = true;
   }  
 
+  void FFXSegment::onPrimaryBrightness( uint8_t value ) {
+    if (localDimmer && offWithPrimary && !isPrimary()) {
+      if (value == 0) {
+        savedBrightness = getBrightness();
+        this->setBrightness(0);
+        forcedOff = true;
+      }
+      else {            
+        forcedOff = false;
+        this->setBrightness(savedBrightness);            
+      }
+    }
+  }
+
+void FFXSegment::setTag( String newTag ) {
+    tag = newTag;
+    tagHash = FFXController::hashTag( tag.c_str() );
+    controller->onTagChanged( this );
+  }
+
 void FFXSegment::setFX( FFXBase *newFX ) { 
     if (effect) {
       effect->stop();
@@ -74,7 +102,10 @@ void FFXSegment::setFX( FFXBase *newFX ) {
       effect->start();
       frameView->checkCrossFade(effect);
       effect->onBrightness(getActiveDimmer()->getValue());
+      effectPaused = false;
+      controller->invalidateCoverage();
       stateChanged = true;
+      redrawPending = true;
     }
   }
 
@@ -86,9 +117,10 @@ void FFXSegment::setFX( FFXBase *newFX ) {
     if (overlay) {
       delete overlay;
       overlay = nullptr;
+      controller->invalidateCoverage();
      }
     if (ovlLeds) {
-      delete ovlLeds;
+      controller->getBufferPool()->release( ovlLeds );
       ovlLeds = nullptr; 
     } 
   }
@@ -97,29 +129,44 @@ void FFXSegment::setFX( FFXBase *newFX ) {
   void FFXSegment::setOverlay( FFXOverlay *newOvl ) {
   if (newOvl) {
     if (overlay) { 
-      controller->onFXEvent( getTag(), FFXController::FX_OVERLAY_STOPPED, overlay->getFXName() ); 
+      controller->onEvent( this, FFXController::FX_OVERLAY_STOPPED, overlay->getFXName().c_str() ); 
       removeOverlay(); 
     }
     if (ovlLeds == nullptr) {
-      ovlLeds = new CRGB[getLength()];
+      ovlLeds = controller->getBufferPool()->allocate( getLength() );
     }
     fill_solid( ovlLeds, getLength(), CRGB::Black );
     if (ovlFP == nullptr) { 
       ovlFP = new FFXFrameProvider(this, ovlLeds); 
+      ovlFP->setBlendPriority( frameView->getBlendPriority() );
+      ovlFP->setBlendStepSize( frameView->getBlendStepSize() );
     }
     overlay = newOvl;
+    FFX_TRACE_INSTANT( "overlay started", handle );
     overlay->start();
-    controller->onFXEvent(  getTag(), FFXController::FX_OVERLAY_STARTED, overlay->getFXName() );
+    controller->invalidateCoverage();
+    controller->onEvent( this, FFXController::FX_OVERLAY_STARTED, overlay->getFXName().c_str() );
   }
 }
 
+  void FFXSegment::setBlendPriority( uint8_t newValue ) {
+    frameView->setBlendPriority( newValue );
+    if (ovlFP) { ovlFP->setBlendPriority( newValue ); }
+  }
+
+  void FFXSegment::setBlendStepSize( uint8_t newValue ) {
+    frameView->setBlendStepSize( newValue );
+    if (ovlFP) { ovlFP->setBlendStepSize( newValue ); }
+  }
+
   bool FFXSegment::isVisible() {
     bool result = false;
     if (overlay) { 
       result = true; 
     }
     else if (effect) {
-      result = (effect->isStarted() //&&
+      result = (effect->isStarted() && 
+                !(opacity && opacity->getValue()==0 && !opacity->isFading()) //&&
                 //(this->isPrimary() ||
                 //!(offWithPrimary && getController()->getPrimarySegment()->getCurrentBrightness()==0))
                 );
@@ -127,10 +174,22 @@ void FFXSegment::setFX( FFXBase *newFX ) {
     return result;
   } 
 
+  bool FFXSegment::isOpaque() {
+    return (opacity && opacity->getValue()==255 && !opacity->isFading() && effect && effect->isStarted());
+  }
+
+  void FFXSegment::resumeEffect() {
+    if (effectPaused) {
+      effectPaused = false;
+      frameView->catchUp( effect );
+    }
+  }
+
   void FFXSegment::setOpacity(uint8_t level) {
        if (opacity) {
          opacity->setTarget(level); 
-         controller->onFXEvent( getTag(), FFXController::FXEventType::FX_OPACITY_CHANGED, "Segment:"+ (isPrimary() ? "Primary" : getTag()) );
+         controller->invalidateCoverage();
+         controller->onEvent( this, FFXController::FXEventType::FX_OPACITY_CHANGED, nullptr );
          stateChanged = true;
      }
   }
@@ -142,11 +201,11 @@ void FFXSegment::setFX( FFXBase *newFX ) {
     else {
       if (!hasDimmer()) {
         localDimmer = new FFXAFDimmer(500, controller->getPrimarySegment()->getBrightness() );
-        controller->onFXEvent( getTag(), FFXController::FXEventType::FX_LOCAL_BRIGHTNESS_ENABLED, "Segment:"+ (isPrimary() ? "Primary" : getTag()) );
+        controller->onEvent( this, FFXController::FXEventType::FX_LOCAL_BRIGHTNESS_ENABLED, nullptr );
       }
       localDimmer->setTarget(newBrightness);
-      controller->onFXEvent( getTag(), FFXController::FXEventType::FX_BRIGHTNESS_CHANGED, "Segment:"+ (isPrimary() ? "Primary" : getTag()) );
-      if (isPrimary()) { controller->notifySegments( false, "Primary", "Brightness", String(newBrightness)); }
+      controller->onEvent( this, FFXController::FXEventType::FX_BRIGHTNESS_CHANGED, nullptr );
+      if (isPrimary()) { controller->notifySegments( false, FFXEvent( FFXEvent::PRIMARY_BRIGHTNESS, "Primary", newBrightness ) ); }
       stateChanged = true;
     }
   }
@@ -172,6 +231,15 @@ void FFXSegment::setFX( FFXBase *newFX ) {
     }
   } 
  
+  bool FFXSegment::canRenderDirect() {
+    // The effect can only own the display pixels if nothing else writes to them or depends on their previous contents:
+    // no crossfade frames, no overlay, fully opaque, not dimmed (the dimmer works in place) and no other segment on top/beneath.
+    return (!frameView->getCrossFade() && !overlay &&
+            (!opacity || (opacity->getValue()==255 && !opacity->isFading())) &&
+            (getActiveDimmer()->getValue()==255 && !getActiveDimmer()->isFading()) &&
+            !controller->isOverlapped(this));
+  }
+
   bool FFXSegment::isUpdated() {
     bool result = false;
     if (isVisible()) {
@@ -179,29 +247,93 @@ void FFXSegment::setFX( FFXBase *newFX ) {
         result = true;
       }
       else {
-        result = (effect->isUpdated() || getActiveDimmer()->isUpdated());
+        result = ((effect->isUpdated() && !isDark()) || getActiveDimmer()->isUpdated());
       }
       if (opacity) { result = result || opacity->isUpdated(); }
     }
     return result;
   }
 
+  unsigned long FFXSegment::timeToNextUpdateTicks() {
+    bool visible = isVisible();
+    if (redrawPending || (stateChanged && !isFading()) || visible != wasVisible || (!overlay && !ovlSpan.isEmpty())) { return 0; }
+    unsigned long result = getActiveDimmer()->timeToNextChangeTicks();
+    if (opacity) { result = minimum( result, opacity->timeToNextChangeTicks() ); }
+    if (overlay) {
+      if (overlay->isDone()) { return 0; }
+      result = minimum( result, ovlFP->timeToNextFrameTicks( overlay ) );
+    }
+    if (visible && effect && effect->isStarted() && !isDark()) {
+      result = minimum( result, frameView->timeToNextFrameTicks( effect ) );
+    }
+    return result;
+  }
+
+  void FFXSegment::addPendingDamage( FFXSpan &damage ) {
+    // Pixels an overlay drew over last time have to be restored from the frames underneath, and a segment that 
+    // appears/disappears changes its whole range
+    damage.add( ovlSpan );
+    ovlSpan.clear();
+    bool visible = isVisible();
+    if (visible != wasVisible) {
+      damage.add( startIdx, endIdx );
+      wasVisible = visible;
+      redrawPending = true;
+    }
+    uint8_t state = (visible ? 1 : 0) | (isOpaque() ? 2 : 0) | (overlay ? 4 : 0);
+    if (state != coverState) {
+      coverState = state;
+      controller->invalidateCoverage();
+    }
+  }
+
   void FFXSegment::updateOverlay( CRGB *frameBuffer ) {
-      if (overlay) {
-        // v1.1.1 Moved this check here so overlay will not be removed before last frame is drawn
-        if (overlay->isDone()) { 
-          controller->onFXEvent(  getTag(), FFXController::FX_OVERLAY_COMPLETED, overlay->getFXName()); 
-          removeOverlay(); 
-        }  
-        else {
-          ovlFP->updateFrame( ovlLeds, overlay );
-          // controller->onFXEvent(  getTag(), FFXController::FX_OVERLAY_UPDATED, overlay->getFXName()); 
+    FFXSpan damage = FFXSpan();
+    updateOverlay( frameBuffer, damage );
+  }
+
+  bool FFXSegment::advanceOverlay() {
+    // v1.1.1 Moved this check here so overlay will not be removed before last frame is drawn
+    if (overlay->isDone()) { 
+      FFX_TRACE_INSTANT( "overlay completed", handle );
+      controller->onEvent( this, FFXController::FX_OVERLAY_COMPLETED, overlay->getFXName().c_str() ); 
+      removeOverlay(); 
+      return false;
+    }  
+    FFXSpan span = FFXSpan( 0, getLength()-1 );
+    ovlFP->advance( overlay, span );
+    unsigned long start = micros();
+    ovlFP->render( ovlLeds, span );
+    if (ovlFP->isBlendStep()) { 
+      controller->addBlendTime( ovlFP, micros()-start ); 
+      FFX_INSTRUMENT_ONLY( stats.addBlendStep() );
+    }
+    // controller->onFXEvent(  getTag(), FFXController::FX_OVERLAY_UPDATED, overlay->getFXName()); 
+    return true;
+  }
+
+  void FFXSegment::updateOverlay( CRGB *frameBuffer, FFXSpan &damage ) {
+      if (overlay && !overlayDrawn) {
+        FFX_TRACE_SCOPE( "FFXSegment::updateOverlay", handle );
+        FFX_STAGE_START( ovlStart );
+        if (advanceOverlay()) {
+          FFXSpan applied = overlay->getApplySpan().clip( 0, getLength()-1 );
           overlay->applyOverlay( ovlLeds, &(frameBuffer[startIdx]));
+          ovlSpan.add( applied.shift(startIdx) );
+          damage.add( ovlSpan );
         }
+        FFX_STAGE_END( &stats, FFXRenderStats::OVERLAY, ovlStart, getBufferSize() );
       }
+      overlayDrawn = false;
   }
 
   void FFXSegment::updateFrame( CRGB *frameBuffer ) {
+    FFXSpan damage = FFXSpan( startIdx, endIdx );
+    updateFrame( frameBuffer, damage );
+  }
+
+  void FFXSegment::updateFrame( CRGB *frameBuffer, FFXSpan &damage ) {
+    FFX_TRACE_SCOPE( "FFXSegment::updateFrame", handle );
     if (isVisible()) { 
       if (getActiveDimmer()->isUpdated()) {
         effect->onBrightness(getCurrentBrightness());
@@ -210,20 +342,118 @@ void FFXSegment::setFX( FFXBase *newFX ) {
           delete localDimmer; 
           localDimmer = nullptr;
           removeDimmerPending = false;
+          redrawPending = true;
+        }
+      }
+      if (canRenderDirect()) { frameView->enterDirect( &(frameBuffer[startIdx]), effect ); }
+      else { frameView->exitDirect(); }
+      // Only pixels that changed, or that something else drew over (damage), are rewritten - unless the dimmer or opacity 
+      // are fading, which changes every pixel - and once more when they stop, as the last step still blends in the value
+      // before it (see FFXCompositor::setBackground())
+      FFXSpan span = damage.clip( startIdx, endIdx ).shift( -(int32_t)startIdx );
+      bool fading = getActiveDimmer()->isFading() || (opacity && opacity->isFading());
+      if (redrawPending || fading) {
+        span.add( 0, getLength()-1 );
+        redrawPending = fading;
+      }
+      // A translucent segment shows the primary frame through it - wherever that changed, drawn or not
+      if (!primary && !isOpaque()) { span.add( controller->getPrimaryChangedSpan().clip( startIdx, endIdx ).shift( -(int32_t)startIdx ) ); }
+      if (isDark()) { 
+        // Only black is drawn (where needed) until the brightness changes
+        pauseEffect(); 
+      }
+      else {
+#ifdef FFX_INSTRUMENT
+        // A whole interval late means the frame after this one was due too (not counted when the effect was paused)
+        if (!effectPaused && effect->isUp() && effect->getCurrIntervalTicks() > 0 && 
+            GET_TIME_TICKS - effect->nextUp() >= effect->getCurrIntervalTicks()) { stats.addMissedDeadline(); }
+#endif
+        resumeEffect();
+        frameView->advance( effect, span );
+      }
+      if (primary) { controller->setPrimaryChangedSpan( span.shift(startIdx) ); }
+      FFXAFDimmer *dimmer = getActiveDimmer();
+      dimmer->updateFader();
+      if (frameView->isDirect()) {
+        // The effect drew straight into the display buffer, at full brightness and opacity - nothing left to do
+        FFX_STAGE_START( drawStart );
+        frameView->render( &(frameBuffer[startIdx]), span );
+        if (!span.isEmpty()) { FFX_STAGE_END( &stats, FFXRenderStats::COPY, drawStart, span.length()*sizeof(CRGB) ); }
+        if (opacity) { 
+          controller->getPrimarySegment()->getActiveDimmer()->updateFader();
+          opacity->updateFader(); 
         }
       }
-      getFrameProvider()->updateFrame( &(frameBuffer[startIdx]), effect );      
-      CRGBSet pixels = CRGBSet(frameBuffer, startIdx, endIdx);
-      getActiveDimmer()->update(pixels);
-      if (opacity) {
-          CRGBSet bkdest = CRGBSet(opacity->getBackgroundBuffer(),getLength());
-          controller->getPrimarySegment()->getFrameProvider()->getLastFrame(bkdest.leds, startIdx, endIdx );
-          controller->getPrimarySegment()->getActiveDimmer()->update(bkdest);    
-          nblend( &(frameBuffer[startIdx]), opacity->getBackgroundBuffer(), getLength(), 255-opacity->getValue());
-          opacity->update(pixels);
+      else {
+        // Frame, brightness, opacity and (when nothing is drawn on top of it) the overlay are combined in one pass - overlays
+        // with their own applyOverlay() are applied after the draw by updateOverlay()
+        FFXCompositor compositor = FFXCompositor( frameView->getOutputSource(), getLength(), dimmer->getValue() );
+        if (overlay && overlay->isPerPixel() && overlay->getNumLeds()==getLength() && controller->isOnTop(this)) {
+          FFX_STAGE_START( ovlStart );
+          if (advanceOverlay()) {
+            FFXSpan applied = overlay->getApplySpan().clip( 0, getLength()-1 );
+            compositor.setOverlay( overlay, ovlLeds, applied );
+            span.add( applied );
+            ovlSpan.add( applied.shift(startIdx) );
+            overlayDrawn = true;
+          }
+          FFX_STAGE_END( &stats, FFXRenderStats::OVERLAY, ovlStart, getBufferSize() );
+        }
+        FFX_STAGE_START( drawStart );
+        if (opacity) {
+          controller->getPrimarySegment()->getActiveDimmer()->updateFader();
+          uint8_t opacityBefore = opacity->getValue();
+          opacity->updateFader();
+          if (!span.isEmpty()) {
+            const CRGB *bk = controller->getPrimaryFrame( startIdx+span.first, startIdx+span.last );
+            compositor.setBackground( &(bk[startIdx]), opacityBefore, opacity->getValue() );
+          }
+        }
+        unsigned long start = micros();
+        span = drawUncovered( compositor, frameBuffer, span );
+        if (frameView->isBlendStep()) { 
+          controller->addBlendTime( frameView, micros()-start ); 
+          FFX_INSTRUMENT_ONLY( stats.addBlendStep() );
+        }
+#ifdef FFX_INSTRUMENT
+        if (!span.isEmpty()) {
+          uint8_t stage = frameView->isBlendStep() ? FFXRenderStats::BLEND : 
+                          (opacity ? FFXRenderStats::OPACITY : (dimmer->getValue() < 255 ? FFXRenderStats::DIMMER : FFXRenderStats::COPY));
+          FFX_STAGE_END( &stats, stage, drawStart, span.length()*sizeof(CRGB) );
+        }
+#endif
       }
+      damage.add( span.shift(startIdx) );
     }
     else {
-        if (opacity) { opacity->freeBackgroundBuffer(); }
+        pauseEffect();
+    }
+  }
+
+  FFXSpan FFXSegment::drawUncovered( FFXCompositor &compositor, CRGB *frameBuffer, const FFXSpan &span ) {
+    // Pixels under a later opaque segment would be drawn over (and never read - translucent segments blend over 
+    // getPrimaryFrame()) so they are skipped, unless the gap is too short to be worth a separate draw() call.  
+    // Returns the part of span that was drawn.
+    FFXCoverageMap *coverage = controller->getCoverageMap();
+    if (span.isEmpty() || !coverage->isPartlyHidden( handle )) {
+      compositor.draw( &(frameBuffer[startIdx]), span );
+      return span;
     }
-  }
\ No newline at end of file
+    FFXSpan drawn = FFXSpan();
+    FFXSpan strip = span.shift( startIdx );
+    FFXSpan pending = FFXSpan();
+    for (FFXSpan run = coverage->nextExposed( handle, strip.first, strip.last ); !run.isEmpty(); 
+         run = (run.last < strip.last) ? coverage->nextExposed( handle, run.last+1, strip.last ) : FFXSpan()) {
+      if (!pending.isEmpty() && run.first-pending.last > FFX_MIN_HIDDEN_RUN) {
+        compositor.draw( &(frameBuffer[startIdx]), pending.shift( -(int32_t)startIdx ) );
+        drawn.add( pending );
+        pending.clear();
+      }
+      pending.add( run );
+    }
+    if (!pending.isEmpty()) {
+      compositor.draw( &(frameBuffer[startIdx]), pending.shift( -(int32_t)startIdx ) );
+      drawn.add( pending );
+    }
+    return drawn.shift( -(int32_t)startIdx );
+  }
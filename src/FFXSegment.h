@@ -12,8 +12,15 @@
 #include "FFXAFDimmer.h"
 #include "FFXAFXFader.h"
 #include "FFXOverlay.h"
+#include "FFXRenderStats.h"
 
 class FFXController;
+class FFXCompositor;
+
+// Pixels hidden under an opaque segment are only skipped in runs longer than this
+#ifndef FFX_MIN_HIDDEN_RUN
+#define FFX_MIN_HIDDEN_RUN 16
+#endif
 
 /*!
  *  FFXSegment - Class for housing multiple effects in a single pixel array.  Each segment contains a FXFrameProvider to handle
@@ -30,12 +37,18 @@ class FFXController;
  *  segment has its own brightness controller and will remain independent from the primary segment's brightness.  A subsequent call to removeDimmer()
  *  will remove the segments dimmer and revert back to using the brightness of the primary controller.
  *
+ *  Segments that can't affect the output are skipped:  a secondary segment at opacity 0 (and not fading) is not visible at all, 
+ *  and a segment whose brightness is 0 (and not fading) only redraws black where something else drew over it.  In both cases 
+ *  the effect is not updated - when the segment is drawn again the effect's phase is moved on by the steps it missed (see 
+ *  FFXBase::catchUp()).  Pixels underneath a later, fully opaque segment are not drawn either (see FFXCoverageMap).
+ *
 */
 class FFXSegment : public FFXStateObserver {
 public:
-  FFXSegment( String initTag, uint16_t initStartIdx, uint16_t initEndIdx, FFXBase* initEffect, CRGB *initFrame, FFXController *parentController );
+  FFXSegment( String initTag, uint16_t initStartIdx, uint16_t initEndIdx, FFXBase* initEffect, CRGB *initFrame, FFXController *parentController, uint16_t initHandle = 0 );
   virtual ~FFXSegment();
   
+  virtual void onEvent( const FFXEvent &event ) override;
   virtual void onNotify(String source, String attribute, String value ) override;
 
   inline FFXBase *getFX() { return effect; }
@@ -44,7 +57,9 @@ public:
   void setOverlay( FFXOverlay *newOvl );
   void removeOverlay();
   FFXController *getController() { return controller; }
-  bool isPrimary();
+  inline bool isPrimary() { return primary; }
+  /*! Position of this segment in its controller - see FFXController::getSegment() */
+  inline uint16_t getHandle() { return handle; }
   inline uint16_t getStart() { return startIdx; }
   inline uint16_t getEnd() { return endIdx; }
   inline uint16_t getLength() { return endIdx-startIdx+1; }
@@ -52,7 +67,23 @@ public:
   FFXFrameProvider *getFrameProvider() {     
     return frameView; 
   }
+  /*! Frame provider for the overlay (nullptr if there is no overlay) */
+  FFXFrameProvider *getOverlayFrameProvider() { return ovlFP; }
+  /*! Priority of this segment's crossfade steps (and its overlay's) when the controller has a frame budget - see 
+   *  FFXController::setFrameBudget() */
+  void setBlendPriority( uint8_t newValue );
+  uint8_t getBlendPriority() { return frameView->getBlendPriority(); }
+  /*! Smallest change in blend amount drawn as a new crossfade step, for this segment and its overlay - see 
+   *  FFXFrameProvider::setBlendStepSize() */
+  void setBlendStepSize( uint8_t newValue );
+  uint8_t getBlendStepSize() { return frameView->getBlendStepSize(); }
+  /*! Turn crossfade off for this segment whatever its preference (until called again with false) */
+  void setCrossFadeSuspended( bool newValue ) { frameView->setCrossFadeSuspended( newValue, effect ); }
   bool isVisible();
+  /*! Brightness is 0 and not changing - nothing but black is drawn and the effect is not updated */
+  bool isDark() { return (getActiveDimmer()->getValue()==0 && !getActiveDimmer()->isFading()); }
+  /*! Secondary segment at full opacity (not fading) - every pixel underneath it is hidden */
+  bool isOpaque();
   void setOpacity(uint8_t level);
   inline uint8_t getOpacity() { if (opacity) { return opacity->getTarget(); } else { return 255; } }
   inline uint8_t getCurrentOpacity() { if (opacity) { return opacity->getValue(); } else { return 255; } }
@@ -60,8 +91,19 @@ public:
   void setOpacityInterval( unsigned long newInterval ) { if (opacity) { opacity->setInterval(newInterval); } }
   bool isFading() { return ((opacity ? (opacity->isFading()) : false) || (getActiveDimmer()->isFading())); }
   bool isUpdated();
+  /*! Ticks until the next update() would change anything in this segment - effect or overlay step, crossfade step, or 
+   *  brightness/opacity fade (0 = now, ULONG_MAX = nothing until something is changed from outside) */
+  unsigned long timeToNextUpdateTicks();
+  /*! True if the effect can draw straight into the display buffer (FFXFrameProvider direct mode) this cycle */
+  bool canRenderDirect();
   void updateFrame( CRGB *frameBuffer );
   void updateOverlay( CRGB *frameBuffer );
+  /*! Same as above, but only rewrites pixels of the segment that changed or that are in damage (strip indexes - pixels 
+   *  other segments or overlays drew over).  Every pixel written is added to damage. */
+  void updateFrame( CRGB *frameBuffer, FFXSpan &damage );
+  void updateOverlay( CRGB *frameBuffer, FFXSpan &damage );
+  /*! Add pixels that must be redrawn before this cycle's updates - the last overlay frame and visibility changes */
+  void addPendingDamage( FFXSpan &damage );
   inline bool hasDimmer() { return (localDimmer!=nullptr);  }
   void removeDimmer();
   void setBrightness( uint8_t newBrightness );
@@ -76,14 +118,22 @@ public:
   uint8_t getCurrentBrightness();
   uint8_t getSetBrightness() { return( isPrimary() ? this->getBrightness() : (forcedOff ? savedBrightness : this->getBrightness() ));}
   inline String getTag() { return tag; }
-  inline void setTag( String newTag ) { tag = newTag; }
+  void setTag( String newTag );
+  inline uint32_t getTagHash() { return tagHash; }
   inline boolean isStateChanged() { return stateChanged; }
   inline void resetStateChanged() { stateChanged = false; }
 
   boolean sameAs(FFXSegment &target) { return startIdx==target.getStart() && endIdx==target.getEnd(); }
   boolean compareTag(const String &comp) { return tag==comp; }
+#ifdef FFX_INSTRUMENT
+  /*! Time spent in each stage of drawing this segment - see FFXRenderStats */
+  FFXRenderStats *getStats() { return &stats; }
+#endif
 private:
     String tag;
+    uint32_t tagHash = 0;
+    uint16_t handle = 0;
+    bool primary = false;
     uint16_t startIdx = 0;
     uint16_t endIdx = 0;
     FFXBase *effect = nullptr;
@@ -93,6 +143,10 @@ private:
     FFXOverlay *overlay = nullptr;
     FFXFrameProvider *ovlFP = nullptr;
     CRGB *ovlLeds = nullptr;
+    FFXSpan ovlSpan = FFXSpan();          // pixels (strip indexes) the overlay drew over - restored on the next update
+    boolean overlayDrawn = false;         // overlay was already drawn along with the frame this update
+    boolean wasVisible = false;
+    boolean redrawPending = true;
     // when removing dimmer - set the target to the target of the primary dimmer then make remove "pending" until new target is reached.
     boolean removeDimmerPending = false;
     FFXController *controller = nullptr;
@@ -101,7 +155,17 @@ private:
     boolean offWithPrimary = true;
     boolean forcedOff = false;
     uint8_t savedBrightness = 0;
+    boolean effectPaused = false;         // effect is not being updated (see isDark()/isVisible()) 
+    uint8_t coverState = 0xFF;            // visible/opaque/overlay as of the last update - see FFXCoverageMap
+#ifdef FFX_INSTRUMENT
+    FFXRenderStats stats = FFXRenderStats();
+#endif
     FFXSegment() {}
+    bool advanceOverlay();
+    void pauseEffect() { effectPaused = true; }
+    void resumeEffect();
+    FFXSpan drawUncovered( FFXCompositor &compositor, CRGB *frameBuffer, const FFXSpan &span );
+    void onPrimaryBrightness( uint8_t value );
 };
 
 #endif
\ No newline at end of file
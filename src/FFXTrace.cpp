@@ -0,0 +1,74 @@
+//
+//  FFXTrace.cpp
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#include "FFXTrace.h"
+
+FFXTraceEvent FFXTrace::events[FFX_TRACE_EVENTS];
+
+#ifdef FFX_HOST_BUILD
+
+std::atomic<uint32_t> FFXTrace::head( 0 );
+std::atomic<bool> FFXTrace::enabled( true );
+
+// clock() reading at a known time - the tick rate is worked out from the time since, when it is needed
+struct FFXTraceReference {
+  uint64_t ticks = FFXTrace::clock();
+  std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+};
+static FFXTraceReference traceReference = FFXTraceReference();
+
+double FFXTrace::getTicksPerMicro() {
+#ifdef FFX_TRACE_TSC
+  std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+  uint64_t ticks = clock();
+  double micros = std::chrono::duration<double, std::micro>( time - traceReference.time ).count();
+  return (micros > 0) ? (double)(ticks - traceReference.ticks) / micros : 1000.0;
+#else
+  return 1000.0;
+#endif
+}
+
+uint16_t FFXTrace::threadId() {
+  static std::atomic<uint16_t> nextId( 1 );
+  thread_local uint16_t id = nextId++;
+  return id;
+}
+
+uint32_t FFXTrace::writeChromeTrace( FILE *out ) {
+  uint32_t count = getEventCount();
+  // Times are written relative to the first event, so they stay small enough to print exactly
+  uint64_t base = count ? getEvent(0).start : 0;
+  for (uint32_t i = 1; i < count; i++) {
+    if (getEvent(i).start < base) { base = getEvent(i).start; }
+  }
+  double ticksPerMicro = getTicksPerMicro();
+  fprintf( out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n" );
+  for (uint32_t i = 0; i < count; i++) {
+    const FFXTraceEvent &event = getEvent(i);
+    double ts = (double)(event.start - base) / ticksPerMicro;
+    fprintf( out, "%s{\"name\":\"%s\",\"cat\":\"ffx\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,", (i ? ",\n" : ""), event.name, event.thread, ts );
+    if (event.duration != FFX_TRACE_INSTANT_EVENT) { fprintf( out, "\"ph\":\"X\",\"dur\":%.3f", (double)event.duration / ticksPerMicro ); }
+    else { fprintf( out, "\"ph\":\"i\",\"s\":\"t\"" ); }
+    if (event.arg != FFX_TRACE_NO_ARG) { fprintf( out, ",\"args\":{\"segment\":%u}", event.arg ); }
+    fprintf( out, "}" );
+  }
+  fprintf( out, "\n]}\n" );
+  return count;
+}
+
+bool FFXTrace::saveChromeTrace( const char *path ) {
+  FILE *out = fopen( path, "w" );
+  if (!out) { return false; }
+  writeChromeTrace( out );
+  return fclose( out ) == 0;
+}
+
+#else
+
+volatile uint32_t FFXTrace::head = 0;
+volatile bool FFXTrace::enabled = true;
+
+#endif
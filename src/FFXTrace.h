@@ -0,0 +1,138 @@
+//
+//  FFXTrace.h
+//
+//  Copyright 2020 - Geoff Moehrke
+//  gmoehrke@gmail.com
+//
+#ifndef FFX_TRACE_H
+#define FFX_TRACE_H
+
+#include <Arduino.h>
+#ifdef FFX_HOST_BUILD
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define FFX_TRACE_TSC
+#endif
+#endif
+
+#ifndef FFX_TRACE_EVENTS
+  #ifdef FFX_HOST_BUILD
+    #define FFX_TRACE_EVENTS 16384    // events kept in the ring buffer - must be a power of 2
+  #else
+    #define FFX_TRACE_EVENTS 128
+  #endif
+#endif
+#define FFX_TRACE_NO_ARG 0xFFFF
+#define FFX_TRACE_INSTANT_EVENT 0xFFFFFFFF      // duration recorded for an instant (FFX_TRACE_INSTANT) event
+
+/*!
+ *  FFXTrace - Timeline of the update loop, for finding frames that take too long and what else happened in them (an
+ *  overlay starting while a crossfade allocates its buffers, etc.).  Scoped events are placed around FFXController::update(),
+ *  FFXSegment::updateFrame()/updateOverlay(), FFXFrameProvider::updateFrame()/advance()/step(), the effect's 
+ *  writeNextFrame(), the pixel controller's show and buffer pool allocations, and instant events mark overlays starting and
+ *  completing and crossfade being turned on or off.  Each one records its name, start, duration and (for segment events) 
+ *  the segment handle in a fixed size ring buffer - the oldest events are overwritten once FFX_TRACE_EVENTS have been recorded.  Slots are
+ *  claimed with a single atomic increment on host builds, so events can be recorded from more than one thread without
+ *  locking.
+ *
+ *  The events are only compiled in when FFX_TRACE is defined (-DFFX_TRACE, or the FFX_TRACE option of the host CMake build)
+ *  - otherwise FFX_TRACE_SCOPE() and FFX_TRACE_INSTANT() are empty and nothing is recorded.
+ *
+ *  On host builds the buffer can be written out as Chrome trace JSON, to load into chrome://tracing or ui.perfetto.dev:
+ *
+ *  ```
+ *  FFXTrace::clear();
+ *  ...run...
+ *  FFXTrace::setEnabled( false );                   // stop recording before reading the buffer
+ *  FFXTrace::saveChromeTrace( "update.json" );
+ *  ```
+ */
+struct FFXTraceEvent {
+  const char *name = nullptr;         // string literal - not copied
+  uint64_t start = 0;                 // FFXTrace::clock() ticks
+  uint32_t duration = 0;              // ticks - FFX_TRACE_INSTANT_EVENT for an instant event
+  uint16_t arg = FFX_TRACE_NO_ARG;    // segment handle (or other small value)
+  uint16_t thread = 0;
+};
+
+class FFXTrace {
+  public:
+    /*! Time in ticks - the CPU time stamp counter on x86 host builds (converted to time when the trace is written out), 
+     *  nanoseconds on other host builds and micros() otherwise */
+#if defined(FFX_TRACE_TSC)
+    static uint64_t clock() { return __rdtsc(); }
+#elif defined(FFX_HOST_BUILD)
+    static uint64_t clock() { return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+#else
+    static uint64_t clock() { return micros(); }
+#endif
+    static void record( const char *name, uint64_t start, uint32_t duration, uint16_t arg = FFX_TRACE_NO_ARG ) {
+      if (!enabled) { return; }
+      FFXTraceEvent &event = events[(head++) & (FFX_TRACE_EVENTS-1)];
+      event.name = name;
+      event.start = start;
+      event.duration = duration;
+      event.arg = arg;
+      event.thread = threadId();
+    }
+    static void setEnabled( bool newValue ) { enabled = newValue; }
+    static bool isEnabled() { return enabled; }
+    static void clear() { head = 0; }
+    /*! Number of events in the buffer (at most FFX_TRACE_EVENTS) */
+    static uint32_t getEventCount() { uint32_t count = head; return (count > FFX_TRACE_EVENTS) ? FFX_TRACE_EVENTS : count; }
+    /*! Events recorded since clear(), including any that have been overwritten */
+    static uint32_t getTotalEvents() { return head; }
+    /*! i-th event in the buffer, oldest first */
+    static const FFXTraceEvent &getEvent( uint32_t i ) { uint32_t count = head; return events[(count - getEventCount() + i) & (FFX_TRACE_EVENTS-1)]; }
+#ifdef FFX_HOST_BUILD
+    /*! Write the buffer out as Chrome trace JSON (times in microseconds).  Returns the number of events written. */
+    static uint32_t writeChromeTrace( FILE *out );
+    static bool saveChromeTrace( const char *path );
+    /*! clock() ticks per microsecond */
+    static double getTicksPerMicro();
+#endif
+
+  private:
+    static FFXTraceEvent events[FFX_TRACE_EVENTS];
+#ifdef FFX_HOST_BUILD
+    static std::atomic<uint32_t> head;
+    static std::atomic<bool> enabled;
+    static uint16_t threadId();
+#else
+    static volatile uint32_t head;
+    static volatile bool enabled;
+    static uint16_t threadId() { return 0; }
+#endif
+};
+
+/*! Records an event from construction to the end of the enclosing scope */
+class FFXTraceScope {
+  public:
+    FFXTraceScope( const char *initName, uint16_t initArg = FFX_TRACE_NO_ARG ) : 
+      name(initName), arg(initArg), start(FFXTrace::isEnabled() ? FFXTrace::clock() : 0) { }
+    ~FFXTraceScope() { 
+      if (start) {
+        uint64_t duration = FFXTrace::clock() - start; 
+        FFXTrace::record( name, start, (duration < FFX_TRACE_INSTANT_EVENT) ? (uint32_t)duration : FFX_TRACE_INSTANT_EVENT-1, arg ); 
+      }
+    }
+  private:
+    const char *name;
+    uint16_t arg;
+    uint64_t start;
+};
+
+#define FFX_TRACE_CONCAT2( a, b ) a##b
+#define FFX_TRACE_CONCAT( a, b ) FFX_TRACE_CONCAT2( a, b )
+#ifdef FFX_TRACE
+  #define FFX_TRACE_SCOPE( ... ) FFXTraceScope FFX_TRACE_CONCAT( ffxTraceScope, __LINE__ )( __VA_ARGS__ )
+  #define FFX_TRACE_INSTANT( name, arg ) FFXTrace::record( (name), FFXTrace::clock(), FFX_TRACE_INSTANT_EVENT, (arg) )
+#else
+  #define FFX_TRACE_SCOPE( ... )
+  #define FFX_TRACE_INSTANT( name, arg )
+#endif
+
+#endif
@@ -0,0 +1,26 @@
+#include "FlexClock.h"
+
+static RealClock defaultClock;
+
+FlexClock *FlexClock::currClock = &defaultClock;
+
+void FlexClock::setClock( FlexClock *newClock ) {
+  currClock = (newClock ? newClock : &defaultClock);
+}
+
+void ScaledClock::setScale( uint16_t newScale ) {
+  // bring the accumulated time up to date at the old scale so time stays continuous
+  scaledMicros();
+  scale = newScale;
+}
+
+unsigned long long ScaledClock::scaledMicros() {
+  unsigned long curr = source->micros();
+  scaled256 += (unsigned long long)(curr - lastSource) * scale;
+  lastSource = curr;
+  return scaled256 / SCALE_1X;
+}
+
+#ifdef USE_GET_MILLISECOND_TIMER
+uint32_t get_millisecond_timer() { return FlexClock::now(); }
+#endif
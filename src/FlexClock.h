@@ -0,0 +1,98 @@
+/*
+ *    FlexClock.h - Pluggable time source for the FlexTimer classes.
+ *
+ *                  StepTimer/FlexTimer (and everything built on them) read the current time through GET_TIME_MILLIS, which
+ *                  calls the currently installed FlexClock.  By default this is RealClock, which simply returns millis()/micros().
+ *                  Install a different clock to run timers against something other than wall time:
+ *
+ *                  VirtualClock - Time only moves when advance() is called.  Used for deterministic and faster-than-real-time
+ *                                 rendering, benchmarking and soak tests.
+ *
+ *                  VirtualClock vclock;
+ *                  FlexClock::setClock( &vclock );
+ *                  ...
+ *                  while (rendering) {
+ *                    controller.update();
+ *                    vclock.advance( 1 );    // one millisecond passes - no waiting on real time
+ *                  }
+ *                  FlexClock::setClock( nullptr );   // back to real time
+ *
+ *                  ScaledClock  - Runs another clock faster or slower by a fixed point scale (256 = 1x, 512 = 2x, 128 = 0.5x).
+ *
+ *                  The clock is global - every timer shares it.  The caller owns the clock object and must keep it alive while
+ *                  it is installed.
+ *
+ *                  If USE_GET_MILLISECOND_TIMER is defined (FastLED's hook for replacing millis() in its beat/timing functions),
+ *                  FlexClock.cpp provides get_millisecond_timer() so FastLED's beatsin8() etc. follow the same clock.
+ */
+#ifndef FLEX_CLOCK_H
+#define FLEX_CLOCK_H
+
+#include <Arduino.h>
+
+class FlexClock {
+  public:
+    virtual ~FlexClock() {}
+    virtual unsigned long millis() = 0;
+    virtual unsigned long micros() = 0;
+
+    static FlexClock *getClock() { return currClock; }
+    static void setClock( FlexClock *newClock );
+    static unsigned long now() { return currClock->millis(); }
+    static unsigned long nowMicros() { return currClock->micros(); }
+
+  private:
+    static FlexClock *currClock;
+};
+
+class RealClock : public FlexClock {
+  public:
+    virtual unsigned long millis() override { return ::millis(); }
+    virtual unsigned long micros() override { return ::micros(); }
+};
+
+class VirtualClock : public FlexClock {
+  public:
+    // Starts at 1 second - StepTimer treats a start time of 0 as "not started"
+    VirtualClock() : VirtualClock( 1000UL ) {}
+    VirtualClock( unsigned long initMillis ) { setMillis( initMillis ); }
+
+    virtual unsigned long millis() override { return (unsigned long)(currMicros / 1000ULL); }
+    virtual unsigned long micros() override { return (unsigned long)currMicros; }
+
+    void advance( unsigned long ms ) { currMicros += (unsigned long long)ms * 1000ULL; }
+    void advanceMicros( unsigned long us ) { currMicros += us; }
+    void setMillis( unsigned long ms ) { currMicros = (unsigned long long)ms * 1000ULL; }
+    void setMicros( unsigned long long us ) { currMicros = us; }
+    unsigned long long getMicros64() { return currMicros; }
+
+  private:
+    unsigned long long currMicros = 0;
+};
+
+class ScaledClock : public FlexClock {
+  public:
+    static const uint16_t SCALE_1X = 256;
+
+    ScaledClock( FlexClock *initSource, uint16_t initScale ) : source(initSource), scale(initScale) { 
+      lastSource = source->micros();
+      scaled256 = (unsigned long long)lastSource * SCALE_1X;
+    }
+    ScaledClock( uint16_t initScale ) : ScaledClock( FlexClock::getClock(), initScale ) {}
+
+    virtual unsigned long millis() override { return (unsigned long)(scaledMicros() / 1000ULL); }
+    virtual unsigned long micros() override { return (unsigned long)scaledMicros(); }
+
+    uint16_t getScale() { return scale; }
+    void setScale( uint16_t newScale );
+
+  private:
+    unsigned long long scaledMicros();
+
+    FlexClock *source;
+    uint16_t scale = SCALE_1X;
+    unsigned long lastSource = 0;                         // source micros() at the last read
+    unsigned long long scaled256 = 0;                     // scaled time in 1/256 us - accumulated per read so source wrap doesn't matter
+};
+
+#endif
@@ -10,49 +10,76 @@
 
 long fixed_map(long x, long in_min, long in_max, long out_min, long out_max) { if ((in_max - in_min) > (out_max - out_min)) { return (x - in_min) * (out_max - out_min+1) / (in_max - in_min+1) + out_min; } else { return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min; } }
 
-void StepTimer::start(unsigned long currMillis) { 
-      started = currMillis;
-      nextUpMillis = addOffsetWithWrap(currMillis, interval); 
-      if (nextUpMillis < currMillis) { rollovers++; }
-      onStart( currMillis );
+// Same as fixed_map() for mapping a time (in ticks) onto a small output range - uses 64 bit intermediates so long intervals in micros don't overflow
+long fixed_map_ticks(unsigned long x, unsigned long in_min, unsigned long in_max, long out_min, long out_max) {
+  long long inRange = (long long)in_max - (long long)in_min;
+  long long outRange = (long long)out_max - (long long)out_min;
+  long long offset = (long long)x - (long long)in_min;
+  if (inRange > outRange) { return (long)(offset * (outRange+1) / (inRange+1) + out_min); }
+  else if (inRange == 0) { return out_max; }
+  else { return (long)(offset * outRange / inRange + out_min); }
+}
+
+// Ticks from x until fixed_map_ticks() first reaches target (moving from out_min towards out_max) - 0 if it already has, 
+// in_max-x if it doesn't before in_max.  Used to work out when a timed fade next changes.
+unsigned long fixed_map_ticks_until(unsigned long x, unsigned long in_min, unsigned long in_max, long out_min, long out_max, long target) {
+  bool up = (out_max >= out_min);
+  if (x >= in_max) { return 0; }
+  long at = fixed_map_ticks( x, in_min, in_max, out_min, out_max );
+  if (up ? (at >= target) : (at <= target)) { return 0; }
+  unsigned long lo = x;
+  unsigned long hi = in_max;
+  while (hi - lo > 1) {
+    unsigned long mid = lo + (hi - lo) / 2;
+    long v = fixed_map_ticks( mid, in_min, in_max, out_min, out_max );
+    if (up ? (v >= target) : (v <= target)) { hi = mid; } else { lo = mid; }
+  }
+  return hi - x;
+}
+
+void StepTimer::start(unsigned long currTicks) { 
+      started = currTicks;
+      nextUpTicks = addOffsetWithWrap(currTicks, interval); 
+      if (nextUpTicks < currTicks) { rollovers++; }
+      onStart( currTicks );
     }
 
 void StepTimer::start() { 
-  start(GET_TIME_MILLIS); 
+  start(GET_TIME_TICKS); 
 }
 
 void StepTimer::step() { 
-  step(GET_TIME_MILLIS); 
+  step(GET_TIME_TICKS); 
 }
 
-void StepTimer::step(unsigned long currMillis) {
+void StepTimer::step(unsigned long currTicks) {
       if (pendInterval) {
         interval = pendInterval;
         pendInterval = 0;
       }
       if (started) {
-        nextUpMillis = addOffsetWithWrap(currMillis, interval);
-        if (nextUpMillis < currMillis) { rollovers++; }
-        onStep(currMillis);
+        nextUpTicks = addOffsetWithWrap(currTicks, interval);
+        if (nextUpTicks < currTicks) { rollovers++; }
+        onStep(currTicks);
       }
     }    
 
-void StepTimer::setInterval( unsigned long newInterval ) {
-  if (newInterval != interval) {
+void StepTimer::setIntervalTicks( unsigned long newTicks ) {
+  if (newTicks != interval) {
     if (started) { 
-      pendInterval = newInterval;
+      pendInterval = newTicks;
     }
     else {
-      interval = newInterval;
+      interval = newTicks;
     }
   }
 }
 
-void StepTimer::setIntervalImmediate(unsigned long newInterval) { 
-  if (newInterval != interval) {
-    interval = newInterval;   
+void StepTimer::setIntervalImmediateTicks(unsigned long newTicks) { 
+  if (newTicks != interval) {
+    interval = newTicks;   
     //unsigned long lastup = getLastUp();
-    //if (isStarted() && lastup+interval < nextUpMillis) { nextUpMillis = (lastup+interval>GET_TIME_MILLIS ? GET_TIME_MILLIS : lastup+interval); } 
+    //if (isStarted() && lastup+interval < nextUpTicks) { nextUpTicks = (lastup+interval>GET_TIME_TICKS ? GET_TIME_TICKS : lastup+interval); } 
     step();
   }
 }    
@@ -65,18 +92,20 @@ void FlexTimer::setRange( unsigned long minInterval, unsigned long maxInterval )
       rangeMax = maxInterval;
 }
   
-void FlexTimer::onStart(unsigned long currMillis) {
-  lastUpMillis = currMillis;
-  nextUpMillis= addOffsetWithWrap(currMillis, (startExpired ? 0 : interval) );
-  if (nextUpMillis < currMillis) { rollovers++; }
+void FlexTimer::onStart(unsigned long currTicks) {
+  lastUpTicks = currTicks;
+  nextUpTicks= addOffsetWithWrap(currTicks, (startExpired ? 0 : interval) );
+  if (nextUpTicks < currTicks) { rollovers++; }
 }
 
-void FlexTimer::onStep(unsigned long currMillis) {
-  lastUpMillis = currMillis;  
+void FlexTimer::onStep(unsigned long currTicks) {
+  lastUpTicks = currTicks;  
   currDelta = 0;
   stepCount = addOffsetWithWrap(stepCount, 1);
 }
 
-void FlexTimer::setInterval( unsigned long newInterval) {
-   StepTimer::setInterval(newInterval < rangeMin ? rangeMin : (newInterval > rangeMax ? rangeMax : newInterval)); 
+void FlexTimer::setIntervalTicks( unsigned long newTicks ) {
+   unsigned long minTicks = MS_TO_TICKS(rangeMin);
+   unsigned long maxTicks = MS_TO_TICKS(rangeMax);
+   StepTimer::setIntervalTicks(newTicks < minTicks ? minTicks : (newTicks > maxTicks ? maxTicks : newTicks)); 
 }
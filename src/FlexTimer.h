@@ -39,10 +39,35 @@
 
 #include <Arduino.h>
 #include <limits.h>
+#include "FlexClock.h"
 
 long fixed_map( long, long, long, long, long);
+long fixed_map_ticks( unsigned long, unsigned long, unsigned long, long, long );
+unsigned long fixed_map_ticks_until( unsigned long, unsigned long, unsigned long, long, long, long );
 
-#define GET_TIME_MILLIS millis()
+/*
+ *  Time base - by default timers count in milliseconds.  Define FLEX_TIMER_MICROS (before including FlexTimer.h, or as a 
+ *  build flag) to have every timer count in microseconds instead.  The public interface stays in milliseconds (setInterval(),
+ *  getInterval(), timeRemaining(), etc.), so existing code is unaffected - but intervals set with setIntervalMicros() and 
+ *  the *Ticks() accessors can then be used for sub-millisecond pacing, and speed settings map to finer intervals.
+ *  
+ *  Methods that take an explicit time argument (isUp(t), start(t), step(t), ...) expect it in ticks - GET_TIME_TICKS.
+ *  
+ *  Note that on 32 bit boards micros() rolls over every ~71 minutes.  Deadlines are compared by their signed difference from
+ *  the current time, so a timer keeps running across the rollover - as long as it isn't left up for more than half of that.
+ */
+#ifdef FLEX_TIMER_MICROS
+#define FLEX_TICKS_PER_MS 1000UL
+#define GET_TIME_TICKS FlexClock::nowMicros()
+#else
+#define FLEX_TICKS_PER_MS 1UL
+#define GET_TIME_TICKS FlexClock::now()
+#endif
+#define MS_TO_TICKS(ms) ((unsigned long)(ms)*FLEX_TICKS_PER_MS)
+#define TICKS_TO_MS(t) ((unsigned long)(t)/FLEX_TICKS_PER_MS)
+#define US_TO_TICKS(us) (FLEX_TICKS_PER_MS==1 ? ((unsigned long)(us)+500UL)/1000UL : (unsigned long)(us))
+
+#define GET_TIME_MILLIS FlexClock::now()
 #define GET_TIME_MILLIS_ABS millis()
 
 class StepTimer {
@@ -66,34 +91,40 @@ class StepTimer {
     virtual ~StepTimer() {}
 
     void start();
-    void start(unsigned long currMillis);
-    virtual void onStart(unsigned long currMillis) {}
+    void start(unsigned long currTicks);
+    virtual void onStart(unsigned long currTicks) {}
 
     void step();
-    void step(unsigned long currMillis);
-    virtual void onStep(unsigned long currMillis) {}
+    void step(unsigned long currTicks);
+    virtual void onStep(unsigned long currTicks) {}
 
     void stop() { started=0; }
     bool isStarted() { return (started > 0); }
-    bool isUp(unsigned long currMillis) { return ((started > 0) && (currMillis >= nextUpMillis)); }
-    bool isUp() { return isUp(GET_TIME_MILLIS); }
-    unsigned long nextUp() { return nextUpMillis; }
-    unsigned long timeRemaining(unsigned long currMillis) { return (currMillis>=nextUpMillis ? 0 : nextUpMillis-currMillis); }
-    unsigned long timeRemaining() { return timeRemaining(GET_TIME_MILLIS); }
+    bool isUp(unsigned long currTicks) { return ((started > 0) && ((long)(currTicks - nextUpTicks) >= 0)); }
+    bool isUp() { return isUp(GET_TIME_TICKS); }
+    unsigned long nextUp() { return nextUpTicks; }                                                                    // in ticks
+    unsigned long timeRemaining(unsigned long currTicks) { return ((long)(currTicks - nextUpTicks) >= 0 ? 0 : nextUpTicks-currTicks); }
+    unsigned long timeRemainingTicks() { return timeRemaining(GET_TIME_TICKS); }
+    unsigned long timeRemaining() { return TICKS_TO_MS(timeRemainingTicks()); }
     unsigned long getRollovers() { return rollovers; }                                                               // Number if times the timer has rolled over (crossed the 49 day mark...)
-    unsigned long timeSinceStarted(unsigned long currMillis) { return ((started>0) ? (currMillis > started ? (currMillis - started) : 0) : 0); } 
-    unsigned long timeSinceStarted() { return timeSinceStarted(GET_TIME_MILLIS); }  
-    unsigned long timeSinceTriggered(unsigned long currMillis) { return ((started>0) ? currMillis-(getLastUp()) : 0 ); }
-    unsigned long timeSinceTriggered() { return timeSinceTriggered( GET_TIME_MILLIS ); }  
-    virtual unsigned long getLastUp() { return (nextUpMillis-interval); }
-    virtual void setInterval(unsigned long newInterval);
-    virtual void setIntervalImmediate( unsigned long newInterval );
-    unsigned long getInterval() { return ( (pendInterval>0) ? pendInterval : interval); }
+    unsigned long timeSinceStarted(unsigned long currTicks) { return ((started>0) ? (currTicks > started ? (currTicks - started) : 0) : 0); } 
+    unsigned long timeSinceStarted() { return TICKS_TO_MS(timeSinceStarted(GET_TIME_TICKS)); }  
+    unsigned long timeSinceTriggered(unsigned long currTicks) { return ((started>0) ? currTicks-(getLastUp()) : 0 ); }
+    unsigned long timeSinceTriggeredTicks() { return timeSinceTriggered( GET_TIME_TICKS ); }  
+    unsigned long timeSinceTriggered() { return TICKS_TO_MS(timeSinceTriggeredTicks()); }  
+    virtual unsigned long getLastUp() { return (nextUpTicks-interval); }                                             // in ticks
+    void setInterval(unsigned long newInterval) { setIntervalTicks( MS_TO_TICKS(newInterval) ); }
+    void setIntervalMicros(unsigned long newMicros) { setIntervalTicks( US_TO_TICKS(newMicros) ); }
+    virtual void setIntervalTicks(unsigned long newTicks);
+    void setIntervalImmediate( unsigned long newInterval ) { setIntervalImmediateTicks( MS_TO_TICKS(newInterval) ); }
+    virtual void setIntervalImmediateTicks( unsigned long newTicks );
+    unsigned long getIntervalTicks() { return ( (pendInterval>0) ? pendInterval : interval); }
+    unsigned long getInterval() { return TICKS_TO_MS(getIntervalTicks()); }
 
   protected:         
-    unsigned long interval=DEFAULT_TIMER_INTERVAL;        // in milliseconds
-    unsigned long started=0;                              // if started - this is the millis() instant the timer was last started
-    unsigned long nextUpMillis=0;                         // while running - this is the next time the timer will become "up"
+    unsigned long interval=MS_TO_TICKS(DEFAULT_TIMER_INTERVAL);      // in ticks
+    unsigned long started=0;                              // if started - this is the instant (in ticks) the timer was last started
+    unsigned long nextUpTicks=0;                          // while running - this is the next time the timer will become "up"
                                                           // Note the timer may be up for any arbitrary length of time before it is reset by calling step() 
     uint16_t rollovers = 0;                                                         
     unsigned long pendInterval = 0;
@@ -113,28 +144,32 @@ class FlexTimer : public StepTimer {
 
     FlexTimer( unsigned long minInterval, unsigned long maxInterval, bool initStart, uint8_t initSpeed ) : FlexTimer( minInterval, maxInterval, speedToInterval(initSpeed, minInterval, maxInterval), initStart ) { }
     
-    virtual void onStart(unsigned long currMillis) override;
-    virtual void onStep(unsigned long currMillis) override;
+    virtual void onStart(unsigned long currTicks) override;
+    virtual void onStep(unsigned long currTicks) override;
     
     void setStartExpired( boolean newVal ) { startExpired = newVal; }
     boolean getStartExpired() { return startExpired; }
     unsigned long getRangeMin() { return rangeMin; }
     unsigned long getRangeMax() { return rangeMax; }
     void setRange( unsigned long minInterval, unsigned long maxInterval ); 
-    virtual void setSpeed( uint8_t newSpeed ) { setInterval( speedToInterval( newSpeed, rangeMin, rangeMax ) ); }
-    virtual uint8_t getSpeed() { return intervalToSpeed( getInterval(), rangeMin, rangeMax );  }
-    void addDelta( long delta ) { currDelta = delta; nextUpMillis += currDelta; }
-    virtual unsigned long getLastUp() override { return lastUpMillis; }
-    virtual void setInterval( unsigned long newInterval ) override;
-    unsigned long getCurrInterval() { return interval+currDelta; }
+    // speed is mapped over the range in ticks, so in micros mode each speed step is a distinct interval even on short ranges
+    virtual void setSpeed( uint8_t newSpeed ) { setIntervalTicks( speedToInterval( newSpeed, MS_TO_TICKS(rangeMin), MS_TO_TICKS(rangeMax) ) ); }
+    virtual uint8_t getSpeed() { return intervalToSpeed( getIntervalTicks(), MS_TO_TICKS(rangeMin), MS_TO_TICKS(rangeMax) );  }
+    void addDelta( long delta ) { currDelta = delta*(long)FLEX_TICKS_PER_MS; nextUpTicks += currDelta; }
+    virtual unsigned long getLastUp() override { return lastUpTicks; }
+    virtual void setIntervalTicks( unsigned long newTicks ) override;
+    unsigned long getCurrIntervalTicks() { return interval+currDelta; }
+    unsigned long getCurrInterval() { return TICKS_TO_MS(getCurrIntervalTicks()); }
     unsigned long getSteps() { return stepCount; }    
+    /*! Date the last step back to currTicks (a step that was due then, but taken late) - the next one is due an interval after it */
+    void setLastUp( unsigned long currTicks ) { lastUpTicks = currTicks; nextUpTicks = addOffsetWithWrap( currTicks, interval+currDelta ); }
   
   private:
-    unsigned long rangeMin = MIN_INTERVAL;
+    unsigned long rangeMin = MIN_INTERVAL;                // range limits are in ms
     unsigned long rangeMax = MAX_INTERVAL; 
-    unsigned long lastUpMillis=0;                         // if started - the instant the timer was last reset - by calling step()
+    unsigned long lastUpTicks=0;                          // if started - the instant the timer was last reset - by calling step()
     unsigned long stepCount = 0;                          // The number of times the trigger has been reset by calling step()
-    unsigned long currDelta = 0;                          // Can adjust a step while it is occuring by setting a delta value to be added to the interval - delaying the triger by currDelta ms.
+    unsigned long currDelta = 0;                          // Can adjust a step while it is occuring by setting a delta value to be added to the interval - delaying the triger by currDelta ticks.
     boolean startExpired = false;                         // Set to true to start timer in the "Up" state - isUp() will return true immediately until step() is called
 };  
 